@@ -50,6 +50,10 @@ int config(ma::MediaServerApi::Config& _config,
             _config.enable_gop_ = (std::string(s1) == "on");
           }
 
+          if (config_setting_lookup_int(sub_item, "gop_duration", &i1)) {
+            _config.gop_duration_ = i1;
+          }
+
           if (config_setting_lookup_string(sub_item, "flv_record", &s1)) {
             _config.flv_record_ = (std::string(s1) == "on");
           }
@@ -73,14 +77,54 @@ int config(ma::MediaServerApi::Config& _config,
           if (config_setting_lookup_string(sub_item, "mix_correct", &s1)) {
             _config.mix_correct_ = (std::string(s1) == "on");
           }
+
+          if (config_setting_lookup_int(sub_item, "mw_sleep", &i1)) {
+            _config.mw_sleep_ms_ = i1;
+          }
+
+          if (config_setting_lookup_int(sub_item, "mw_msgs", &i1)) {
+            _config.mw_msgs_ = i1;
+          }
+
+          if (config_setting_lookup_int(sub_item, "bp_high", &i1)) {
+            _config.bp_high_ms_ = i1;
+          }
+
+          if (config_setting_lookup_int(sub_item, "bp_low", &i1)) {
+            _config.bp_low_ms_ = i1;
+          }
+
+          if (config_setting_lookup_int(sub_item, "bp_timeout", &i1)) {
+            _config.bp_timeout_ms_ = i1;
+          }
+
+          if (config_setting_lookup_int(sub_item, "relay_threshold", &i1)) {
+            _config.relay_threshold_ = i1;
+          }
+
+          if (config_setting_lookup_int(sub_item, "rebalance", &i1)) {
+            _config.rebalance_sec_ = i1;
+          }
+
+          if (config_setting_lookup_string(sub_item, "task_queue", &s1)) {
+            _config.mpsc_task_queue_ = (std::string(s1) == "mpsc");
+          }
           
-          MIA_LOG("gop:%s flv:%s worker:%d ioworker:%d len:%d al:%d correct:%s", 
+          MIA_LOG("gop:%s gop_duration:%d flv:%s worker:%d ioworker:%d len:%d al:%d correct:%s "
+                  "mw_sleep:%d mw_msgs:%d bp:%d/%d/%d relay:%d rebalance:%d "
+                  "task_queue:%s", 
                   _config.enable_gop_?"on":"off", 
+                  _config.gop_duration_,
                   _config.flv_record_?"on":"off",
                   _config.workers_, _config.ioworkers_, 
                   _config.consumer_queue_size_,
                   (int)_config.jitter_algo_,
-                  _config.mix_correct_?"on":"off");
+                  _config.mix_correct_?"on":"off",
+                  _config.mw_sleep_ms_, _config.mw_msgs_,
+                  _config.bp_high_ms_, _config.bp_low_ms_, 
+                  _config.bp_timeout_ms_, _config.relay_threshold_,
+                  _config.rebalance_sec_,
+                  _config.mpsc_task_queue_?"mpsc":"libevent");
           continue;
         }
 
@@ -94,12 +138,21 @@ int config(ma::MediaServerApi::Config& _config,
           if (config_setting_lookup_int(sub_item, "stun_port", &i1)) {
             _config.stun_port = i1;
           }
+          if (config_setting_lookup_string(sub_item, "single_port", &s1)) {
+            _config.rtc_single_port = (std::string(s1) == "on");
+          }
+          if (config_setting_lookup_string(sub_item, "forward_rtp", &s1)) {
+            _config.rtc_forward_rtp = (std::string(s1) == "on");
+          }
 
           bool is_can_empty = _config.candidates_.empty();
-          MIA_LOG("workers:%d candidates:%s stun_port:%d", 
+          MIA_LOG("workers:%d candidates:%s stun_port:%d single_port:%s "
+                  "forward_rtp:%s", 
                   _config.rtc_workers_, 
                   is_can_empty?"*":_config.candidates_[0].c_str(), 
-                  _config.stun_port);
+                  _config.stun_port,
+                  _config.rtc_single_port?"on":"off",
+                  _config.rtc_forward_rtp?"on":"off");
           continue;
         }
 
@@ -124,16 +177,24 @@ int config(ma::MediaServerApi::Config& _config,
           if (config_setting_lookup_string(sub_item, "hostname", &s1)) {
             _config.https_hostname = s1;
           }
+          if (config_setting_lookup_string(sub_item, "ktls", &s1)) {
+            _config.https_ktls = (std::string(s1) == "on");
+          }
+          if (config_setting_lookup_string(sub_item, "io_uring", &s1)) {
+            _config.http_io_uring = (std::string(s1) == "on");
+          }
           std::string addrs;
           for(const auto& x :  _config.listen_addr_) {
             addrs.append(x);
             addrs.append(" ");
           }
-          MIA_LOG("addrs:%s key:%s cert:%s host:%s", 
+          MIA_LOG("addrs:%s key:%s cert:%s host:%s ktls:%s io_uring:%s", 
                   addrs.c_str(), 
                   _config.https_key.c_str(),
                   _config.https_crt.c_str(),
-                  _config.https_hostname.c_str());
+                  _config.https_hostname.c_str(),
+                  _config.https_ktls?"on":"off",
+                  _config.http_io_uring?"on":"off");
           continue;
         }
 
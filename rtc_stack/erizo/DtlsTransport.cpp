@@ -11,6 +11,7 @@
 #include "erizo/SrtpChannel.h"
 #include "erizo/rtp/RtpHeaders.h"
 #include "erizo/LibNiceConnection.h"
+#include "erizo/IceLiteConnection.h"
 
 using erizo::TimeoutChecker;
 using erizo::DtlsTransport;
@@ -150,8 +151,12 @@ DtlsTransport::DtlsTransport(
   iceConfig_.username = username;
   iceConfig_.password = password;
   
-  // We only use libnice connection
-  ice_.reset(LibNiceConnection::create(iceConfig_, io_worker));
+  // the shared port if listened, libnice otherwise
+  if (IceLiteMux* mux = IceLiteMux::get()) {
+    ice_.reset(new IceLiteConnection(mux, iceConfig_));
+  } else {
+    ice_.reset(LibNiceConnection::create(iceConfig_, io_worker));
+  }
   rtp_timeout_checker_ = std::move(std::make_unique<TimeoutChecker>(this, dtlsRtp.get()));
   if (!rtcp_mux) {
     rtcp_timeout_checker_ = std::move(std::make_unique<TimeoutChecker>(this, dtlsRtcp.get()));
@@ -0,0 +1,700 @@
+//
+// Copyright (c) 2021- anjisuan783
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "erizo/IceLiteConnection.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/udp.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <glib-unix.h>
+
+#include "network/stun.h"
+#include "rtc_base/byte_buffer.h"
+#include "rtc_base/byte_order.h"
+#include "rtc_base/helpers.h"
+#include "rtc_base/socket_address.h"
+#include "erizo/SdpInfo.h"
+#include "utils/Worker.h"
+
+namespace erizo {
+
+DEFINE_LOGGER(IceLiteMux, "IceLiteMux")
+DEFINE_LOGGER(IceLiteConnection, "IceLiteConnection")
+
+std::unique_ptr<IceLiteMux> IceLiteMux::instance_;
+
+namespace {
+
+// RFC 8445 5.1.2.1, type preference 126 of host, local preference 65535.
+constexpr uint32_t kHostPriority = 2130706431;
+constexpr int kUfragLength = 8;
+constexpr int kPasswordLength = 24;
+// the recvmmsg calls by one event, not to starve the others of the worker.
+constexpr int kMaxReadsPerEvent = 4;
+// the packets sent by one flush at most.
+constexpr int kSendBatch = 64;
+// the limits of one UDP_SEGMENT send.
+constexpr int kMaxSegments = 64;
+constexpr int kMaxSegmentBytes = 64000;
+constexpr int kReportSeconds = 60;
+// the packets read not larger are copied to a smaller buffer, the others
+// are handed over as read.
+constexpr int kCopyBelow = 512;
+// the socket is shared by thousands of peers.
+constexpr int kSocketBufferSize = 4 * 1024 * 1024;
+
+// RFC 5389 6, the first two bits are zero, and the magic cookie follows.
+bool isStun(const char* buf, int len) {
+  return len >= (int)cricket::kStunHeaderSize && (buf[0] & 0xC0) == 0 &&
+      rtc::GetBE32(buf + 4) == cricket::kStunMagicCookie;
+}
+
+}  // namespace
+
+// The packets sent by a task of a worker, sent on the end of the task by
+// one sendmmsg for each socket, and the ones of a peer in a row by one
+// UDP_SEGMENT message if supported. Copied, the callers reuse the buffer.
+class UdpSendBatch final {
+  DECLARE_LOGGER();
+
+ public:
+  static UdpSendBatch& current() {
+    static thread_local UdpSendBatch batch;
+    return batch;
+  }
+
+  // Returns false if not in a task, to be sent now.
+  bool add(IceLiteMux* mux, int fd, const sockaddr_in& to,
+           const void* buf, int len);
+  void flush();
+
+ private:
+  struct Packet {
+    int fd;
+    sockaddr_in to;
+    size_t offset;
+    int len;
+  };
+
+  // the packets from |begin| to the same peer by one segmented message.
+  int segments(size_t begin, size_t end);
+  void send(int fd, int count);
+
+  IceLiteMux* mux_{nullptr};
+  bool scheduled_{false};
+  std::vector<Packet> packets_;
+  std::vector<char> data_;
+
+  std::vector<mmsghdr> msgs_;
+  std::vector<iovec> iovs_;
+  // the first packet and the count of each message.
+  std::vector<std::pair<size_t, int>> spans_;
+  std::vector<char> cmsgs_;
+};
+
+DEFINE_LOGGER(UdpSendBatch, "UdpSendBatch")
+
+bool UdpSendBatch::add(IceLiteMux* mux, int fd, const sockaddr_in& to,
+                       const void* buf, int len) {
+  if (!scheduled_) {
+    if (!wa::Worker::atTaskEnd([this]() {
+          scheduled_ = false;
+          flush();
+        })) {
+      return false;
+    }
+    scheduled_ = true;
+  }
+
+  mux_ = mux;
+  size_t offset = data_.size();
+  data_.insert(data_.end(), (const char*)buf, (const char*)buf + len);
+  packets_.push_back(Packet{fd, to, offset, len});
+  if (packets_.size() == kSendBatch) {
+    // the ones after are sent on the end of the task still.
+    flush();
+  }
+  return true;
+}
+
+int UdpSendBatch::segments(size_t begin, size_t end) {
+  if (!mux_->gso_.load(std::memory_order_relaxed)) {
+    return 1;
+  }
+  // all the segments have the size of the first, but the last one.
+  const Packet& first = packets_[begin];
+  int count = 1;
+  int bytes = first.len;
+  for (size_t i = begin + 1; i < end && count < kMaxSegments; ++i) {
+    const Packet& p = packets_[i];
+    if (p.fd != first.fd || p.len > first.len ||
+        bytes + p.len > kMaxSegmentBytes ||
+        p.to.sin_port != first.to.sin_port ||
+        p.to.sin_addr.s_addr != first.to.sin_addr.s_addr) {
+      break;
+    }
+    ++count;
+    bytes += p.len;
+    if (p.len < first.len) {
+      break;
+    }
+  }
+  return count;
+}
+
+void UdpSendBatch::flush() {
+  if (packets_.empty()) {
+    return;
+  }
+
+  size_t n = packets_.size();
+  msgs_.resize(n);
+  iovs_.resize(n);
+  spans_.resize(n);
+  cmsgs_.assign(n * CMSG_SPACE(sizeof(uint16_t)), 0);
+
+  for (size_t i = 0; i < n; ++i) {
+    iovs_[i].iov_base = data_.data() + packets_[i].offset;
+    iovs_[i].iov_len = packets_[i].len;
+  }
+
+  // the packets of a socket are in a row mostly, a peer is sent by one.
+  size_t begin = 0;
+  while (begin < n) {
+    int fd = packets_[begin].fd;
+    int count = 0;
+    size_t i = begin;
+    for (; i < n && packets_[i].fd == fd; ) {
+      int segs = segments(i, n);
+      mmsghdr& m = msgs_[count];
+      memset(&m, 0, sizeof(m));
+      m.msg_hdr.msg_name = &packets_[i].to;
+      m.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+      m.msg_hdr.msg_iov = &iovs_[i];
+      m.msg_hdr.msg_iovlen = segs;
+#ifdef UDP_SEGMENT
+      if (segs > 1) {
+        char* control = &cmsgs_[count * CMSG_SPACE(sizeof(uint16_t))];
+        m.msg_hdr.msg_control = control;
+        m.msg_hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+        cmsghdr* cm = CMSG_FIRSTHDR(&m.msg_hdr);
+        cm->cmsg_level = SOL_UDP;
+        cm->cmsg_type = UDP_SEGMENT;
+        cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        uint16_t size = packets_[i].len;
+        memcpy(CMSG_DATA(cm), &size, sizeof(size));
+      }
+#endif
+      spans_[count] = std::make_pair(i, segs);
+      ++count;
+      i += segs;
+    }
+    send(fd, count);
+    begin = i;
+  }
+
+  mux_->tx_packets_.fetch_add(n, std::memory_order_relaxed);
+  packets_.clear();
+  data_.clear();
+}
+
+void UdpSendBatch::send(int fd, int count) {
+  int done = 0;
+  while (done < count) {
+    int ret = ::sendmmsg(fd, &msgs_[done], count - done, 0);
+    mux_->tx_calls_.fetch_add(1, std::memory_order_relaxed);
+    if (ret > 0) {
+      done += ret;
+      continue;
+    }
+    if (ret == 0) {
+      return;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      // dropped like a full queue of the way.
+      return;
+    }
+
+    // the message failed, the segmented one by the device maybe.
+    auto& span = spans_[done];
+    if (span.second > 1 && (errno == EIO || errno == EINVAL)) {
+      ELOG_WARN("ice-lite udp gso failed, errno:%d, disabled", errno);
+      mux_->gso_ = false;
+      for (int i = 0; i < span.second; ++i) {
+        const Packet& p = packets_[span.first + i];
+        ::sendto(fd, data_.data() + p.offset, p.len, 0,
+                 (const sockaddr*)&p.to, sizeof(p.to));
+      }
+      mux_->tx_calls_.fetch_add(span.second, std::memory_order_relaxed);
+    }
+    ++done;
+  }
+}
+
+bool IceLiteMux::start(const std::string& ip, uint16_t port,
+    const std::vector<std::shared_ptr<wa::IOWorker>>& workers) {
+  if (instance_) {
+    return true;
+  }
+
+  std::unique_ptr<IceLiteMux> mux(new IceLiteMux(port));
+  for (auto& worker : workers) {
+    if (!mux->listen(ip, worker.get())) {
+      return false;
+    }
+  }
+  if (!workers.empty()) {
+    mux->report_ = g_timeout_source_new_seconds(kReportSeconds);
+    g_source_set_callback(mux->report_, onReport, mux.get(), nullptr);
+    g_source_attach(mux->report_, workers[0]->getMainContext());
+  }
+  ELOG_INFO("ice-lite listen %s:%u, sockets:%lu, gso:%d",
+            ip.c_str(), port, workers.size(), (int)mux->gso_);
+  instance_ = std::move(mux);
+  return true;
+}
+
+void IceLiteMux::stop() {
+  instance_.reset();
+}
+
+IceLiteMux* IceLiteMux::get() {
+  return instance_.get();
+}
+
+IceLiteMux::~IceLiteMux() {
+  if (report_) {
+    g_source_destroy(report_);
+    g_source_unref(report_);
+  }
+  for (auto& s : sockets_) {
+    if (s->source) {
+      g_source_destroy(s->source);
+      g_source_unref(s->source);
+    }
+    ::close(s->fd);
+  }
+}
+
+bool IceLiteMux::listen(const std::string& ip, wa::IOWorker* worker) {
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port_);
+  if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1) {
+    ELOG_ERROR("ice-lite invalid ip:%s", ip.c_str());
+    return false;
+  }
+
+  int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    ELOG_ERROR("ice-lite socket failed, errno:%d", errno);
+    return false;
+  }
+
+  int on = 1;
+  ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+  int size = kSocketBufferSize;
+  ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+  ::setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+  if (::bind(fd, (const sockaddr*)&addr, sizeof(addr)) < 0) {
+    ELOG_ERROR("ice-lite bind %s:%u failed, errno:%d", ip.c_str(), port_, errno);
+    ::close(fd);
+    return false;
+  }
+
+#ifdef UDP_SEGMENT
+  // supported since linux 4.18.
+  int segment = 0;
+  socklen_t segment_len = sizeof(segment);
+  gso_ = ::getsockopt(fd, SOL_UDP, UDP_SEGMENT, &segment, &segment_len) == 0;
+#endif
+
+  auto s = std::make_unique<Socket>();
+  s->mux = this;
+  s->fd = fd;
+  s->source = g_unix_fd_source_new(fd, G_IO_IN);
+  g_source_set_callback(s->source, (GSourceFunc)onReadable, s.get(), nullptr);
+  g_source_attach(s->source, worker->getMainContext());
+  sockets_.emplace_back(std::move(s));
+  return true;
+}
+
+gboolean IceLiteMux::onReadable(gint fd, GIOCondition, gpointer data) {
+  Socket* s = static_cast<Socket*>(data);
+  IceLiteMux* mux = s->mux;
+
+  for (int i = 0; i < kMaxReadsPerEvent; ++i) {
+    for (int j = 0; j < kRecvBatch; ++j) {
+      auto& packet = s->packets[j];
+      if (!packet) {
+        packet = makeDataPacket();
+        packet->reserve(DataPacket::MTU_SIZE);
+      }
+      s->iovs[j].iov_base = packet->data;
+      s->iovs[j].iov_len = DataPacket::MTU_SIZE;
+      msghdr& h = s->msgs[j].msg_hdr;
+      memset(&h, 0, sizeof(h));
+      h.msg_name = &s->addrs[j];
+      h.msg_namelen = sizeof(s->addrs[j]);
+      h.msg_iov = &s->iovs[j];
+      h.msg_iovlen = 1;
+    }
+
+    int count = ::recvmmsg(fd, s->msgs, kRecvBatch, 0, nullptr);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      break;
+    }
+    mux->rx_calls_.fetch_add(1, std::memory_order_relaxed);
+    mux->rx_packets_.fetch_add(count, std::memory_order_relaxed);
+
+    for (int j = 0; j < count; ++j) {
+      const msghdr& h = s->msgs[j].msg_hdr;
+      int len = (int)s->msgs[j].msg_len;
+      // the larger ones than the mtu are dropped.
+      if (len == 0 || (h.msg_flags & MSG_TRUNC) ||
+          s->addrs[j].sin_family != AF_INET) {
+        continue;
+      }
+      s->packets[j]->length = len;
+      mux->onPacket(s, s->packets[j], s->addrs[j]);
+    }
+    if (count < kRecvBatch) {
+      break;
+    }
+  }
+  return G_SOURCE_CONTINUE;
+}
+
+gboolean IceLiteMux::onReport(gpointer data) {
+  IceLiteMux* mux = static_cast<IceLiteMux*>(data);
+  Stats now = mux->stats();
+  Stats& last = mux->reported_;
+  uint64_t rx_calls = now.rx_calls - last.rx_calls;
+  uint64_t tx_calls = now.tx_calls - last.tx_calls;
+  ELOG_INFO("ice-lite rx packets:%lu calls:%lu, tx packets:%lu calls:%lu, "
+            "packets per call rx:%.1f tx:%.1f",
+            now.rx_packets - last.rx_packets, rx_calls,
+            now.tx_packets - last.tx_packets, tx_calls,
+            rx_calls ? (double)(now.rx_packets - last.rx_packets) / rx_calls : 0.0,
+            tx_calls ? (double)(now.tx_packets - last.tx_packets) / tx_calls : 0.0);
+  last = now;
+  return G_SOURCE_CONTINUE;
+}
+
+IceLiteMux::Stats IceLiteMux::stats() const {
+  Stats s;
+  s.rx_packets = rx_packets_.load(std::memory_order_relaxed);
+  s.rx_calls = rx_calls_.load(std::memory_order_relaxed);
+  s.tx_packets = tx_packets_.load(std::memory_order_relaxed);
+  s.tx_calls = tx_calls_.load(std::memory_order_relaxed);
+  return s;
+}
+
+void IceLiteMux::onPacket(Socket* s, std::shared_ptr<DataPacket>& packet,
+                          const sockaddr_in& from) {
+  if (isStun(packet->data, packet->length)) {
+    onBindingRequest(s, packet->data, packet->length, from);
+    return;
+  }
+
+  std::shared_ptr<IceLiteConnection> conn;
+  {
+    std::lock_guard<std::mutex> guard(s->lock);
+    auto found = s->peers.find(IceLiteConnection::addressKey(from));
+    if (found == s->peers.end()) {
+      return;
+    }
+    conn = found->second.ref.lock();
+  }
+  // delivered out of the lock, not to hold the other peers of the socket.
+  if (conn) {
+    conn->onPacket(packet);
+  }
+}
+
+void IceLiteMux::onBindingRequest(Socket* s, char* buf, int len, const sockaddr_in& from) {
+  cricket::IceMessage request;
+  rtc::ByteBufferReader reader(buf, len);
+  if (!request.Read(&reader) || request.type() != cricket::STUN_BINDING_REQUEST) {
+    return;
+  }
+
+  // "local ufrag:remote ufrag"
+  const cricket::StunByteStringAttribute* username =
+      request.GetByteString(cricket::STUN_ATTR_USERNAME);
+  if (!username) {
+    return;
+  }
+  std::string ufrag = username->GetString();
+  size_t colon = ufrag.find(':');
+  if (colon == std::string::npos) {
+    return;
+  }
+  ufrag.resize(colon);
+
+  std::shared_ptr<IceLiteConnection> conn;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    auto found = ufrags_.find(ufrag);
+    if (found == ufrags_.end()) {
+      return;
+    }
+    conn = found->second.ref.lock();
+  }
+  if (!conn) {
+    return;
+  }
+  const std::string& password = conn->getLocalPassword();
+  if (!cricket::StunMessage::ValidateMessageIntegrity(buf, len, password)) {
+    ELOG_DEBUG("ice-lite bad integrity, ufrag:%s", ufrag.c_str());
+    return;
+  }
+
+  rtc::SocketAddress mapped;
+  mapped.FromSockAddr(from);
+  cricket::IceMessage response;
+  response.SetType(cricket::STUN_BINDING_RESPONSE);
+  response.SetTransactionID(request.transaction_id());
+  response.AddAttribute(std::make_unique<cricket::StunXorAddressAttribute>(
+      cricket::STUN_ATTR_XOR_MAPPED_ADDRESS, mapped));
+  response.AddMessageIntegrity(password);
+  response.AddFingerprint();
+
+  rtc::ByteBufferWriter writer;
+  if (response.Write(&writer)) {
+    ::sendto(s->fd, writer.Data(), writer.Length(), 0,
+             (const sockaddr*)&from, sizeof(from));
+  }
+
+  conn->onBinding(s, from,
+      request.GetByteString(cricket::STUN_ATTR_USE_CANDIDATE) != nullptr);
+}
+
+bool IceLiteMux::add(IceLiteConnection* conn) {
+  std::lock_guard<std::mutex> guard(lock_);
+  return ufrags_.emplace(conn->getLocalUsername(),
+      Peer{conn, conn->weak_from_this()}).second;
+}
+
+void IceLiteMux::remove(IceLiteConnection* conn) {
+  std::lock_guard<std::mutex> guard(lock_);
+  auto found = ufrags_.find(conn->getLocalUsername());
+  if (found != ufrags_.end() && found->second.conn == conn) {
+    ufrags_.erase(found);
+  }
+  for (auto& i : conn->bindings_) {
+    std::lock_guard<std::mutex> guard(i.first->lock);
+    auto peer = i.first->peers.find(i.second);
+    if (peer != i.first->peers.end() && peer->second.conn == conn) {
+      i.first->peers.erase(peer);
+    }
+  }
+  conn->bindings_.clear();
+}
+
+IceLiteConnection::IceLiteConnection(IceLiteMux* mux, const IceConfig& ice_config)
+    : IceConnection{ice_config}, mux_{mux} {
+}
+
+IceLiteConnection::~IceLiteConnection() {
+  this->close();
+}
+
+void IceLiteConnection::start() {
+  if (this->checkIceState() != INITIAL) {
+    return;
+  }
+
+  do {
+    ufrag_ = rtc::CreateRandomString(kUfragLength);
+    upass_ = rtc::CreateRandomString(kPasswordLength);
+  } while (!mux_->add(this));
+
+  auto listener = getIceListener().lock();
+  if (listener) {
+    int foundation = 0;
+    for (const auto& ip : ice_config_.ip_addresses) {
+      if (ip.find(':') != std::string::npos) {
+        continue;
+      }
+      CandidateInfo cand_info;
+      cand_info.isBundle = true;
+      cand_info.priority = kHostPriority - foundation;
+      cand_info.componentId = 1;
+      cand_info.foundation = std::to_string(++foundation);
+      cand_info.hostAddress = ip;
+      cand_info.hostPort = mux_->port();
+      cand_info.hostType = HOST;
+      cand_info.mediaType = ice_config_.media_type;
+      cand_info.netProtocol = "udp";
+      cand_info.transProtocol = ice_config_.transport_name;
+      cand_info.username = ufrag_;
+      cand_info.password = upass_;
+      listener->onCandidate(cand_info, this);
+    }
+  }
+  ELOG_DEBUG("%s message: ice-lite started, ufrag:%s", toLog(), ufrag_.c_str());
+  updateIceState(IceState::CANDIDATES_RECEIVED);
+}
+
+bool IceLiteConnection::setRemoteCandidates(
+    const std::vector<CandidateInfo>&, bool) {
+  return true;
+}
+
+void IceLiteConnection::setRemoteCredentials(
+    const std::string& username, const std::string& password) {
+  ice_config_.username = username;
+  ice_config_.password = password;
+}
+
+void IceLiteConnection::onBinding(
+    IceLiteMux::Socket* s, const sockaddr_in& from, bool nominated) {
+  uint64_t key = addressKey(from);
+  {
+    std::lock_guard<std::mutex> guard(mux_->lock_);
+    // removed from the mux, not to be added back.
+    if (checkIceState() == IceState::FINISHED) {
+      return;
+    }
+    bool known = false;
+    for (auto& i : bindings_) {
+      if (i.first == s && i.second == key) {
+        known = true;
+        break;
+      }
+    }
+    if (!known) {
+      {
+        std::lock_guard<std::mutex> guard(s->lock);
+        // the address may be taken over from a closed peer.
+        s->peers[key] = IceLiteMux::Peer{this, weak_from_this()};
+      }
+      bindings_.emplace_back(s, key);
+    }
+  }
+
+  {
+    // the first checked pair, then the nominated one.
+    std::lock_guard<std::mutex> guard(send_lock_);
+    if (send_fd_ == -1 || nominated) {
+      send_fd_ = s->fd;
+      remote_ = from;
+      nominated_ = nominated_ || nominated;
+    }
+  }
+
+  std::lock_guard<std::mutex> guard(listener_lock_);
+  if (checkIceState() < IceState::READY) {
+    updateIceState(IceState::READY);
+  }
+}
+
+void IceLiteConnection::onData(unsigned int component_id, char* buf, int len) {
+  // the listener only posts the packet to its worker.
+  std::lock_guard<std::mutex> guard(listener_lock_);
+  if (checkIceState() == IceState::READY) {
+    if (auto listener = listener_.lock()) {
+      listener->onPacketReceived(
+          makeDataPacket(component_id, buf, len, VIDEO_PACKET, 0));
+    }
+  }
+}
+
+void IceLiteConnection::onPacket(std::shared_ptr<DataPacket>& packet) {
+  if (packet->length <= kCopyBelow) {
+    onData(1, packet->data, packet->length);
+    return;
+  }
+
+  std::lock_guard<std::mutex> guard(listener_lock_);
+  if (checkIceState() == IceState::READY) {
+    if (auto listener = listener_.lock()) {
+      packet->comp = 1;
+      packet->type = VIDEO_PACKET;
+      packet->received_time_ms = 0;
+      listener->onPacketReceived(std::move(packet));
+    }
+  }
+}
+
+int IceLiteConnection::sendData(unsigned int, const void* buf, int len) {
+  if (this->checkIceState() != IceState::READY) {
+    return -1;
+  }
+
+  int fd;
+  sockaddr_in remote;
+  {
+    std::lock_guard<std::mutex> guard(send_lock_);
+    fd = send_fd_;
+    remote = remote_;
+  }
+  // sent with the others of the task.
+  if (UdpSendBatch::current().add(mux_, fd, remote, buf, len)) {
+    return len;
+  }
+
+  ssize_t val = ::sendto(fd, buf, len, 0, (const sockaddr*)&remote, sizeof(remote));
+  mux_->tx_packets_.fetch_add(1, std::memory_order_relaxed);
+  mux_->tx_calls_.fetch_add(1, std::memory_order_relaxed);
+  if (val != len) {
+    ELOG_DEBUG("%s message: Sending less data than expected,"
+               " sent: %d, to_send: %d", toLog(), (int)val, len);
+  }
+  return (int)val;
+}
+
+CandidatePair IceLiteConnection::getSelectedPair() {
+  sockaddr_in remote;
+  {
+    std::lock_guard<std::mutex> guard(send_lock_);
+    remote = remote_;
+  }
+  char ip[INET_ADDRSTRLEN] = {0};
+  inet_ntop(AF_INET, &remote.sin_addr, ip, sizeof(ip));
+
+  CandidatePair pair;
+  pair.erizoCandidateIp = ice_config_.ip_addresses.empty() ?
+      "" : ice_config_.ip_addresses[0];
+  pair.erizoCandidatePort = mux_->port();
+  pair.erizoHostType = "host";
+  pair.clientCandidateIp = ip;
+  pair.clientCandidatePort = ntohs(remote.sin_port);
+  pair.clientHostType = "peerReflexive";
+  return pair;
+}
+
+void IceLiteConnection::setReceivedLastCandidate(bool) {
+}
+
+void IceLiteConnection::close() {
+  {
+    // waits for the packet being delivered by an io worker, the ones after
+    // see FINISHED.
+    std::lock_guard<std::mutex> guard(listener_lock_);
+    if (checkIceState() == IceState::FINISHED) {
+      return;
+    }
+    updateIceState(IceState::FINISHED);
+    listener_.reset();
+  }
+  mux_->remove(this);
+  ELOG_DEBUG("%s message: closed, this: %p", toLog(), this);
+}
+
+}  // namespace erizo
@@ -0,0 +1,175 @@
+//
+// Copyright (c) 2021- anjisuan783
+//
+// SPDX-License-Identifier: MIT
+//
+
+#ifndef ERIZO_SRC_ERIZO_ICELITECONNECTION_H_
+#define ERIZO_SRC_ERIZO_ICELITECONNECTION_H_
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "erizo/IceConnection.h"
+#include "erizo/logger.h"
+#include "utils/IOWorker.h"
+
+typedef struct _GSource GSource;
+
+namespace erizo {
+
+class IceLiteConnection;
+class UdpSendBatch;
+
+// All the ice-lite connections share one udp port, instead of a socket and
+// a glib agent for each peer. Every io worker listens the port by its own
+// socket with SO_REUSEPORT, the kernel keeps a peer on the same one.
+// The binding requests are matched by the local ufrag of USERNAME, the
+// media by the remote address learnt from them. The packets are read by
+// recvmmsg, and sent by sendmmsg or UDP GSO on the end of a worker task.
+class IceLiteMux {
+  DECLARE_LOGGER();
+
+ public:
+  // Listen |ip|:|port| on the io workers, returns false if failed and the
+  // connections fall back to libnice.
+  static bool start(const std::string& ip, uint16_t port,
+                    const std::vector<std::shared_ptr<wa::IOWorker>>& workers);
+  static void stop();
+
+  // null if not started.
+  static IceLiteMux* get();
+
+  uint16_t port() const { return port_; }
+
+  // the packets and the system calls, to see the batching.
+  struct Stats {
+    uint64_t rx_packets{0};
+    uint64_t rx_calls{0};
+    uint64_t tx_packets{0};
+    uint64_t tx_calls{0};
+  };
+  Stats stats() const;
+
+  // Register the connection by its local ufrag, false if used.
+  bool add(IceLiteConnection* conn);
+  void remove(IceLiteConnection* conn);
+
+  ~IceLiteMux();
+
+ private:
+  static constexpr int kRecvBatch = 32;
+
+  // The connection is pinned by |ref| to be called out of the locks, its
+  // handlers may close it and so remove it.
+  struct Peer {
+    IceLiteConnection* conn{nullptr};
+    std::weak_ptr<IceLiteConnection> ref;
+  };
+
+  struct Socket {
+    IceLiteMux* mux{nullptr};
+    int fd{-1};
+    GSource* source{nullptr};
+    // guards the peers.
+    std::mutex lock;
+    std::unordered_map<uint64_t, Peer> peers;
+
+    // read by recvmmsg into the packets, used by its io worker only.
+    mmsghdr msgs[kRecvBatch];
+    iovec iovs[kRecvBatch];
+    sockaddr_in addrs[kRecvBatch];
+    std::shared_ptr<DataPacket> packets[kRecvBatch];
+  };
+
+  explicit IceLiteMux(uint16_t port) : port_{port} { }
+
+  bool listen(const std::string& ip, wa::IOWorker* worker);
+  static gboolean onReadable(gint fd, GIOCondition condition, gpointer data);
+  void onPacket(Socket* s, std::shared_ptr<DataPacket>& packet,
+                const sockaddr_in& from);
+  void onBindingRequest(Socket* s, char* buf, int len, const sockaddr_in& from);
+  static gboolean onReport(gpointer data);
+
+ private:
+  const uint16_t port_;
+  std::vector<std::unique_ptr<Socket>> sockets_;
+  GSource* report_{nullptr};
+
+  // UDP_SEGMENT supported, cleared if the sending fails.
+  std::atomic<bool> gso_{false};
+  std::atomic<uint64_t> rx_packets_{0};
+  std::atomic<uint64_t> rx_calls_{0};
+  std::atomic<uint64_t> tx_packets_{0};
+  std::atomic<uint64_t> tx_calls_{0};
+  Stats reported_;
+
+  // locked before the one of a socket, guards the ufrags and the bindings
+  // of the connections.
+  std::mutex lock_;
+  std::unordered_map<std::string, Peer> ufrags_;
+
+  static std::unique_ptr<IceLiteMux> instance_;
+
+  friend class IceLiteConnection;
+  friend class UdpSendBatch;
+};
+
+class IceLiteConnection : public IceConnection,
+                          public std::enable_shared_from_this<IceLiteConnection> {
+  DECLARE_LOGGER();
+
+ public:
+  IceLiteConnection(IceLiteMux* mux, const IceConfig& ice_config);
+  ~IceLiteConnection() override;
+
+  // Registers to the mux and gives the host candidates of its port.
+  void start() override;
+  // ice-lite never checks, the peer's candidates are not used.
+  bool setRemoteCandidates(const std::vector<CandidateInfo> &candidates, bool is_bundle) override;
+  void setRemoteCredentials(const std::string& username, const std::string& password) override;
+  int sendData(unsigned int component_id, const void* buf, int len) override;
+
+  void onData(unsigned int component_id, char* buf, int len) override;
+  // Takes the packet read if not copied.
+  void onPacket(std::shared_ptr<DataPacket>& packet);
+  CandidatePair getSelectedPair() override;
+  void setReceivedLastCandidate(bool hasReceived) override;
+  void close() override;
+
+  static uint64_t addressKey(const sockaddr_in& addr) {
+    return ((uint64_t)addr.sin_addr.s_addr << 16) | addr.sin_port;
+  }
+
+ private:
+  // By the mux on a valid binding request from |from|, out of its locks.
+  void onBinding(IceLiteMux::Socket* s, const sockaddr_in& from, bool nominated);
+
+ private:
+  IceLiteMux* mux_;
+
+  // the sockets learnt the peer's addresses, under the lock of the mux.
+  std::vector<std::pair<IceLiteMux::Socket*, uint64_t>> bindings_;
+
+  // held to deliver a packet or the state, and by close to reset the
+  // listener, so none is delivered after close returns.
+  std::mutex listener_lock_;
+
+  std::mutex send_lock_;
+  int send_fd_{-1};
+  sockaddr_in remote_{};
+  bool nominated_{false};
+
+  friend class IceLiteMux;
+};
+
+}  // namespace erizo
+#endif  // ERIZO_SRC_ERIZO_ICELITECONNECTION_H_
@@ -10,13 +10,10 @@
 #include <mutex>
 #include <iostream>
 
-#include "rtc_base/object_pool.h"
 #include "erizo/LibNiceConnection.h"
 #include "erizo/SdpInfo.h"
 #include "utils/Clock.h"
 
-#define USER_PACKET_POOL
-
 using namespace wa;
 
 namespace erizo {
@@ -127,39 +124,10 @@ void LibNiceConnection::close() {
   ELOG_DEBUG("%s message: closed, this: %p", toLog(), this);
 }
 
-static std::mutex s_memory_pool_lock_;
-static webrtc::ObjectPoolT<DataPacket> s_memory_pool_{102400};
-
-DataPacket* DataPacketMaker(int _comp, 
-                            const char *_data, 
-                            int _length, 
-                            packetType _type, 
-                            uint64_t _received_time_ms) {
-  DataPacket* pkt = nullptr;
-  {
-    std::lock_guard<std::mutex> guard(s_memory_pool_lock_);
-    pkt = s_memory_pool_.New(); 
-  }
-  pkt->Init(_comp, _data, _length, _type, _received_time_ms);
-  return pkt;
-}
-
-void DataPacketDeleter(DataPacket* pkt) {
-    std::lock_guard<std::mutex> guard(s_memory_pool_lock_);
-    s_memory_pool_.Delete(pkt); 
-}
-
 void LibNiceConnection::onData(unsigned int component_id, char* buf, int len) {
   if (checkIceState() == IceState::READY) {
     if (auto listener = getIceListener().lock()) {
-#ifdef USER_PACKET_POOL
-      std::shared_ptr<DataPacket> packet(
-          DataPacketMaker(component_id, buf, len, VIDEO_PACKET, 0), 
-          DataPacketDeleter);
-#else
-      auto packet = std::make_shared<DataPacket>(
-          component_id, buf, len, VIDEO_PACKET, 0);
-#endif
+      auto packet = makeDataPacket(component_id, buf, len, VIDEO_PACKET, 0);
       listener->onPacketReceived(std::move(packet));
     }
   }
@@ -14,6 +14,7 @@
 
 #include "utils/Clock.h"
 #include "rtc_base/copy_on_write_buffer.h"
+#include "erizo/PacketPool.h"
 
 namespace erizo {
 
@@ -23,34 +24,19 @@ enum packetType {
   OTHER_PACKET
 };
 
+// The data is in a buffer of the packet pool, sized to the packet.
 struct DataPacket {
   static const size_t MTU_SIZE = 1500;
-  DataPacket() = default;/*: buffer_{0, MTU_SIZE}, data{(char*)buffer_.data()} { }*/
+  DataPacket() = default;
   DataPacket(const DataPacket&) = delete;
-/*  
-  DataPacket(DataPacket&& dpk)
-      : comp{dpk.comp}, 
-        type{dpk.type}, 
-        received_time_ms{dpk.received_time_ms},
-        buffer_{std::move(dpk.buffer_)},
-        length{dpk.length},
-        data{dpk.data} {
-    dpk.length = 0;
-    dpk.data = nullptr;
-  }
-*/
+  DataPacket& operator=(const DataPacket&) = delete;
+
   DataPacket(int _comp, 
              const char *_data, 
              int _length, 
              packetType _type, 
-             uint64_t _received_time_ms) 
-             : comp{_comp},
-               type{_type},
-               received_time_ms{_received_time_ms},
-               //buffer_{_data, (size_t)_length, MTU_SIZE},
-               length{_length}/*,
-               data{(char*)buffer_.data()}*/ {
-    memcpy(data, _data, _length);
+             uint64_t _received_time_ms) {
+    Init(_comp, _data, _length, _type, _received_time_ms);
   }
 
   DataPacket(int _comp, const char *_data, int _length, packetType _type)
@@ -59,6 +45,10 @@ struct DataPacket {
   DataPacket(int _comp, const char *_data, int _length)
     : DataPacket(_comp, _data, _length, VIDEO_PACKET, 0) { }
 
+  ~DataPacket() {
+    PacketPool::free(data);
+  }
+
   void Init(int _comp, 
             const char *_data, 
             int _length, 
@@ -67,20 +57,41 @@ struct DataPacket {
     comp = _comp;
     type = _type;
     received_time_ms = _received_time_ms;
-    //buffer_.SetData(_data, _length);
+    reserve(_length);
     length = _length;
     memcpy(data, _data, _length);
-    //data = (char*)buffer_.data();
+  }
+
+  // Room for |size| bytes, the data is not kept if reallocated.
+  void reserve(size_t size) {
+    if (!data || capacity_ < size) {
+      PacketPool::free(data);
+      data = PacketPool::alloc(size, &capacity_);
+    }
+  }
+
+  size_t capacity() const {
+    return capacity_;
   }
 
   int comp{-1};         //component_id
   packetType type{VIDEO_PACKET};
   uint64_t received_time_ms{0};
-  //rtc::CopyOnWriteBuffer buffer_;
   int length{0};
-  char data[MTU_SIZE];
+  char* data{nullptr};
+
+ private:
+  size_t capacity_{0};
 };
 
+// The packet and its shared_ptr control block in one buffer of the pool,
+// instead of std::make_shared.
+template <typename... Args>
+inline std::shared_ptr<DataPacket> makeDataPacket(Args&&... args) {
+  return std::allocate_shared<DataPacket>(
+      PacketAllocator<DataPacket>(), std::forward<Args>(args)...);
+}
+
 class MediaEvent {
 public:
   MediaEvent() = default;
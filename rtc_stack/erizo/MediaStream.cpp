@@ -492,7 +492,7 @@ int MediaStream::sendPLI() {
   thePLI.setLength(2);
   char *buf = reinterpret_cast<char*>(&thePLI);
   int len = (thePLI.getLength() + 1) * 4;
-  sendPacket(std::make_shared<DataPacket>(0, buf, len, VIDEO_PACKET));
+  sendPacket(makeDataPacket(0, buf, len, VIDEO_PACKET));
   return len;
 }
 
@@ -511,7 +511,7 @@ void MediaStream::sendPacket(std::shared_ptr<DataPacket> packet) {
   
   if (packet->comp == -1) {
     sending_ = false;
-    auto p = std::make_shared<DataPacket>();
+    auto p = makeDataPacket();
     p->comp = -1;
     sendPacket_i(std::move(p));
     return;
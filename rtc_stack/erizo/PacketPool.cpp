@@ -0,0 +1,175 @@
+//
+// Copyright (c) 2021- anjisuan783
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "erizo/PacketPool.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <new>
+
+namespace erizo {
+
+constexpr size_t PacketPool::kClassSize[];
+
+namespace {
+
+struct ThreadCache;
+
+// The header of each buffer.
+struct alignas(16) Block {
+  // null if not cached, the large ones.
+  ThreadCache* owner;
+  Block* next;
+  size_t cls;
+};
+
+// The lines of the owner and the others apart, not to bounce.
+struct alignas(64) ClassCache {
+  // by the owner thread only.
+  Block* local{nullptr};
+  // the ones freed to local, to limit the cache.
+  size_t count{0};
+  // freed by the other threads.
+  alignas(64) std::atomic<Block*> remote{nullptr};
+};
+
+struct ThreadCache {
+  ClassCache classes[PacketPool::kClasses];
+  // the thread exited, the buffers back are freed.
+  std::atomic<bool> orphaned{false};
+};
+
+void freeList(Block* b) {
+  while (b) {
+    Block* next = b->next;
+    ::free(b);
+    b = next;
+  }
+}
+
+thread_local ThreadCache* t_cache = nullptr;
+thread_local bool t_exited = false;
+
+// The cache is kept after the thread exits, the buffers out still point
+// to it, only the ones cached are freed.
+struct CacheHolder {
+  ~CacheHolder() {
+    ThreadCache* cache = t_cache;
+    t_cache = nullptr;
+    t_exited = true;
+    // seq_cst with the check of free, a buffer pushed after the drain is
+    // freed by its pusher.
+    cache->orphaned.store(true);
+    for (auto& c : cache->classes) {
+      freeList(c.local);
+      c.local = nullptr;
+      freeList(c.remote.exchange(nullptr));
+    }
+  }
+};
+
+ThreadCache* currentCache() {
+  if (!t_cache && !t_exited) {
+    static thread_local CacheHolder holder;
+    t_cache = new ThreadCache;
+  }
+  return t_cache;
+}
+
+size_t classOf(size_t size) {
+  size_t cls = 0;
+  while (cls < PacketPool::kClasses && PacketPool::kClassSize[cls] < size) {
+    ++cls;
+  }
+  return cls;
+}
+
+Block* newBlock(ThreadCache* owner, size_t cls, size_t size) {
+  Block* b = reinterpret_cast<Block*>(::malloc(sizeof(Block) + size));
+  if (!b) {
+    throw std::bad_alloc();
+  }
+  b->owner = owner;
+  b->next = nullptr;
+  b->cls = cls;
+  return b;
+}
+
+}  // namespace
+
+char* PacketPool::alloc(size_t size, size_t* capacity) {
+  size_t cls = classOf(size);
+  ThreadCache* cache = cls < kClasses ? currentCache() : nullptr;
+  if (!cache) {
+    size = cls < kClasses ? kClassSize[cls] : size;
+    if (capacity) {
+      *capacity = size;
+    }
+    return reinterpret_cast<char*>(newBlock(nullptr, cls, size) + 1);
+  }
+
+  ClassCache& c = cache->classes[cls];
+  if (!c.local) {
+    // take back all the ones freed by the others, not counted, not to
+    // touch them all.
+    c.local = c.remote.exchange(nullptr, std::memory_order_acquire);
+  }
+
+  Block* b = c.local;
+  if (b) {
+    c.local = b->next;
+    c.count -= (c.count > 0);
+  } else {
+    b = newBlock(cache, cls, kClassSize[cls]);
+  }
+  if (capacity) {
+    *capacity = kClassSize[cls];
+  }
+  return reinterpret_cast<char*>(b + 1);
+}
+
+void PacketPool::free(char* buf) {
+  if (!buf) {
+    return;
+  }
+
+  Block* b = reinterpret_cast<Block*>(buf) - 1;
+  ThreadCache* owner = b->owner;
+  if (!owner) {
+    ::free(b);
+    return;
+  }
+
+  ClassCache& c = owner->classes[b->cls];
+  if (owner == t_cache) {
+    if (c.count >= kMaxCached) {
+      ::free(b);
+      return;
+    }
+    b->next = c.local;
+    c.local = b;
+    ++c.count;
+    return;
+  }
+
+  if (owner->orphaned.load()) {
+    ::free(b);
+    return;
+  }
+  Block* head = c.remote.load(std::memory_order_relaxed);
+  do {
+    b->next = head;
+  } while (!c.remote.compare_exchange_weak(head, b));
+
+  // the owner exited meanwhile and may have drained before the push.
+  if (owner->orphaned.load()) {
+    freeList(c.remote.exchange(nullptr));
+  }
+}
+
+}  // namespace erizo
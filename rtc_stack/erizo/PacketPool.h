@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2021- anjisuan783
+//
+// SPDX-License-Identifier: MIT
+//
+
+#ifndef ERIZO_SRC_ERIZO_PACKETPOOL_H_
+#define ERIZO_SRC_ERIZO_PACKETPOOL_H_
+
+#include <stddef.h>
+
+#include <memory>
+
+namespace erizo {
+
+// The buffers of the packets in size classes, so a small audio or rtcp
+// packet doesn't pin a buffer of the mtu. Each thread caches the buffers
+// it allocated without lock. A buffer freed by another thread, like one
+// read by an io worker and released by a worker, is pushed back to the
+// owner by a lock-free list, and taken by the owner on its next miss.
+class PacketPool final {
+ public:
+  // A buffer of |size| bytes at least, its real size in |capacity|.
+  static char* alloc(size_t size, size_t* capacity = nullptr);
+  // Any thread.
+  static void free(char* buf);
+
+  static constexpr size_t kClasses = 5;
+  static constexpr size_t kClassSize[kClasses] = {128, 256, 512, 1024, 1536};
+  // the buffers cached by a thread of each class at most.
+  static constexpr size_t kMaxCached = 4096;
+};
+
+// Allocates the shared_ptr control block with the object by the pool.
+template <typename T>
+class PacketAllocator {
+ public:
+  using value_type = T;
+
+  PacketAllocator() = default;
+  template <typename U>
+  PacketAllocator(const PacketAllocator<U>&) { }
+
+  T* allocate(size_t n) {
+    return reinterpret_cast<T*>(PacketPool::alloc(n * sizeof(T)));
+  }
+  void deallocate(T* p, size_t) {
+    PacketPool::free(reinterpret_cast<char*>(p));
+  }
+
+  template <typename U>
+  bool operator==(const PacketAllocator<U>&) const { return true; }
+  template <typename U>
+  bool operator!=(const PacketAllocator<U>&) const { return false; }
+};
+
+}  // namespace erizo
+#endif  // ERIZO_SRC_ERIZO_PACKETPOOL_H_
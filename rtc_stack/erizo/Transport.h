@@ -136,7 +136,8 @@ class Transport : public std::enable_shared_from_this<Transport>,
   }
 
 public:
-  std::unique_ptr<IceConnection> ice_;
+  // shared by the ice-lite mux while it delivers a packet.
+  std::shared_ptr<IceConnection> ice_;
   MediaType mediaType;
   std::string transport_name;
   bool rtcp_mux_;
@@ -551,7 +551,7 @@ void WebRtcConnection::onRtcpFromTransport(
       onREMBFromTransport(chead, transport);
       return;
     }
-    auto new_rtcp = std::make_shared<DataPacket>(
+    auto new_rtcp = makeDataPacket(
         packet->comp, (const char*)chead, (ntohs(chead->length) + 1) * 4, 
         packet->type, packet->received_time_ms);
     
@@ -73,7 +73,7 @@ void WoogeenHandler::write(Context *ctx, std::shared_ptr<DataPacket> packet) {
         RTPHeader* mediahead = (RTPHeader*) deliverMediaBuffer;
         mediahead->setPayloadType(redhead->payloadtype);
 
-        ctx->fireWrite(std::make_shared<DataPacket>(0, deliverMediaBuffer, newLen, VIDEO_PACKET));
+        ctx->fireWrite(makeDataPacket(0, deliverMediaBuffer, newLen, VIDEO_PACKET));
         return;
       }
     }
@@ -77,7 +77,7 @@ std::shared_ptr<DataPacket> RtpUtils::createPLI(uint32_t source_ssrc, uint32_t s
   pli.setLength(2);
   char *buf = reinterpret_cast<char*>(&pli);
   int len = (pli.getLength() + 1) * 4;
-  return std::make_shared<DataPacket>(0, buf, len, VIDEO_PACKET);
+  return makeDataPacket(0, buf, len, VIDEO_PACKET);
 }
 
 std::shared_ptr<DataPacket> RtpUtils::createFIR(uint32_t source_ssrc, uint32_t sink_ssrc, uint8_t seq_number) {
@@ -91,7 +91,7 @@ std::shared_ptr<DataPacket> RtpUtils::createFIR(uint32_t source_ssrc, uint32_t s
   fir.setFIRSequenceNumber(seq_number);
   char *buf = reinterpret_cast<char*>(&fir);
   int len = (fir.getLength() + 1) * 4;
-  return std::make_shared<DataPacket>(0, buf, len, VIDEO_PACKET);
+  return makeDataPacket(0, buf, len, VIDEO_PACKET);
 }
 
 std::shared_ptr<DataPacket> RtpUtils::createREMB(uint32_t ssrc, std::vector<uint32_t> ssrc_list, uint32_t bitrate) {
@@ -111,7 +111,7 @@ std::shared_ptr<DataPacket> RtpUtils::createREMB(uint32_t ssrc, std::vector<uint
   }
   int len = (remb.getLength() + 1) * 4;
   char *buf = reinterpret_cast<char*>(&remb);
-  return std::make_shared<erizo::DataPacket>(0, buf, len, erizo::OTHER_PACKET);
+  return erizo::makeDataPacket(0, buf, len, erizo::OTHER_PACKET);
 }
 
 
@@ -157,7 +157,7 @@ std::shared_ptr<DataPacket> RtpUtils::makePaddingPacket(DataPacket* packet, uint
   new_header->setMarker(false);
   packet_buffer[packet_length - 1] = padding_size;
 
-  return std::make_shared<DataPacket>(packet->comp, packet_buffer, packet_length, packet->type);
+  return makeDataPacket(packet->comp, packet_buffer, packet_length, packet->type);
 }
 
 }  // namespace erizo
@@ -90,6 +90,10 @@ struct TOption {
   std::vector<TTrackInfo> tracks_; 
   std::shared_ptr<WebrtcAgentSink> call_back_;
   std::shared_ptr<RtcPeer> pc_;
+  // a subscriber takes the rtp packets of a webrtc publisher as received,
+  // or the ones of a frame source packetized once for all, restamped, 
+  // instead of the frames packetized for it.
+  bool forward_rtp_{false};
 };
 
 class RtcApi {
@@ -18,6 +18,13 @@ namespace webrtc {
 
 std::unique_ptr<TaskQueueFactory> CreateDefaultTaskQueueFactory();
 
+// The task queues posting to an intrusive lock-free mpsc queue, and waking
+// up by an eventfd only when the queue turns non-empty.
+std::unique_ptr<TaskQueueFactory> CreateMpscTaskQueueFactory();
+
+// The eventfd wakeups of all the mpsc task queues.
+uint64_t MpscTaskQueueWakeups();
+
 }  // namespace webrtc
 
 #endif  // API_TASK_QUEUE_DEFAULT_TASK_QUEUE_FACTORY_H_
@@ -57,6 +57,8 @@ class RTC_EXPORT PacketSocketFactory {
 
     OPT_RAW = 0x10,   // tcp raw stream
     OPT_ADDRESS_REUSE = 0x20, // tcp reuse address
+    OPT_PORT_REUSE = 0x40,    // tcp reuse port, shared by listeners
+    OPT_KERNEL_TLS = 0x80,    // tls sending encrypted by the kernel if can
   };
 
   PacketSocketFactory() = default;
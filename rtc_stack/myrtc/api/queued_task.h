@@ -10,6 +10,7 @@
 #ifndef API_TASK_QUEUE_QUEUED_TASK_H_
 #define API_TASK_QUEUE_QUEUED_TASK_H_
 
+#include <atomic>
 #include <optional>
 
 #include "rtc_base/location.h"
@@ -31,6 +32,10 @@ class QueuedTask {
   virtual bool Run() = 0;
 
   std::optional<rtc::Location> location_;
+
+  // The intrusive link of the lock-free task queue, no node is allocated
+  // to post it.
+  std::atomic<QueuedTask*> next_{nullptr};
 };
 
 }  // namespace webrtc
@@ -77,6 +77,15 @@ AsyncPacketSocket* BasicPacketSocketFactory::CreateServerTcpSocket(
                         << socket->GetError();
     }
   }
+
+  if (option.opts & PacketSocketFactory::OPT_PORT_REUSE) {
+    int reuse = 1;
+    if (socket->GetLocalAddress().family() != PF_UNIX && 
+        socket->SetOption(Socket::OPT_REUSEPORT, reuse) < 0) {
+      RTC_LOG(LS_ERROR) << "set OPT_PORT_REUSE with error " 
+                        << socket->GetError();
+    }
+  }
   
   if (BindSocket(socket, local_address, min_port, max_port) < 0) {
     RTC_LOG(LS_ERROR) << "TCP bind failed with error " << socket->GetError();
@@ -117,6 +126,9 @@ AsyncPacketSocket* BasicPacketSocketFactory::CreateServerTcpSocket(
       ssl_adapter->SetIgnoreBadCert(true);
     }
 
+    ssl_adapter->SetKernelTls(
+        (option.opts & PacketSocketFactory::OPT_KERNEL_TLS) != 0);
+
     //TODO support custom SSL certificate verifier
     socket = ssl_adapter;
   }
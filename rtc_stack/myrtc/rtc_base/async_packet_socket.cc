@@ -10,6 +10,10 @@
 
 #include "rtc_base/async_packet_socket.h"
 
+#include <unistd.h>
+
+#include <algorithm>
+
 #include "rtc_base/net_helper.h"
 
 namespace rtc {
@@ -30,6 +34,53 @@ AsyncPacketSocket::AsyncPacketSocket() = default;
 
 AsyncPacketSocket::~AsyncPacketSocket() = default;
 
+int AsyncPacketSocket::SendV(const iovec* iov,
+                             int iovcnt,
+                             const PacketOptions& options) {
+  int total = 0;
+  for (int i = 0; i < iovcnt; ++i) {
+    int len = static_cast<int>(iov[i].iov_len);
+    int sent = Send(iov[i].iov_base, iov[i].iov_len, options);
+    if (sent < 0) {
+      return total > 0 ? total : sent;
+    }
+    total += sent;
+    if (sent < len) {
+      break;
+    }
+  }
+  return total;
+}
+
+int AsyncPacketSocket::SendFile(int fd,
+                                int64_t offset,
+                                size_t count,
+                                const PacketOptions& options) {
+  char buf[16 * 1024];
+  int total = 0;
+  while (count > 0) {
+    ssize_t nread = ::pread(fd, buf, std::min(count, sizeof(buf)), offset);
+    if (nread <= 0) {
+      if (total > 0) {
+        return total;
+      }
+      SetError(nread < 0 ? errno : EINVAL);
+      return -1;
+    }
+    int sent = Send(buf, nread, options);
+    if (sent < 0) {
+      return total > 0 ? total : sent;
+    }
+    total += sent;
+    offset += sent;
+    count -= sent;
+    if (sent < nread) {
+      break;
+    }
+  }
+  return total;
+}
+
 void CopySocketInformationToPacketInfo(size_t packet_size_bytes,
                                        const AsyncPacketSocket& socket_from,
                                        bool is_connectionless,
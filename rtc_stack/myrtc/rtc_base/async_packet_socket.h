@@ -80,6 +80,21 @@ class RTC_EXPORT AsyncPacketSocket : public sigslot::has_slots<> {
                      size_t cb,
                      const SocketAddress& addr,
                      const PacketOptions& options) = 0;
+  // Send the buffers of |iov| as a stream, returns the bytes sent which may
+  // be less than the total, or -1 if nothing is sent. The default sends them
+  // one by one, and stops at the first one not entirely sent.
+  virtual int SendV(const iovec* iov,
+                    int iovcnt,
+                    const PacketOptions& options);
+  // Send |count| bytes of the file |fd| from |offset| as a stream, returns
+  // the bytes sent like SendV. The default reads the file and sends it.
+  virtual int SendFile(int fd,
+                       int64_t offset,
+                       size_t count,
+                       const PacketOptions& options);
+  // The descriptor the stream can be written to directly when nothing is
+  // pending in this socket, or -1. The default returns -1.
+  virtual int GetSendDescriptor() { return -1; }
 
   // Close the socket.
   virtual int Close() = 0;
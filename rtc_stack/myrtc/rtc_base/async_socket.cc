@@ -64,6 +64,14 @@ int AsyncSocketAdapter::SendTo(const void* pv,
   return socket_->SendTo(pv, cb, addr);
 }
 
+int AsyncSocketAdapter::SendV(const iovec* iov, int iovcnt) {
+  return socket_->SendV(iov, iovcnt);
+}
+
+int AsyncSocketAdapter::SendFile(int fd, int64_t offset, size_t count) {
+  return socket_->SendFile(fd, offset, count);
+}
+
 int AsyncSocketAdapter::Recv(void* pv, size_t cb, int64_t* timestamp) {
   return socket_->Recv(pv, cb, timestamp);
 }
@@ -107,6 +115,17 @@ int AsyncSocketAdapter::SetOption(Option opt, int value) {
   return socket_->SetOption(opt, value);
 }
 
+int AsyncSocketAdapter::SetRawOption(int level, 
+                                     int name, 
+                                     const void* value, 
+                                     size_t len) {
+  return socket_->SetRawOption(level, name, value, len);
+}
+
+int AsyncSocketAdapter::GetSendDescriptor() {
+  return socket_->GetSendDescriptor();
+}
+
 void AsyncSocketAdapter::OnConnectEvent(AsyncSocket* socket) {
   SignalConnectEvent(this);
 }
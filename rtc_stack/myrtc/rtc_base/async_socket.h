@@ -58,6 +58,8 @@ class AsyncSocketAdapter : public AsyncSocket, public sigslot::has_slots<> {
   int Connect(const SocketAddress& addr) override;
   int Send(const void* pv, size_t cb) override;
   int SendTo(const void* pv, size_t cb, const SocketAddress& addr) override;
+  int SendV(const iovec* iov, int iovcnt) override;
+  int SendFile(int fd, int64_t offset, size_t count) override;
   int Recv(void* pv, size_t cb, int64_t* timestamp) override;
   int RecvFrom(void* pv,
                size_t cb,
@@ -71,6 +73,8 @@ class AsyncSocketAdapter : public AsyncSocket, public sigslot::has_slots<> {
   ConnState GetState() const override;
   int GetOption(Option opt, int* value) override;
   int SetOption(Option opt, int value) override;
+  int SetRawOption(int level, int name, const void* value, size_t len) override;
+  int GetSendDescriptor() override;
 
  protected:
   virtual void OnConnectEvent(AsyncSocket* socket);
@@ -165,6 +165,21 @@ int AsyncTCPSocketBase::FlushOutBuffer() {
   return res;
 }
 
+int AsyncTCPSocketBase::SendVDirect(const iovec* iov, int iovcnt) {
+  RTC_DCHECK(!listen_);
+  return socket_->SendV(iov, iovcnt);
+}
+
+int AsyncTCPSocketBase::SendFileDirect(int fd, int64_t offset, size_t count) {
+  RTC_DCHECK(!listen_);
+  return socket_->SendFile(fd, offset, count);
+}
+
+int AsyncTCPSocketBase::GetSendDescriptorDirect() {
+  RTC_DCHECK(!listen_);
+  return socket_->GetSendDescriptor();
+}
+
 void AsyncTCPSocketBase::AppendToOutBuffer(const void* pv, size_t cb) {
   RTC_DCHECK(outbuf_.size() + cb <= max_outsize_);
   RTC_DCHECK(!listen_);
@@ -337,7 +352,8 @@ AsyncRawTCPSocket* AsyncRawTCPSocket::Create(AsyncSocket* socket,
 AsyncRawTCPSocket::AsyncRawTCPSocket(AsyncSocket* socket, bool listen)
     : AsyncTCPSocketBase(socket, listen, kBufSize) {
 }
-
+
+
 
 int AsyncRawTCPSocket::Send(const void* pv,
                             size_t cb,
@@ -366,6 +382,58 @@ int AsyncRawTCPSocket::Send(const void* pv,
   return static_cast<int>(cb);
 }
 
+int AsyncRawTCPSocket::SendV(const iovec* iov,
+                             int iovcnt,
+                             const rtc::PacketOptions& options) {
+  // If we are blocking on send
+  if (!IsOutBufferEmpty()) {
+    SetError(EWOULDBLOCK);
+    return -1;
+  }
+
+  int res = SendVDirect(iov, iovcnt);
+  if (res <= 0) {
+    return res;
+  }
+
+  rtc::SentPacket sent_packet(options.packet_id, rtc::TimeMillis(),
+                              options.info_signaled_after_sent);
+  CopySocketInformationToPacketInfo(res, *this, false, &sent_packet.info);
+  SignalSentPacket(this, sent_packet);
+
+  return res;
+}
+
+int AsyncRawTCPSocket::SendFile(int fd,
+                                int64_t offset,
+                                size_t count,
+                                const rtc::PacketOptions& options) {
+  // If we are blocking on send
+  if (!IsOutBufferEmpty()) {
+    SetError(EWOULDBLOCK);
+    return -1;
+  }
+
+  int res = SendFileDirect(fd, offset, count);
+  if (res <= 0) {
+    return res;
+  }
+
+  rtc::SentPacket sent_packet(options.packet_id, rtc::TimeMillis(),
+                              options.info_signaled_after_sent);
+  CopySocketInformationToPacketInfo(res, *this, false, &sent_packet.info);
+  SignalSentPacket(this, sent_packet);
+
+  return res;
+}
+
+int AsyncRawTCPSocket::GetSendDescriptor() {
+  if (!IsOutBufferEmpty()) {
+    return -1;
+  }
+  return GetSendDescriptorDirect();
+}
+
 void AsyncRawTCPSocket::ProcessInput(char* data, size_t* len) {
   SocketAddress remote_addr(GetRemoteAddress());
 
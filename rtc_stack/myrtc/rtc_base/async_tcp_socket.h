@@ -59,6 +59,12 @@ class AsyncTCPSocketBase : public AsyncPacketSocket {
                                     const SocketAddress& bind_address,
                                     const SocketAddress& remote_address);
   int FlushOutBuffer();
+  // Send |iov| to the socket directly, bypass |outbuf_|.
+  int SendVDirect(const iovec* iov, int iovcnt);
+  // Send the file to the socket directly, bypass |outbuf_|.
+  int SendFileDirect(int fd, int64_t offset, size_t count);
+  // The descriptor of the socket to write directly, bypass |outbuf_|.
+  int GetSendDescriptorDirect();
   // Add data to |outbuf_|.
   void AppendToOutBuffer(const void* pv, size_t cb);
 
@@ -123,6 +129,18 @@ class AsyncRawTCPSocket : public AsyncTCPSocketBase {
   int Send(const void* pv,
            size_t cb,
            const rtc::PacketOptions& options) override;
+  // Unlike Send, the data isn't copied to the out buffer, returns the bytes
+  // sent and the caller keeps the rest, SignalReadyToSend when writable.
+  int SendV(const iovec* iov,
+            int iovcnt,
+            const rtc::PacketOptions& options) override;
+  // Like SendV, the file is sent by the socket without copying.
+  int SendFile(int fd,
+               int64_t offset,
+               size_t count,
+               const rtc::PacketOptions& options) override;
+  // -1 if blocking on send, for the bytes must follow the out buffer.
+  int GetSendDescriptor() override;
   void ProcessInput(char* data, size_t* len) override;
   void HandleIncomingConnection(AsyncSocket* socket) override;
 
@@ -18,9 +18,23 @@
 #include <openssl/x509.h>
 #include <openssl/conf.h>
 #include <openssl/engine.h>
+#include <openssl/kdf.h>
+
+#if defined(WEBRTC_LINUX)
+#include <linux/tls.h>
+#include <netinet/tcp.h>
+
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#endif
 
 #include <string.h>
 #include <time.h>
+#include <algorithm>
 #include <memory>
 
 #include "rtc_base/checks.h"
@@ -131,6 +145,83 @@ static long socket_ctrl(BIO* b, int cmd, long num, void* ptr) {  // NOLINT
   }
 }
 
+#if defined(WEBRTC_LINUX)
+// HKDF-Expand-Label of TLS 1.3 with the empty context, RFC 8446 7.1.
+static bool Tls13ExpandLabel(const EVP_MD* md,
+                             const std::string& secret,
+                             const char* label,
+                             unsigned char* out,
+                             size_t out_len) {
+  std::string full = std::string("tls13 ") + label;
+  std::string info;
+  info.push_back(static_cast<char>(out_len >> 8));
+  info.push_back(static_cast<char>(out_len & 0xFF));
+  info.push_back(static_cast<char>(full.size()));
+  info.append(full);
+  info.push_back(0);
+
+  EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr);
+  bool ok = pctx && EVP_PKEY_derive_init(pctx) > 0 &&
+      EVP_PKEY_CTX_hkdf_mode(pctx, EVP_PKEY_HKDEF_MODE_EXPAND_ONLY) > 0 &&
+      EVP_PKEY_CTX_set_hkdf_md(pctx, md) > 0 &&
+      EVP_PKEY_CTX_set1_hkdf_key(pctx, 
+          reinterpret_cast<const unsigned char*>(secret.data()), 
+          static_cast<int>(secret.size())) > 0 &&
+      EVP_PKEY_CTX_add1_hkdf_info(pctx, 
+          reinterpret_cast<const unsigned char*>(info.data()), 
+          static_cast<int>(info.size())) > 0 &&
+      EVP_PKEY_derive(pctx, out, &out_len) > 0;
+  EVP_PKEY_CTX_free(pctx);
+  return ok;
+}
+
+// The key block of TLS 1.2, RFC 5246 6.3.
+static bool Tls12KeyBlock(SSL* ssl,
+                          const EVP_MD* md,
+                          unsigned char* out,
+                          size_t out_len) {
+  unsigned char master[SSL_MAX_MASTER_KEY_LENGTH];
+  size_t master_len = SSL_SESSION_get_master_key(
+      SSL_get_session(ssl), master, sizeof(master));
+  unsigned char seed[SSL3_RANDOM_SIZE * 2];
+  SSL_get_server_random(ssl, seed, SSL3_RANDOM_SIZE);
+  SSL_get_client_random(ssl, seed + SSL3_RANDOM_SIZE, SSL3_RANDOM_SIZE);
+
+  static const char kLabel[] = "key expansion";
+  EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_TLS1_PRF, nullptr);
+  bool ok = master_len > 0 && pctx && EVP_PKEY_derive_init(pctx) > 0 &&
+      EVP_PKEY_CTX_set_tls1_prf_md(pctx, md) > 0 &&
+      EVP_PKEY_CTX_set1_tls1_prf_secret(pctx, master, 
+          static_cast<int>(master_len)) > 0 &&
+      EVP_PKEY_CTX_add1_tls1_prf_seed(pctx, 
+          reinterpret_cast<const unsigned char*>(kLabel), 
+          static_cast<int>(sizeof(kLabel) - 1)) > 0 &&
+      EVP_PKEY_CTX_add1_tls1_prf_seed(pctx, seed, sizeof(seed)) > 0 &&
+      EVP_PKEY_derive(pctx, out, &out_len) > 0;
+  EVP_PKEY_CTX_free(pctx);
+  OPENSSL_cleanse(master, sizeof(master));
+  return ok;
+}
+
+// Fill the crypto info of AES-GCM for TLS_TX, |iv| is the 4 bytes salt 
+// and 8 bytes nonce.
+template <class CryptoInfo>
+static void FillCryptoInfo(CryptoInfo& info, 
+                           int version,
+                           int cipher,
+                           const unsigned char* key, 
+                           const unsigned char* iv, 
+                           const unsigned char* seq) {
+  memset(&info, 0, sizeof(info));
+  info.info.version = version;
+  info.info.cipher_type = cipher;
+  memcpy(info.key, key, sizeof(info.key));
+  memcpy(info.salt, iv, sizeof(info.salt));
+  memcpy(info.iv, iv + sizeof(info.salt), sizeof(info.iv));
+  memcpy(info.rec_seq, seq, sizeof(info.rec_seq));
+}
+#endif
+
 static void LogSslError() {
   // Walk down the error stack to find the SSL error.
   uint32_t error_code;
@@ -250,6 +341,10 @@ void OpenSSLAdapter::SetHostName(const char* hostname) {
   ssl_host_name_ = hostname;
 }
 
+void OpenSSLAdapter::SetKernelTls(bool enable) {
+  kernel_tls_ = enable;
+}
+
 AsyncSocket* OpenSSLAdapter::Accept(SocketAddress* paddr) {
   RTC_DCHECK(role_ == SSL_SERVER);
   AsyncSocket* socket = SSLAdapter::Accept(paddr);
@@ -261,6 +356,7 @@ AsyncSocket* OpenSSLAdapter::Accept(SocketAddress* paddr) {
   adapter->SetIdentity(identity_->GetReference());
   adapter->SetRole(rtc::SSL_SERVER);
   adapter->SetIgnoreBadCert(ignore_bad_cert_);
+  adapter->SetKernelTls(kernel_tls_);
   adapter->StartSSL(ssl_host_name_.c_str(), false);
   return adapter;
 }
@@ -337,6 +433,15 @@ int OpenSSLAdapter::BeginSSL() {
   SSL_set_mode(ssl_, SSL_MODE_ENABLE_PARTIAL_WRITE |
                          SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
 
+  // The kernel takes over the sending after the handshake, so nothing is 
+  // written in user space after it: no session ticket of TLS 1.3, whose 
+  // sequence is unknown, and no renegotiation of TLS 1.2.
+  if (kernel_tls_ && role_ == SSL_SERVER) {
+    SSL_CTX_set_keylog_callback(ssl_ctx_, &OpenSSLAdapter::KeyLogCallback);
+    SSL_set_num_tickets(ssl_, 0);
+    SSL_set_options(ssl_, SSL_OP_NO_RENEGOTIATION);
+  }
+
   // Enable SNI, if a hostname is supplied.
   if (!ssl_host_name_.empty()) {
     SSL_set_tlsext_host_name(ssl_, ssl_host_name_.c_str());
@@ -411,6 +516,15 @@ int OpenSSLAdapter::ContinueSSL() {
 
       // handle shark done
       state_ = SSL_CONNECTED;
+
+      if (kernel_tls_ && role_ == SSL_SERVER) {
+        kernel_tx_ = EnableKernelTls();
+        RTC_LOG(LS_INFO) << "kernel tls " << (kernel_tx_ ? "on" : "off")
+                         << ", " << SSL_get_version(ssl_) << " "
+                         << SSL_get_cipher_name(ssl_);
+        OPENSSL_cleanse(&tx_secret_[0], tx_secret_.size());
+        tx_secret_.clear();
+      }
       AsyncSocketAdapter::OnConnectEvent(this);
       break;
 
@@ -456,6 +570,7 @@ void OpenSSLAdapter::Cleanup() {
   ssl_write_needs_read_ = false;
   custom_cert_verifier_status_ = false;
   pending_data_.Clear();
+  kernel_tx_ = false;
 
   if (ssl_) {
     SSL_free(ssl_);
@@ -510,10 +625,96 @@ int OpenSSLAdapter::DoSslWrite(const void* pv, size_t cb, int* error) {
   return SOCKET_ERROR;
 }
 
+bool OpenSSLAdapter::EnableKernelTls() {
+#if defined(WEBRTC_LINUX)
+  int version = SSL_version(ssl_);
+  const SSL_CIPHER* cipher = SSL_get_current_cipher(ssl_);
+  if (!cipher || 
+      (version != TLS1_2_VERSION && version != TLS1_3_VERSION)) {
+    return false;
+  }
+
+  size_t key_len = 0;
+  switch (SSL_CIPHER_get_cipher_nid(cipher)) {
+    case NID_aes_128_gcm:
+      key_len = TLS_CIPHER_AES_GCM_128_KEY_SIZE;
+      break;
+    case NID_aes_256_gcm:
+      key_len = TLS_CIPHER_AES_GCM_256_KEY_SIZE;
+      break;
+    default:
+      return false;
+  }
+  const EVP_MD* md = SSL_CIPHER_get_handshake_digest(cipher);
+
+  // the key, the salt and the nonce of the server writing.
+  unsigned char key[32];
+  unsigned char iv[12];
+  // the server Finished of TLS 1.2 is the first record of the new keys.
+  unsigned char seq[8] = {0};
+  if (version == TLS1_3_VERSION) {
+    if (tx_secret_.empty() || 
+        !Tls13ExpandLabel(md, tx_secret_, "key", key, key_len) ||
+        !Tls13ExpandLabel(md, tx_secret_, "iv", iv, sizeof(iv))) {
+      return false;
+    }
+  } else {
+    // client_write_key, server_write_key, client_write_IV, server_write_IV,
+    // and the explicit nonce is the sequence like OpenSSL.
+    unsigned char block[2 * 32 + 2 * 4];
+    if (!Tls12KeyBlock(ssl_, md, block, 2 * key_len + 2 * 4)) {
+      return false;
+    }
+    seq[7] = 1;
+    memcpy(key, block + key_len, key_len);
+    memcpy(iv, block + 2 * key_len + 4, 4);
+    memcpy(iv + 4, seq, sizeof(seq));
+    OPENSSL_cleanse(block, sizeof(block));
+  }
+
+  int kversion = (version == TLS1_3_VERSION) ? TLS_1_3_VERSION 
+                                             : TLS_1_2_VERSION;
+  int ret = -1;
+  static const char kUlp[] = "tls";
+  if (socket_->SetRawOption(SOL_TCP, TCP_ULP, kUlp, sizeof(kUlp)) == 0) {
+    // if it fails, the socket sends the records of user space as before.
+    if (key_len == TLS_CIPHER_AES_GCM_128_KEY_SIZE) {
+      tls12_crypto_info_aes_gcm_128 info;
+      FillCryptoInfo(info, kversion, TLS_CIPHER_AES_GCM_128, key, iv, seq);
+      ret = socket_->SetRawOption(SOL_TLS, TLS_TX, &info, sizeof(info));
+      OPENSSL_cleanse(&info, sizeof(info));
+    } else {
+      tls12_crypto_info_aes_gcm_256 info;
+      FillCryptoInfo(info, kversion, TLS_CIPHER_AES_GCM_256, key, iv, seq);
+      ret = socket_->SetRawOption(SOL_TLS, TLS_TX, &info, sizeof(info));
+      OPENSSL_cleanse(&info, sizeof(info));
+    }
+  }
+  OPENSSL_cleanse(key, sizeof(key));
+  OPENSSL_cleanse(iv, sizeof(iv));
+
+  if (ret != 0) {
+    return false;
+  }
+
+  // the records encrypted in user space would break the stream of kernel, 
+  // like the alerts, drop them.
+  SSL_set0_wbio(ssl_, BIO_new(BIO_s_null()));
+  return true;
+#else
+  return false;
+#endif
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // AsyncSocket Implementation
 ///////////////////////////////////////////////////////////////////////////////
 int OpenSSLAdapter::Send(const void* pv, size_t cb) {
+  // the plain data is encrypted by the kernel.
+  if (kernel_tx_) {
+    return AsyncSocketAdapter::Send(pv, cb);
+  }
+
   switch (state_) {
     case SSL_NONE:
       return AsyncSocketAdapter::Send(pv, cb);
@@ -596,6 +797,48 @@ int OpenSSLAdapter::Send(const void* pv, size_t cb) {
   return ret;
 }
 
+int OpenSSLAdapter::SendV(const iovec* iov, int iovcnt) {
+  if (state_ == SSL_NONE || kernel_tx_) {
+    return AsyncSocketAdapter::SendV(iov, iovcnt);
+  }
+
+  // SSL_write takes one record at most, split the buffers into records.
+  static constexpr size_t kMaxRecordSize = 16 * 1024;
+  int total = 0;
+  for (int i = 0; i < iovcnt; ++i) {
+    const uint8_t* data = static_cast<const uint8_t*>(iov[i].iov_base);
+    size_t left = iov[i].iov_len;
+    while (left > 0) {
+      size_t size = std::min(left, kMaxRecordSize);
+      int ret = Send(data, size);
+      if (ret < 0) {
+        return total > 0 ? total : ret;
+      }
+      total += ret;
+      if (static_cast<size_t>(ret) < size) {
+        return total;
+      }
+      data += ret;
+      left -= ret;
+    }
+  }
+  return total;
+}
+
+int OpenSSLAdapter::SendFile(int fd, int64_t offset, size_t count) {
+  if (state_ == SSL_NONE || kernel_tx_) {
+    return AsyncSocketAdapter::SendFile(fd, offset, count);
+  }
+  return Socket::SendFile(fd, offset, count);
+}
+
+int OpenSSLAdapter::GetSendDescriptor() {
+  if (state_ == SSL_NONE || kernel_tx_) {
+    return AsyncSocketAdapter::GetSendDescriptor();
+  }
+  return -1;
+}
+
 int OpenSSLAdapter::SendTo(const void* pv,
                            size_t cb,
                            const SocketAddress& addr) {
@@ -834,6 +1077,26 @@ int OpenSSLAdapter::NewSSLSessionCallback(SSL* ssl, SSL_SESSION* session) {
   return 1;  // We've taken ownership of the session; OpenSSL shouldn't free it.
 }
 
+void OpenSSLAdapter::KeyLogCallback(const SSL* ssl, const char* line) {
+  // SERVER_TRAFFIC_SECRET_0 <client random> <secret>
+  static const char kLabel[] = "SERVER_TRAFFIC_SECRET_0 ";
+  if (strncmp(line, kLabel, sizeof(kLabel) - 1) != 0) {
+    return;
+  }
+
+  const char* secret = strrchr(line, ' ');
+  OpenSSLAdapter* adapter =
+      reinterpret_cast<OpenSSLAdapter*>(SSL_get_app_data(ssl));
+  if (!secret || !adapter) {
+    return;
+  }
+
+  char buffer[EVP_MAX_MD_SIZE];
+  size_t len = hex_decode(buffer, sizeof(buffer), std::string(secret + 1));
+  adapter->tx_secret_.assign(buffer, len);
+  OPENSSL_cleanse(buffer, sizeof(buffer));
+}
+
 SSL_CTX* OpenSSLAdapter::CreateContext(SSLMode mode, bool enable_cache) {
   SSL_CTX* ctx =
       SSL_CTX_new(mode == SSL_MODE_DTLS ? DTLS_method() : TLS_method());
@@ -61,6 +61,11 @@ class OpenSSLAdapter final : public SSLAdapter, public MessageHandler {
   int StartSSL(const char* hostname, bool restartable) override;
   int Send(const void* pv, size_t cb) override;
   int SendTo(const void* pv, size_t cb, const SocketAddress& addr) override;
+  int SendV(const iovec* iov, int iovcnt) override;
+  // The file is encrypted in user space, read and sent by Send.
+  int SendFile(int fd, int64_t offset, size_t count) override;
+  // Only the plain or kernel TLS socket can be written directly.
+  int GetSendDescriptor() override;
   int Recv(void* pv, size_t cb, int64_t* timestamp) override;
   int RecvFrom(void* pv,
                size_t cb,
@@ -85,6 +90,7 @@ class OpenSSLAdapter final : public SSLAdapter, public MessageHandler {
   void OnCloseEvent(AsyncSocket* socket, int err) override;
 
   void SetHostName(const char* hostname) override;
+  void SetKernelTls(bool enable) override;
 
  private:
   enum SSLState {
@@ -105,6 +111,8 @@ class OpenSSLAdapter final : public SSLAdapter, public MessageHandler {
   // Return value and arguments have the same meanings as for Send; |error| is
   // an output parameter filled with the result of SSL_get_error.
   int DoSslWrite(const void* pv, size_t cb, int* error);
+  // Install the sending keys to the kernel, returns false if not supported.
+  bool EnableKernelTls();
   void OnMessage(Message* msg) override;
   bool SSLPostConnectionCheck(SSL* ssl, const std::string& host);
 
@@ -120,6 +128,9 @@ class OpenSSLAdapter final : public SSLAdapter, public MessageHandler {
   // to allow its SSL_SESSION* to be cached for later resumption.
   static int NewSSLSessionCallback(SSL* ssl, SSL_SESSION* session);
 
+  // Takes the TLS 1.3 traffic secret of sending for the kernel TLS.
+  static void KeyLogCallback(const SSL* ssl, const char* line);
+
   // Optional SSL Shared session cache to improve performance.
   OpenSSLSessionCache* ssl_session_cache_ = nullptr;
   // Optional SSL Certificate verifier which can be set by a third party.
@@ -154,6 +165,11 @@ class OpenSSLAdapter final : public SSLAdapter, public MessageHandler {
   // Holds the result of the call to run of the ssl_cert_verify_->Verify()
   bool custom_cert_verifier_status_;
   bool need_on_write_{false};
+  // Whether try the kernel TLS, and whether the kernel encrypts the sending.
+  bool kernel_tls_{false};
+  bool kernel_tx_{false};
+  // The TLS 1.3 traffic secret of sending, cleared after the handshake.
+  std::string tx_secret_;
 #if 0
   FILE* pfile_{nullptr};
 #endif
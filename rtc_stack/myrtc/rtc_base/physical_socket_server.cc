@@ -53,6 +53,7 @@
 
 #if defined(WEBRTC_LINUX)
 #include <linux/sockios.h>
+#include <sys/sendfile.h>
 #endif
 
 #if defined(WEBRTC_WIN)
@@ -310,6 +311,16 @@ int PhysicalSocket::SetOption(Option opt, int value) {
   return ::setsockopt(s_, slevel, sopt, (SockOptArg)&value, sizeof(value));
 }
 
+int PhysicalSocket::SetRawOption(int level, 
+                                 int name, 
+                                 const void* value, 
+                                 size_t len) {
+  int ret = ::setsockopt(s_, level, name, (SockOptArg)value, 
+                         static_cast<socklen_t>(len));
+  UpdateLastError();
+  return ret;
+}
+
 int PhysicalSocket::Send(const void* pv, size_t cb) {
   int sent = DoSend(
       s_, reinterpret_cast<const char*>(pv), static_cast<int>(cb),
@@ -335,6 +346,46 @@ int PhysicalSocket::Send(const void* pv, size_t cb) {
   return sent;
 }
 
+int PhysicalSocket::SendV(const iovec* iov, int iovcnt) {
+  size_t total = 0;
+  for (int i = 0; i < iovcnt; ++i) {
+    total += iov[i].iov_len;
+  }
+
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = const_cast<iovec*>(iov);
+  msg.msg_iovlen = iovcnt;
+  int sent = DoSendMsg(s_, &msg,
+#if defined(WEBRTC_LINUX)
+      // Suppress SIGPIPE. See above for explanation.
+      MSG_NOSIGNAL
+#else
+      0
+#endif
+  );
+  UpdateLastError();
+  MaybeRemapSendError();
+  RTC_DCHECK(sent <= static_cast<int>(total));
+  if ((sent > 0 && sent < static_cast<int>(total)) ||
+      (sent < 0 && IsBlockingError(GetError()))) {
+    EnableEvents(DE_WRITE);
+  }
+  return sent;
+}
+
+int PhysicalSocket::SendFile(int fd, int64_t offset, size_t count) {
+  int sent = DoSendFile(s_, fd, offset, count);
+  UpdateLastError();
+  MaybeRemapSendError();
+  RTC_DCHECK(sent <= static_cast<int>(count));
+  if ((sent > 0 && sent < static_cast<int>(count)) ||
+      (sent < 0 && IsBlockingError(GetError()))) {
+    EnableEvents(DE_WRITE);
+  }
+  return sent;
+}
+
 int PhysicalSocket::SendTo(const void* buffer,
                            size_t length,
                            const SocketAddress& addr) {
@@ -470,6 +521,31 @@ int PhysicalSocket::DoSend(SOCKET socket, const char* buf, int len, int flags) {
   return ::send(socket, buf, len, flags);
 }
 
+int PhysicalSocket::DoSendMsg(SOCKET socket, const msghdr* msg, int flags) {
+  return ::sendmsg(socket, msg, flags);
+}
+
+int PhysicalSocket::DoSendFile(SOCKET socket, 
+                               int fd, 
+                               int64_t offset, 
+                               size_t count) {
+#if defined(WEBRTC_LINUX)
+  // sendfile takes no MSG_NOSIGNAL, block SIGPIPE on the sending thread 
+  // instead, or the closed peer terminates the process.
+  static thread_local bool sigpipe_blocked = [] {
+    sigset_t sigpipe_mask;
+    sigemptyset(&sigpipe_mask);
+    sigaddset(&sigpipe_mask, SIGPIPE);
+    return pthread_sigmask(SIG_BLOCK, &sigpipe_mask, nullptr) == 0;
+  }();
+  RTC_DCHECK(sigpipe_blocked);
+  off_t off = static_cast<off_t>(offset);
+  return static_cast<int>(::sendfile(socket, fd, &off, count));
+#else
+  return Socket::SendFile(fd, offset, count);
+#endif
+}
+
 int PhysicalSocket::DoSendTo(SOCKET socket,
                              const char* buf,
                              int len,
@@ -562,6 +638,15 @@ int PhysicalSocket::TranslateOption(Option opt, int* slevel, int* sopt) {
       *slevel = SOL_SOCKET;
       *sopt = SO_REUSEADDR;
       break;
+    case OPT_REUSEPORT:
+#if defined(SO_REUSEPORT)
+      *slevel = SOL_SOCKET;
+      *sopt = SO_REUSEPORT;
+      break;
+#else
+      RTC_LOG(LS_WARNING) << "Socket::OPT_REUSEPORT not supported.";
+      return -1;
+#endif
     default:
       RTC_NOTREACHED();
       return -1;
@@ -153,11 +153,15 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
 
   int GetOption(Option opt, int* value) override;
   int SetOption(Option opt, int value) override;
+  int SetRawOption(int level, int name, const void* value, size_t len) override;
+  int GetSendDescriptor() override { return s_; }
 
   int Send(const void* pv, size_t cb) override;
   int SendTo(const void* buffer,
              size_t length,
              const SocketAddress& addr) override;
+  int SendV(const iovec* iov, int iovcnt) override;
+  int SendFile(int fd, int64_t offset, size_t count) override;
 
   int Recv(void* buffer, size_t length, int64_t* timestamp) override;
   int RecvFrom(void* buffer,
@@ -181,6 +185,12 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
   // Make virtual so ::send can be overwritten in tests.
   virtual int DoSend(SOCKET socket, const char* buf, int len, int flags);
 
+  // Make virtual so ::sendmsg can be overwritten in tests.
+  virtual int DoSendMsg(SOCKET socket, const msghdr* msg, int flags);
+
+  // Make virtual so ::sendfile can be overwritten in tests.
+  virtual int DoSendFile(SOCKET socket, int fd, int64_t offset, size_t count);
+
   // Make virtual so ::sendto can be overwritten in tests.
   virtual int DoSendTo(SOCKET socket,
                        const char* buf,
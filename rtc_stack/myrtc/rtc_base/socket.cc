@@ -10,4 +10,62 @@
 
 #include "rtc_base/socket.h"
 
-namespace rtc {}  // namespace rtc
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace rtc {
+
+int Socket::SendV(const iovec* iov, int iovcnt) {
+  int total = 0;
+  for (int i = 0; i < iovcnt; ++i) {
+    int len = static_cast<int>(iov[i].iov_len);
+    int sent = Send(iov[i].iov_base, len);
+    if (sent < 0) {
+      return total > 0 ? total : sent;
+    }
+    total += sent;
+    if (sent < len) {
+      break;
+    }
+  }
+  return total;
+}
+
+int Socket::SetRawOption(int, int, const void*, size_t) {
+  SetError(ENOPROTOOPT);
+  return -1;
+}
+
+int Socket::GetSendDescriptor() {
+  return -1;
+}
+
+int Socket::SendFile(int fd, int64_t offset, size_t count) {
+  char buf[16 * 1024];
+  int total = 0;
+  while (count > 0) {
+    ssize_t nread = ::pread(fd, buf, std::min(count, sizeof(buf)), offset);
+    if (nread <= 0) {
+      if (total > 0) {
+        return total;
+      }
+      // the file is shorter than expected.
+      SetError(nread < 0 ? errno : EINVAL);
+      return -1;
+    }
+    int sent = Send(buf, nread);
+    if (sent < 0) {
+      return total > 0 ? total : sent;
+    }
+    total += sent;
+    offset += sent;
+    count -= sent;
+    if (sent < nread) {
+      break;
+    }
+  }
+  return total;
+}
+
+}  // namespace rtc
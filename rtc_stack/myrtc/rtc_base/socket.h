@@ -18,6 +18,7 @@
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #define SOCKET_EACCES EACCES
 #endif
 
@@ -140,6 +141,14 @@ class Socket {
   virtual int Connect(const SocketAddress& addr) = 0;
   virtual int Send(const void* pv, size_t cb) = 0;
   virtual int SendTo(const void* pv, size_t cb, const SocketAddress& addr) = 0;
+  // Send the buffers of |iov| in order, returns the bytes sent which may be
+  // less than the total, or -1 if nothing is sent. The default sends them
+  // one by one, override it to send all of them by one system call.
+  virtual int SendV(const iovec* iov, int iovcnt);
+  // Send |count| bytes of the file |fd| from |offset|, returns the bytes sent
+  // like SendV. The default reads the file and sends it by Send, override it
+  // to send without copying the file to user space.
+  virtual int SendFile(int fd, int64_t offset, size_t count);
   // |timestamp| is in units of microseconds.
   virtual int Recv(void* pv, size_t cb, int64_t* timestamp) = 0;
   virtual int RecvFrom(void* pv,
@@ -164,11 +173,19 @@ class Socket {
     OPT_IPV6_V6ONLY,           // Whether the socket is IPv6 only.
     OPT_DSCP,                  // DSCP code
     OPT_RTP_SENDTIME_EXTN_ID,  // This is a non-traditional socket option param.
-    OPT_REUSEADDR              // This is specific to libjingle and will be used
+    OPT_REUSEADDR,             // This is specific to libjingle and will be used
                                // if SendTime option is needed at socket level.
+    OPT_REUSEPORT              // bind many sockets to one port, the kernel
+                               // balances the connections among them.
   };
   virtual int GetOption(Option opt, int* value) = 0;
   virtual int SetOption(Option opt, int value) = 0;
+  // Set the option not abstracted by Option by setsockopt, such as the 
+  // kernel TLS. The default fails with ENOPROTOOPT.
+  virtual int SetRawOption(int level, int name, const void* value, size_t len);
+  // The descriptor the plain bytes can be written to directly, bypassing
+  // this socket, such as by io_uring. The default returns -1 for none.
+  virtual int GetSendDescriptor();
 
  protected:
   Socket() {}
@@ -62,6 +62,26 @@ int BufferedReadAdapter::Send(const void* pv, size_t cb) {
   return AsyncSocketAdapter::Send(pv, cb);
 }
 
+int BufferedReadAdapter::SendV(const iovec* iov, int iovcnt) {
+  if (buffering_) {
+    socket_->SetError(EWOULDBLOCK);
+    return -1;
+  }
+  return AsyncSocketAdapter::SendV(iov, iovcnt);
+}
+
+int BufferedReadAdapter::SendFile(int fd, int64_t offset, size_t count) {
+  if (buffering_) {
+    socket_->SetError(EWOULDBLOCK);
+    return -1;
+  }
+  return AsyncSocketAdapter::SendFile(fd, offset, count);
+}
+
+int BufferedReadAdapter::GetSendDescriptor() {
+  return buffering_ ? -1 : AsyncSocketAdapter::GetSendDescriptor();
+}
+
 int BufferedReadAdapter::Recv(void* pv, size_t cb, int64_t* timestamp) {
   if (buffering_) {
     socket_->SetError(EWOULDBLOCK);
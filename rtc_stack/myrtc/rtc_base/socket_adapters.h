@@ -35,6 +35,9 @@ class BufferedReadAdapter : public AsyncSocketAdapter {
   ~BufferedReadAdapter() override;
 
   int Send(const void* pv, size_t cb) override;
+  int SendV(const iovec* iov, int iovcnt) override;
+  int SendFile(int fd, int64_t offset, size_t count) override;
+  int GetSendDescriptor() override;
   int Recv(void* pv, size_t cb, int64_t* timestamp) override;
 
  protected:
@@ -87,9 +87,14 @@ class SSLAdapter : public AsyncSocketAdapter {
   // indicates whether the current session is a resumption of a previous
   // session.
   virtual bool IsResumedSession() = 0;
-
+
+
   virtual void SetHostName(const char* hostname) = 0;
 
+  // Encrypt the sending by the kernel (kTLS) after the handshake, fall back
+  // to the user space if the kernel or the cipher does not support it.
+  virtual void SetKernelTls(bool enable) = 0;
+
   // Create the default SSL adapter for this platform. On failure, returns null
   // and deletes |socket|. Otherwise, the returned SSLAdapter takes ownership
   // of |socket|.
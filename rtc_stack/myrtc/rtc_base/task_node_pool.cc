@@ -0,0 +1,143 @@
+//
+// Copyright (c) 2021- anjisuan783
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "rtc_base/task_node_pool.h"
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <new>
+
+namespace webrtc {
+
+namespace {
+
+struct NodeCache;
+
+// The header of each node.
+struct alignas(16) Node {
+  // null if not cached, the large ones.
+  NodeCache* owner;
+  Node* next;
+};
+
+struct NodeCache {
+  // by the owner thread only.
+  Node* local{nullptr};
+  size_t count{0};
+  // freed by the other threads, the consumers of the task queues.
+  alignas(64) std::atomic<Node*> remote{nullptr};
+  // the thread exited, the nodes back are freed.
+  std::atomic<bool> orphaned{false};
+};
+
+void freeList(Node* n) {
+  while (n) {
+    Node* next = n->next;
+    ::free(n);
+    n = next;
+  }
+}
+
+thread_local NodeCache* t_cache = nullptr;
+thread_local bool t_exited = false;
+
+// The cache is kept after the thread exits, the nodes out still point to
+// it, only the ones cached are freed.
+struct CacheHolder {
+  ~CacheHolder() {
+    NodeCache* cache = t_cache;
+    t_cache = nullptr;
+    t_exited = true;
+    freeList(cache->local);
+    cache->local = nullptr;
+    // seq_cst with the check of Free, a node pushed after the drain is
+    // freed by its pusher.
+    cache->orphaned.store(true);
+    freeList(cache->remote.exchange(nullptr));
+  }
+};
+
+NodeCache* currentCache() {
+  if (!t_cache && !t_exited) {
+    static thread_local CacheHolder holder;
+    t_cache = new NodeCache;
+  }
+  return t_cache;
+}
+
+Node* newNode(NodeCache* owner, size_t size) {
+  Node* n = reinterpret_cast<Node*>(::malloc(sizeof(Node) + size));
+  if (!n) {
+    throw std::bad_alloc();
+  }
+  n->owner = owner;
+  n->next = nullptr;
+  return n;
+}
+
+}  // namespace
+
+void* TaskNodePool::Alloc(size_t size) {
+  NodeCache* cache = size <= kNodeSize ? currentCache() : nullptr;
+  if (!cache) {
+    return newNode(nullptr, size) + 1;
+  }
+
+  if (!cache->local) {
+    // take back all the ones freed by the others, not counted.
+    cache->local = cache->remote.exchange(nullptr, std::memory_order_acquire);
+  }
+
+  Node* n = cache->local;
+  if (n) {
+    cache->local = n->next;
+    cache->count -= (cache->count > 0);
+  } else {
+    n = newNode(cache, kNodeSize);
+  }
+  return n + 1;
+}
+
+void TaskNodePool::Free(void* p) {
+  if (!p) {
+    return;
+  }
+
+  Node* n = reinterpret_cast<Node*>(p) - 1;
+  NodeCache* owner = n->owner;
+  if (!owner) {
+    ::free(n);
+    return;
+  }
+
+  if (owner == t_cache) {
+    if (owner->count >= kMaxCached) {
+      ::free(n);
+      return;
+    }
+    n->next = owner->local;
+    owner->local = n;
+    ++owner->count;
+    return;
+  }
+
+  if (owner->orphaned.load()) {
+    ::free(n);
+    return;
+  }
+  Node* head = owner->remote.load(std::memory_order_relaxed);
+  do {
+    n->next = head;
+  } while (!owner->remote.compare_exchange_weak(head, n));
+
+  // the owner exited meanwhile and may have drained before the push.
+  if (owner->orphaned.load()) {
+    freeList(owner->remote.exchange(nullptr));
+  }
+}
+
+}  // namespace webrtc
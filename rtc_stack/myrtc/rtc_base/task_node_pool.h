@@ -0,0 +1,30 @@
+//
+// Copyright (c) 2021- anjisuan783
+//
+// SPDX-License-Identifier: MIT
+//
+
+#ifndef __RTC_TASK_NODE_POOL_H__
+#define __RTC_TASK_NODE_POOL_H__
+
+#include <stddef.h>
+
+namespace webrtc {
+
+// The nodes of the posted tasks, the closures held inline in them. Cached
+// by the thread posting them, and given back to it by the thread running
+// them, so posting a small closure allocates nothing once warm.
+class TaskNodePool {
+ public:
+  // the closures larger are allocated by operator new.
+  static constexpr size_t kNodeSize = 192;
+  // the nodes cached by a thread, the others freed.
+  static constexpr size_t kMaxCached = 4096;
+
+  static void* Alloc(size_t size);
+  static void Free(void* p);
+};
+
+}  // namespace webrtc
+
+#endif  // __RTC_TASK_NODE_POOL_H__
@@ -0,0 +1,391 @@
+//
+// Copyright (c) 2021- anjisuan783
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "api/default_task_queue_factory.h"
+
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "api/queued_task.h"
+#include "api/task_queue_base.h"
+#include "libevent/event.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/object_pool.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/safe_conversions.h"
+#include "rtc_base/time_utils.h"
+
+namespace webrtc {
+namespace {
+
+using Priority = TaskQueueFactory::Priority;
+
+// the wakeups of all the queues.
+std::atomic<uint64_t> g_wakeups{0};
+
+rtc::ThreadPriority TaskQueuePriorityToThreadPriority(Priority priority) {
+  switch (priority) {
+    case Priority::HIGH:
+      return rtc::kRealtimePriority;
+    case Priority::LOW:
+      return rtc::kLowPriority;
+    case Priority::NORMAL:
+      return rtc::kNormalPriority;
+    default:
+      RTC_NOTREACHED();
+      break;
+  }
+  return rtc::kNormalPriority;
+}
+
+// The intrusive multi-producer single-consumer queue of Dmitry Vyukov,
+// linking the tasks by QueuedTask::next_, wait-free to push.
+class MpscTaskList {
+ public:
+  MpscTaskList() : head_{&stub_}, tail_{&stub_} {}
+
+  // any thread.
+  void Push(QueuedTask* task) {
+    task->next_.store(nullptr, std::memory_order_relaxed);
+    QueuedTask* prev = head_.exchange(task, std::memory_order_acq_rel);
+    prev->next_.store(task, std::memory_order_release);
+  }
+
+  // consumer thread only.
+  // @return nullptr if empty, or a producer is linking the next one.
+  QueuedTask* Pop() {
+    QueuedTask* tail = tail_;
+    QueuedTask* next = tail->next_.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (!next) {
+        return nullptr;
+      }
+      tail_ = next;
+      tail = next;
+      next = next->next_.load(std::memory_order_acquire);
+    }
+
+    if (next) {
+      tail_ = next;
+      return tail;
+    }
+
+    if (tail != head_.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+
+    Push(&stub_);
+    next = tail->next_.load(std::memory_order_acquire);
+    if (next) {
+      tail_ = next;
+      return tail;
+    }
+    return nullptr;
+  }
+
+ private:
+  class StubTask : public QueuedTask {
+    bool Run() override { return false; }
+  };
+
+  std::atomic<QueuedTask*> head_;
+  // keep the producers and the consumer on the different cache lines.
+  alignas(64) QueuedTask* tail_;
+  StubTask stub_;
+};
+
+//TaskQueueMpsc
+class TaskQueueMpsc final : public TaskQueueBase {
+ public:
+  TaskQueueMpsc(std::string_view queue_name, rtc::ThreadPriority priority);
+
+  void Delete() override;
+  void PostTask(std::unique_ptr<QueuedTask> task) override;
+  void PostDelayedTask(std::unique_ptr<QueuedTask> task,
+                       uint32_t milliseconds) override;
+
+ private:
+  class SetTimerTask : public QueuedTask {
+   public:
+    SetTimerTask(std::unique_ptr<QueuedTask> task, uint32_t milliseconds)
+        : task_(std::move(task)),
+          milliseconds_(milliseconds),
+          posted_(rtc::Time32()) {}
+
+   private:
+    bool Run() override {
+      // Compensate for the time that has passed since construction
+      // and until we got here.
+      uint32_t post_time = rtc::Time32() - posted_;
+      TaskQueueMpsc::Current()->PostDelayedTask(
+          std::move(task_),
+          post_time > milliseconds_ ? 0 : milliseconds_ - post_time);
+      return true;
+    }
+
+    std::unique_ptr<QueuedTask> task_;
+    const uint32_t milliseconds_;
+    const uint32_t posted_;
+  };
+
+  struct TimerEvent {
+    TimerEvent() = default;
+    ~TimerEvent() {
+      if (task_queue_)
+        event_del(&ev_);
+    }
+
+    void Init(TaskQueueMpsc* task_queue,
+              std::unique_ptr<QueuedTask> task,
+              int index) {
+      task_queue_ = task_queue;
+      task_ = std::move(task);
+      pending_timer_index_ = index;
+    }
+
+    event ev_;
+    TaskQueueMpsc* task_queue_{nullptr};
+    std::unique_ptr<QueuedTask> task_;
+    int pending_timer_index_{-1};
+  };
+
+  ~TaskQueueMpsc() override;
+
+  void NotifyWakeup();
+  void RunTasks();
+
+  static void ThreadMain(void* context);
+  static void OnWakeup(int fd, short flags, void* context);  // NOLINT
+  static void RunTimer(int fd, short flags, void* context);  // NOLINT
+
+  std::atomic<bool> quit_{false};
+  int wakeup_fd_ = -1;
+  event_base* event_base_;
+  event wakeup_event_;
+  rtc::PlatformThread thread_;
+
+  MpscTaskList pending_;
+  // the tasks pushed and not run yet, the producer turning it from 0
+  // wakes up the consumer, others don't.
+  alignas(64) std::atomic<int64_t> pending_count_{0};
+
+  // Holds a list of events pending timers for cleanup when the loop exits.
+  static const int timer_nb_ = std::numeric_limits<uint16_t>::max();
+  std::vector<int> pending_timers_index_;
+  TimerEvent* pending_timers_[timer_nb_];
+
+  ObjectPoolT<TimerEvent> timer_event_pool_;
+};
+
+// run at most the tasks once, then let the timers and io in.
+constexpr int64_t kMaxTasksOnce = 64;
+// the spins to wait for more tasks before sleeping.
+constexpr int kLingerSpins = 256;
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+TaskQueueMpsc::TaskQueueMpsc(std::string_view queue_name,
+                             rtc::ThreadPriority priority)
+    : event_base_(event_base_new()),
+      thread_(&TaskQueueMpsc::ThreadMain, this, queue_name, priority),
+      timer_event_pool_(4096) {
+  wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  RTC_CHECK(wakeup_fd_ != -1);
+
+  event_set(&wakeup_event_, wakeup_fd_, EV_READ | EV_PERSIST,
+            OnWakeup, this);
+  RTC_CHECK_EQ(0, event_base_set(event_base_, &wakeup_event_));
+  event_add(&wakeup_event_, nullptr);
+
+  pending_timers_index_.reserve(timer_nb_);
+  for (int i = 0; i < timer_nb_; ++i) {
+    pending_timers_index_.push_back(i);
+    pending_timers_[i] = nullptr;
+  }
+  thread_.Start();
+}
+
+TaskQueueMpsc::~TaskQueueMpsc() {
+  // the pending tasks are deleted without running.
+  while (QueuedTask* task = pending_.Pop()) {
+    delete task;
+  }
+}
+
+void TaskQueueMpsc::Delete() {
+  RTC_DCHECK(!IsCurrent());
+  quit_ = true;
+  NotifyWakeup();
+
+  thread_.Stop();
+
+  event_del(&wakeup_event_);
+  close(wakeup_fd_);
+  wakeup_fd_ = -1;
+
+  event_base_free(event_base_);
+  delete this;
+}
+
+void TaskQueueMpsc::NotifyWakeup() {
+  uint64_t one = 1;
+  // the counter of eventfd never overflows here, it's read on each wakeup.
+  RTC_CHECK(write(wakeup_fd_, &one, sizeof(one)) == sizeof(one));
+  g_wakeups.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TaskQueueMpsc::PostTask(std::unique_ptr<QueuedTask> task) {
+  pending_.Push(task.release());
+
+  // only the first one after the consumer drained the queue wakes it up.
+  if (pending_count_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+    NotifyWakeup();
+  }
+}
+
+void TaskQueueMpsc::PostDelayedTask(std::unique_ptr<QueuedTask> task,
+                                    uint32_t milliseconds) {
+  if (IsCurrent()) {
+    RTC_CHECK(!pending_timers_index_.empty());
+
+    int index = pending_timers_index_.back();
+    pending_timers_index_.pop_back();
+
+    TimerEvent* timer = timer_event_pool_.New();
+    pending_timers_[index] = timer;
+
+    timer->Init(this, std::move(task), index);
+    event_set(&timer->ev_, -1, 0, &TaskQueueMpsc::RunTimer, timer);
+    RTC_CHECK_EQ(0, event_base_set(event_base_, &timer->ev_));
+
+    timeval tv = {rtc::dchecked_cast<int>(milliseconds / 1000),
+                  rtc::dchecked_cast<int>(milliseconds % 1000) * 1000};
+    event_add(&timer->ev_, &tv);
+  } else {
+    PostTask(std::make_unique<SetTimerTask>(std::move(task), milliseconds));
+  }
+}
+
+void TaskQueueMpsc::RunTasks() {
+  int64_t count = std::min(
+      pending_count_.load(std::memory_order_acquire), kMaxTasksOnce);
+
+  int64_t done = 0;
+  for (; done < count; ++done) {
+    QueuedTask* task = pending_.Pop();
+    if (!task) {
+      // a producer is linking it, retry in the next loop.
+      break;
+    }
+    if (task->Run()) {
+      delete task;
+    }
+  }
+
+  // linger a moment before sleeping, the producers posting in a burst
+  // find it awake and skip the wakeup.
+  static const int linger = 
+      std::thread::hardware_concurrency() > 1 ? kLingerSpins : 0;
+  for (int i = 0; i < linger && 
+       pending_count_.load(std::memory_order_acquire) == done; ++i) {
+    CpuRelax();
+  }
+
+  // more ones pushed meanwhile, no one woke us up.
+  if (pending_count_.fetch_sub(done, std::memory_order_acq_rel) > done) {
+    event_active(&wakeup_event_, EV_READ, 0);
+  }
+}
+
+// static
+void TaskQueueMpsc::ThreadMain(void* context) {
+  TaskQueueMpsc* me = static_cast<TaskQueueMpsc*>(context);
+  {
+    CurrentTaskQueueSetter set_current(me);
+    while (!me->quit_)
+      event_base_loop(me->event_base_, 0);
+  }
+
+  for (int i = 0; i < timer_nb_; ++i) {
+    TimerEvent* timer = me->pending_timers_[i];
+    if (timer) {
+      // remove it while the event base is alive.
+      event_del(&timer->ev_);
+      timer->task_queue_ = nullptr;
+      timer->task_.reset();
+      me->timer_event_pool_.Delete(timer);
+    }
+  }
+}
+
+// static
+void TaskQueueMpsc::OnWakeup(int fd, short flags, void* context) {  // NOLINT
+  TaskQueueMpsc* me = static_cast<TaskQueueMpsc*>(context);
+  uint64_t value;
+  // nothing to read if activated by RunTasks.
+  if (read(fd, &value, sizeof(value)) < 0) {
+    RTC_DCHECK(errno == EAGAIN);
+  }
+
+  if (me->quit_) {
+    event_base_loopbreak(me->event_base_);
+    return;
+  }
+
+  me->RunTasks();
+}
+
+// static
+void TaskQueueMpsc::RunTimer(int, short, void* context) {  // NOLINT
+  TimerEvent* timer = static_cast<TimerEvent*>(context);
+  if (!timer->task_->Run())
+    timer->task_.release();
+
+  // fired, nothing to remove from the event base.
+  TaskQueueMpsc* me = timer->task_queue_;
+  timer->task_queue_ = nullptr;
+
+  int index = timer->pending_timer_index_;
+  me->pending_timers_index_.push_back(index);
+  me->pending_timers_[index] = nullptr;
+  me->timer_event_pool_.Delete(timer);
+}
+
+class TaskQueueMpscFactory final : public TaskQueueFactory {
+ public:
+  std::unique_ptr<TaskQueueBase, TaskQueueDeleter>
+    CreateTaskQueue(std::string_view name, Priority priority) const override {
+      return std::unique_ptr<TaskQueueBase, TaskQueueDeleter>(
+        new TaskQueueMpsc(name, TaskQueuePriorityToThreadPriority(priority)));
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<TaskQueueFactory> CreateMpscTaskQueueFactory() {
+  return std::make_unique<TaskQueueMpscFactory>();
+}
+
+uint64_t MpscTaskQueueWakeups() {
+  return g_wakeups.load(std::memory_order_relaxed);
+}
+
+}  // namespace webrtc
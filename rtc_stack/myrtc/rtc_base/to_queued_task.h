@@ -16,6 +16,7 @@
 #include <utility>
 
 #include "api/queued_task.h"
+#include "rtc_base/task_node_pool.h"
 
 namespace webrtc {
 namespace webrtc_new_closure_impl {
@@ -30,6 +31,11 @@ class ClosureTask : public QueuedTask {
       : closure_(std::forward<Closure>(closure)) {
     location_ = location;
   }
+
+  // the closure inline in a pooled node, no allocation to post it.
+  static void* operator new(size_t size) { return TaskNodePool::Alloc(size); }
+  static void operator delete(void* p) { TaskNodePool::Free(p); }
+
  private:
   bool Run() override {
     closure_();
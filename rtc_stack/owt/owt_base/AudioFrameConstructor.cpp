@@ -73,6 +73,7 @@ AudioFrameConstructor::~AudioFrameConstructor() {
 
 void AudioFrameConstructor::close() {
   unbindTransport();
+  packet_sink_ = nullptr;
   if (audioReceive_) {
     rtcAdapter_->destoryAudioReceiver(audioReceive_);
     audioReceive_ = nullptr;
@@ -108,6 +109,10 @@ int AudioFrameConstructor::deliverAudioData_(
     return 0;
   }
 
+  if (packet_sink_ && enabled_) {
+    packet_sink_->deliverAudioData(audio_packet);
+  }
+
   erizo::RtcpHeader* chead = 
       reinterpret_cast<erizo::RtcpHeader*>(audio_packet->data);
 
@@ -171,7 +176,7 @@ int AudioFrameConstructor::deliverAudioData_(
 void AudioFrameConstructor::onFeedback(const FeedbackMsg& msg) {
   if (msg.type == owt_base::AUDIO_FEEDBACK) {
     if (msg.cmd == RTCP_PACKET && fb_sink_)
-      fb_sink_->deliverFeedback(std::make_shared<erizo::DataPacket>(
+      fb_sink_->deliverFeedback(erizo::makeDataPacket(
           0, msg.data.rtcp.buf, msg.data.rtcp.len, erizo::AUDIO_PACKET));
   }
 }
@@ -184,7 +189,7 @@ void AudioFrameConstructor::onAdapterData(char* data, int len) {
   // Data come from audio receive stream is RTCP
   if (fb_sink_) {
     fb_sink_->deliverFeedback(
-      std::make_shared<erizo::DataPacket>(0, data, len, erizo::AUDIO_PACKET));
+      erizo::makeDataPacket(0, data, len, erizo::AUDIO_PACKET));
   }
 }
 
@@ -42,6 +42,8 @@ class AudioFrameConstructor final : public erizo::MediaSink,
   void bindTransport(erizo::MediaSource* source, erizo::FeedbackSink* fbSink);
   void unbindTransport();
   void enable(bool enabled) { enabled_ = enabled; }
+  // The packets received are given to |sink| too, before framing.
+  void setPacketSink(erizo::MediaSink* sink) { packet_sink_ = sink; }
 
   // Implements the FrameSource interfaces.
   void onFeedback(const FeedbackMsg& msg);
@@ -62,6 +64,7 @@ class AudioFrameConstructor final : public erizo::MediaSink,
   bool enabled_{true};
   uint32_t ssrc_{0};
   erizo::MediaSource* transport_{nullptr};
+  erizo::MediaSink* packet_sink_{nullptr};
   config config_;
   std::shared_ptr<rtc_adapter::RtcAdapter> rtcAdapter_;
   rtc_adapter::AudioReceiveAdapter* audioReceive_{nullptr};
@@ -66,7 +66,7 @@ void AudioFramePacketizer::receiveRtpData(char* buf, int len,
 
   assert(type == erizoExtra::AUDIO);
   audio_sink_->deliverAudioData(
-      std::make_shared<erizo::DataPacket>(0, buf, len, erizo::AUDIO_PACKET));
+      erizo::makeDataPacket(0, buf, len, erizo::AUDIO_PACKET));
 }
 
 void AudioFramePacketizer::onFrame(std::shared_ptr<Frame> f) {
@@ -113,7 +113,7 @@ void AudioFramePacketizer::onAdapterStats(const AdapterStats& stats) {}
 void AudioFramePacketizer::onAdapterData(char* data, int len) {
   if (audio_sink_) {
     audio_sink_->deliverAudioData(
-        std::make_shared<erizo::DataPacket>(0, data, len, erizo::AUDIO_PACKET));
+        erizo::makeDataPacket(0, data, len, erizo::AUDIO_PACKET));
   }
 }
 
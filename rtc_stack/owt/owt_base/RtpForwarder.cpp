@@ -0,0 +1,544 @@
+//
+// Copyright (c) 2021- anjisuan783
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "owt_base/RtpForwarder.h"
+
+#include <cstdlib>
+#include <string>
+
+#include "erizo/MediaStream.h"
+#include "erizo/rtp/RtpHeaders.h"
+#include "erizo/rtp/RtpUtils.h"
+
+namespace owt_base {
+
+// the timestamps on a new source go on by a frame.
+constexpr uint32_t kAudioTimestampGap = 960;
+constexpr uint32_t kVideoTimestampGap = 3000;
+
+// the size of a sender report without report blocks.
+constexpr int kSenderReportSize = 28;
+
+///////////////////////////////////////////////////////////////////////////////
+//RtpForwardSource
+///////////////////////////////////////////////////////////////////////////////
+DEFINE_LOGGER(RtpForwardSource, "owt.RtpForwardSource");
+
+RtpForwardSource::RtpForwardSource(
+    const Config& config, std::weak_ptr<FrameSource> frames)
+    : config_{config},
+      ssrc_{config.ssrc},
+      frames_{std::move(frames)},
+      extensions_{config.extensions} {
+  if (!config_.audio) {
+    history_.resize(kHistorySize);
+  }
+}
+
+RtpForwardSource::~RtpForwardSource() {
+  close();
+}
+
+void RtpForwardSource::close() {
+  for (auto& i : forwarders_) {
+    if (auto forwarder = i.second.lock()) {
+      forwarder->detach(this);
+    }
+  }
+  forwarders_.clear();
+  history_.clear();
+  config_.stream = nullptr;
+}
+
+void RtpForwardSource::addForwarder(std::shared_ptr<RtpForwarder> forwarder) {
+  ELOG_DEBUG("addForwarder %p", forwarder.get());
+  forwarder->attach(shared_from_this());
+  forwarders_[forwarder.get()] = forwarder;
+  requestKeyFrame();
+}
+
+void RtpForwardSource::removeForwarder(RtpForwarder* forwarder) {
+  ELOG_DEBUG("removeForwarder %p", forwarder);
+  auto found = forwarders_.find(forwarder);
+  if (found == forwarders_.end()) {
+    return;
+  }
+  if (auto p = found->second.lock()) {
+    p->detach(this);
+  }
+  forwarders_.erase(found);
+}
+
+void RtpForwardSource::requestKeyFrame() {
+  if (config_.audio) {
+    return;
+  }
+  if (auto frames = frames_.lock()) {
+    frames->onFeedback(FeedbackMsg(VIDEO_FEEDBACK, REQUEST_KEY_FRAME));
+  }
+}
+
+void RtpForwardSource::retransmit(
+    std::weak_ptr<RtpForwarder> forwarder, std::vector<uint16_t> seqs) {
+  if (config_.audio) {
+    return;
+  }
+  config_.worker->task([weak_this = weak_from_this(),
+      weak_forwarder = std::move(forwarder), seqs = std::move(seqs)] {
+    auto self = weak_this.lock();
+    auto forwarder = weak_forwarder.lock();
+    if (!self || !forwarder || self->history_.empty()) {
+      return;
+    }
+    for (uint16_t seq : seqs) {
+      auto& packet = self->history_[seq % kHistorySize];
+      if (packet && reinterpret_cast<erizo::RtpHeader*>(
+              packet->data)->getSeqNumber() == seq) {
+        forwarder->forward(self.get(), packet, self->extensions_);
+      }
+    }
+  }, RTC_FROM_HERE);
+}
+
+int RtpForwardSource::deliverAudioData_(
+    std::shared_ptr<erizo::DataPacket> audio_packet) {
+  int len = audio_packet->length;
+  onPacket(std::move(audio_packet));
+  return len;
+}
+
+int RtpForwardSource::deliverVideoData_(
+    std::shared_ptr<erizo::DataPacket> video_packet) {
+  int len = video_packet->length;
+  onPacket(std::move(video_packet));
+  return len;
+}
+
+void RtpForwardSource::onPacket(std::shared_ptr<erizo::DataPacket> packet) {
+  if (forwarders_.empty() || packet->length < erizo::RtpHeader::MIN_SIZE) {
+    return;
+  }
+
+  erizo::RtcpHeader* chead =
+      reinterpret_cast<erizo::RtcpHeader*>(packet->data);
+  if (chead->isRtcp()) {
+    onRtcp(packet.get());
+    return;
+  }
+
+  erizo::RtpHeader* head = reinterpret_cast<erizo::RtpHeader*>(packet->data);
+  if (head->getHeaderLength() > packet->length) {
+    return;
+  }
+
+  uint32_t ssrc = head->getSSRC();
+  if (config_.rtx_ssrc && ssrc == config_.rtx_ssrc) {
+    packet = unwrapRtx(packet.get());
+    if (!packet) {
+      return;
+    }
+  } else if (!ssrc_) {
+    ssrc_ = ssrc;
+  } else if (ssrc != ssrc_) {
+    return;
+  }
+
+  if (!extensions_ && config_.stream) {
+    auto& processor = config_.stream->getRtpExtensionProcessor();
+    extensions_ = std::make_shared<const RtpExtensionMap>(config_.audio ?
+        processor.getAudioExtensionMap() : processor.getVideoExtensionMap());
+  }
+
+  if (!history_.empty()) {
+    uint16_t seq =
+        reinterpret_cast<erizo::RtpHeader*>(packet->data)->getSeqNumber();
+    history_[seq % kHistorySize] = packet;
+  }
+
+  for (auto& i : forwarders_) {
+    if (auto forwarder = i.second.lock()) {
+      forwarder->forward(this, packet, extensions_);
+    }
+  }
+}
+
+void RtpForwardSource::onRtcp(erizo::DataPacket* packet) {
+  erizo::RtpUtils::forEachRtcpBlock(packet,
+      [this](erizo::RtcpHeader* chead) {
+    if (chead->getPacketType() != RTCP_Sender_PT ||
+        (chead->getLength() + 1) * 4 < kSenderReportSize ||
+        chead->getSSRC() != ssrc_) {
+      return;
+    }
+    uint64_t ntp = chead->getNtpTimestamp();
+    uint32_t rtp_ts = ntohl(chead->report.senderReport.rtprts);
+    for (auto& i : forwarders_) {
+      if (auto forwarder = i.second.lock()) {
+        forwarder->onSenderReport(this, ntp, rtp_ts);
+      }
+    }
+  });
+}
+
+std::shared_ptr<erizo::DataPacket> RtpForwardSource::unwrapRtx(
+    erizo::DataPacket* packet) {
+  erizo::RtpHeader* head = reinterpret_cast<erizo::RtpHeader*>(packet->data);
+  int header_len = head->getHeaderLength();
+  int padding = erizo::RtpUtils::getPaddingLength(packet);
+  // the padding only ones, for the probing.
+  if (!ssrc_ || packet->length - padding <= header_len + 2) {
+    return nullptr;
+  }
+
+  auto media = erizo::makeDataPacket();
+  media->comp = packet->comp;
+  media->type = packet->type;
+  media->received_time_ms = packet->received_time_ms;
+  media->reserve(packet->length - 2);
+  media->length = packet->length - 2;
+  memcpy(media->data, packet->data, header_len);
+  memcpy(media->data + header_len,
+         packet->data + header_len + 2,
+         packet->length - header_len - 2);
+
+  erizo::RtpHeader* media_head =
+      reinterpret_cast<erizo::RtpHeader*>(media->data);
+  uint16_t osn = ntohs(*reinterpret_cast<uint16_t*>(packet->data + header_len));
+  media_head->setSeqNumber(osn);
+  media_head->setSSRC(ssrc_);
+  media_head->setPayloadType(config_.rtp_payload_type);
+  return media;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//RtpForwarder
+///////////////////////////////////////////////////////////////////////////////
+DEFINE_LOGGER(RtpForwarder, "owt.RtpForwarder");
+
+RtpForwarder::RtpForwarder(const Config& config) : config_{config} {
+  ext_ids_.fill(0);
+}
+
+RtpForwarder::~RtpForwarder() {
+  close();
+}
+
+void RtpForwarder::close() {
+  unbindTransport();
+  current_ = nullptr;
+  source_.reset();
+}
+
+void RtpForwarder::bindTransport(
+    erizo::MediaStream* stream, erizo::FeedbackSink* next) {
+  if (!stream) return ;
+  stream_ = stream;
+  next_ = next;
+  erizo::FeedbackSource* fbSource = stream_->getFeedbackSource();
+  if (fbSource)
+      fbSource->setFeedbackSink(this);
+}
+
+void RtpForwarder::unbindTransport() {
+  stream_ = nullptr;
+  next_ = nullptr;
+}
+
+void RtpForwarder::enable(bool enabled) {
+  enabled_ = enabled;
+  if (enabled_) {
+    if (auto source = source_.lock()) {
+      source->requestKeyFrame();
+    }
+  }
+}
+
+void RtpForwarder::post(std::function<void(std::shared_ptr<RtpForwarder>)> f) {
+  if (config_.worker->IsCurrent()) {
+    f(shared_from_this());
+    return;
+  }
+  config_.worker->task([weak_this = weak_from_this(), f = std::move(f)] {
+    if (auto self = weak_this.lock()) {
+      f(std::move(self));
+    }
+  }, RTC_FROM_HERE);
+}
+
+void RtpForwarder::attach(std::shared_ptr<RtpForwardSource> source) {
+  post([source = std::move(source)](std::shared_ptr<RtpForwarder> self) {
+    self->current_ = source.get();
+    self->source_ = source;
+    self->rebase_ = true;
+  });
+}
+
+void RtpForwarder::detach(RtpForwardSource* source) {
+  post([source](std::shared_ptr<RtpForwarder> self) {
+    if (self->current_ == source) {
+      self->current_ = nullptr;
+      self->source_.reset();
+    }
+  });
+}
+
+void RtpForwarder::forward(RtpForwardSource* source,
+    std::shared_ptr<erizo::DataPacket> packet,
+    std::shared_ptr<const RtpExtensionMap> extensions) {
+  if (config_.worker->IsCurrent()) {
+    send(source, std::move(packet), extensions);
+    return;
+  }
+  config_.worker->task([weak_this = weak_from_this(), source,
+      packet = std::move(packet), extensions = std::move(extensions)] {
+    if (auto self = weak_this.lock()) {
+      self->send(source, std::move(packet), extensions);
+    }
+  }, RTC_FROM_HERE);
+}
+
+void RtpForwarder::onSenderReport(
+    RtpForwardSource* source, uint64_t ntp, uint32_t rtp_ts) {
+  post([source, ntp, rtp_ts](std::shared_ptr<RtpForwarder> self) {
+    if (self->current_ == source) {
+      self->sendSenderReport(ntp, rtp_ts);
+    }
+  });
+}
+
+uint32_t RtpForwarder::ssrc() {
+  return config_.audio ?
+      stream_->getAudioSinkSSRC() : stream_->getVideoSinkSSRC();
+}
+
+void RtpForwarder::send(RtpForwardSource* source,
+    std::shared_ptr<erizo::DataPacket> in,
+    const std::shared_ptr<const RtpExtensionMap>& extensions) {
+  if (!enabled_ || !stream_ || source != current_) {
+    return;
+  }
+
+  // the packet is shared by the subscribers, stamped on a copy.
+  auto packet = erizo::makeDataPacket(0, in->data, in->length,
+      config_.audio ? erizo::AUDIO_PACKET : erizo::VIDEO_PACKET,
+      in->received_time_ms);
+  erizo::RtpHeader* head = reinterpret_cast<erizo::RtpHeader*>(packet->data);
+  uint16_t seq = head->getSeqNumber();
+  uint32_t ts = head->getTimestamp();
+
+  if (rebase_) {
+    if (started_) {
+      seq_offset_ = last_seq_ + 1 - seq;
+      ts_offset_ = last_ts_ - ts +
+          (config_.audio ? kAudioTimestampGap : kVideoTimestampGap);
+    } else {
+      seq_offset_ = std::rand();
+      ts_offset_ = std::rand();
+    }
+    last_seq_ = seq + seq_offset_;
+    last_ts_ = ts + ts_offset_;
+    rebase_ = false;
+    started_ = true;
+  }
+
+  uint16_t out_seq = seq + seq_offset_;
+  uint32_t out_ts = ts + ts_offset_;
+  if (erizo::RtpUtils::sequenceNumberLessThan(last_seq_, out_seq)) {
+    last_seq_ = out_seq;
+    last_ts_ = out_ts;
+  }
+  head->setSeqNumber(out_seq);
+  head->setTimestamp(out_ts);
+  head->setSSRC(ssrc());
+
+  if (head->getExtension()) {
+    if (extensions != extensions_) {
+      remapExtensions(extensions);
+    }
+    rewriteExtensions(packet.get());
+  }
+
+  ++packets_sent_;
+  octets_sent_ += packet->length - head->getHeaderLength();
+  deliver(std::move(packet));
+}
+
+void RtpForwarder::sendSenderReport(uint64_t ntp, uint32_t rtp_ts) {
+  if (!enabled_ || !stream_ || !started_ || rebase_) {
+    return;
+  }
+
+  erizo::RtcpHeader sr;
+  sr.setPacketType(RTCP_Sender_PT);
+  sr.setBlockCount(0);
+  sr.setSSRC(ssrc());
+  sr.setLength(kSenderReportSize / 4 - 1);
+  sr.setNtpTimestamp(ntp);
+  sr.report.senderReport.rtprts = htonl(rtp_ts + ts_offset_);
+  sr.setPacketsSent(packets_sent_);
+  sr.setOctetsSent(octets_sent_);
+  deliver(erizo::makeDataPacket(0, reinterpret_cast<char*>(&sr),
+      kSenderReportSize,
+      config_.audio ? erizo::AUDIO_PACKET : erizo::VIDEO_PACKET));
+}
+
+void RtpForwarder::remapExtensions(
+    const std::shared_ptr<const RtpExtensionMap>& extensions) {
+  extensions_ = extensions;
+  ext_ids_.fill(0);
+  if (!extensions_) {
+    return;
+  }
+
+  auto& processor = stream_->getRtpExtensionProcessor();
+  const RtpExtensionMap& mine = config_.audio ?
+      processor.getAudioExtensionMap() : processor.getVideoExtensionMap();
+  for (size_t id = 1; id < ext_ids_.size(); ++id) {
+    erizo::RTPExtensions ext = (*extensions_)[id];
+    if (ext == erizo::UNKNOWN) {
+      continue;
+    }
+    for (size_t my_id = 1; my_id < mine.size(); ++my_id) {
+      if (mine[my_id] == ext) {
+        ext_ids_[id] = my_id;
+        break;
+      }
+    }
+  }
+}
+
+void RtpForwarder::rewriteExtensions(erizo::DataPacket* packet) {
+  erizo::RtpHeader* head = reinterpret_cast<erizo::RtpHeader*>(packet->data);
+  if (head->getExtId() != 0xBEDE || !extensions_) {
+    // two-byte ones are sent as they are.
+    return;
+  }
+
+  uint8_t* ext = reinterpret_cast<uint8_t*>(packet->data) +
+      erizo::RtpHeader::MIN_SIZE + head->getCc() * 4 + 4;
+  uint8_t* end = ext + head->getExtLength() * 4;
+  const std::string& mid = stream_->getId();
+
+  while (ext < end) {
+    uint8_t id = *ext >> 4;
+    uint8_t len = (*ext & 0x0F) + 1;
+    if (id == 0) {
+      // padding
+      ++ext;
+      continue;
+    }
+    if (id == 15 || ext + 1 + len > end) {
+      break;
+    }
+
+    erizo::RTPExtensions type = (*extensions_)[id];
+    uint8_t my_id = ext_ids_[id];
+    bool keep = (my_id != 0);
+    switch (type) {
+      case erizo::TRANSPORT_CC:
+        if (keep && len == 2) {
+          ++transport_seq_;
+          ext[1] = transport_seq_ >> 8;
+          ext[2] = transport_seq_;
+        } else {
+          keep = false;
+        }
+        break;
+      case erizo::RTP_ID:
+      case erizo::REPARIED_RTP_ID:
+        // the layers of the publisher.
+        keep = false;
+        break;
+      case erizo::MEDIA_ID:
+        if (keep && len == mid.size()) {
+          memcpy(ext + 1, mid.data(), len);
+        } else {
+          keep = false;
+        }
+        break;
+      case erizo::ABS_SEND_TIME:
+        if (keep && len == 3) {
+          wa::duration now = wa::clock::now().time_since_epoch();
+          uint64_t us =
+              std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+          // 6.18 fixed point seconds.
+          uint32_t abs = ((us << 18) / 1000000) & 0x00FFFFFF;
+          ext[1] = abs >> 16;
+          ext[2] = abs >> 8;
+          ext[3] = abs;
+        }
+        break;
+      default:
+        break;
+    }
+
+    if (keep) {
+      *ext = (my_id << 4) | (len - 1);
+    } else {
+      // zeros are the padding.
+      memset(ext, 0, len + 1);
+    }
+    ext += len + 1;
+  }
+}
+
+void RtpForwarder::deliver(std::shared_ptr<erizo::DataPacket> packet) {
+  if (config_.audio) {
+    stream_->deliverAudioData(std::move(packet));
+  } else {
+    stream_->deliverVideoData(std::move(packet));
+  }
+}
+
+int RtpForwarder::deliverFeedback_(
+    std::shared_ptr<erizo::DataPacket> data_packet) {
+  auto source = source_.lock();
+  if (!source) {
+    return next_ ? next_->deliverFeedback(std::move(data_packet)) : 0;
+  }
+
+  bool key_frame = false;
+  std::vector<uint16_t> seqs;
+  // the blocks not taken here, the reports, remb and transport-cc.
+  std::string rest;
+  erizo::RtpUtils::forEachRtcpBlock(data_packet.get(),
+      [this, &key_frame, &seqs, &rest](erizo::RtcpHeader* chead) {
+    if (chead->getPacketType() == RTCP_PS_Feedback_PT &&
+        (chead->getBlockCount() == RTCP_PLI_FMT ||
+         chead->getBlockCount() == RTCP_FIR_FMT)) {
+      key_frame = true;
+    } else if (chead->getPacketType() == RTCP_RTP_Feedback_PT &&
+               chead->getBlockCount() == 1) {
+      // generic nack, to the sequence numbers of the source.
+      erizo::RtpUtils::forEachNack(chead,
+          [this, &seqs](uint16_t pid, uint16_t blp, erizo::RtcpHeader*) {
+        seqs.push_back(pid - seq_offset_);
+        for (int i = 0; i < 16; ++i) {
+          if (blp & (1 << i)) {
+            seqs.push_back(pid + i + 1 - seq_offset_);
+          }
+        }
+      });
+    } else {
+      rest.append(reinterpret_cast<char*>(chead),
+                  (chead->getLength() + 1) * 4);
+    }
+  });
+
+  if (key_frame) {
+    source->requestKeyFrame();
+  }
+  if (!seqs.empty()) {
+    source->retransmit(weak_from_this(), std::move(seqs));
+  }
+  if (next_ && !rest.empty()) {
+    next_->deliverFeedback(erizo::makeDataPacket(data_packet->comp,
+        rest.data(), rest.size(), data_packet->type));
+  }
+  return data_packet->length;
+}
+
+} // namespace owt_base
@@ -0,0 +1,176 @@
+//
+// Copyright (c) 2021- anjisuan783
+//
+// SPDX-License-Identifier: MIT
+//
+
+#ifndef RtpForwarder_h
+#define RtpForwarder_h
+
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "common/logger.h"
+#include "utils/Worker.h"
+#include "erizo/MediaDefinitions.h"
+#include "erizo/rtp/RtpExtensionProcessor.h"
+#include "owt_base/MediaFramePipeline.h"
+
+namespace erizo {
+class MediaStream;
+}
+
+namespace owt_base {
+
+class RtpForwarder;
+
+// extension id => extension, of one peer.
+using RtpExtensionMap = std::array<erizo::RTPExtensions, erizo::kRtpExtSize>;
+
+/**
+ * The rtp packets of a published track, given to the subscribers as
+ * received instead of being framed once and packetized again for each
+ * of them. Tapped before the frame constructor, or after the packetizer
+ * shared by the subscribers of a frame source. Runs on its worker.
+ */
+class RtpForwardSource final
+    : public erizo::MediaSink,
+      public std::enable_shared_from_this<RtpForwardSource> {
+  DECLARE_LOGGER();
+
+ public:
+  struct Config {
+    bool audio{false};
+    uint32_t ssrc{0};
+    // the retransmissions on it are unwrapped to |ssrc|.
+    uint32_t rtx_ssrc{0};
+    int rtp_payload_type{0};
+    wa::Worker* worker{nullptr};
+    // the publisher, for its extension ids.
+    erizo::MediaStream* stream{nullptr};
+    // the extension ids if not of |stream|, the packetizer's.
+    std::shared_ptr<const RtpExtensionMap> extensions;
+  };
+
+  RtpForwardSource(const Config& config, std::weak_ptr<FrameSource> frames);
+  ~RtpForwardSource() override;
+
+  void close() override;
+
+  // On the worker.
+  void addForwarder(std::shared_ptr<RtpForwarder> forwarder);
+  void removeForwarder(RtpForwarder* forwarder);
+
+  // Any thread.
+  void requestKeyFrame();
+  // Sends the packets of |seqs| kept to |forwarder| again.
+  void retransmit(std::weak_ptr<RtpForwarder> forwarder,
+                  std::vector<uint16_t> seqs);
+
+ private:
+  // Implement erizo::MediaSink
+  int deliverAudioData_(std::shared_ptr<erizo::DataPacket> audio_packet) override;
+  int deliverVideoData_(std::shared_ptr<erizo::DataPacket> video_packet) override;
+  int deliverEvent_(erizo::MediaEventPtr event) override { return 0; }
+
+  void onPacket(std::shared_ptr<erizo::DataPacket> packet);
+  void onRtcp(erizo::DataPacket* packet);
+  std::shared_ptr<erizo::DataPacket> unwrapRtx(erizo::DataPacket* packet);
+
+  // the packets kept for the nacks of the subscribers, video only.
+  static constexpr size_t kHistorySize = 512;
+
+ private:
+  Config config_;
+  uint32_t ssrc_;
+  std::weak_ptr<FrameSource> frames_;
+  std::shared_ptr<const RtpExtensionMap> extensions_;
+  std::vector<std::shared_ptr<erizo::DataPacket>> history_;
+  std::unordered_map<RtpForwarder*, std::weak_ptr<RtpForwarder>> forwarders_;
+};
+
+/**
+ * Sends the packets of a RtpForwardSource to a subscriber, stamped with
+ * its own ssrc, sequence numbers, timestamps, transport-wide sequence
+ * numbers, abs-send-time and extension ids, encrypted by its own
+ * transport. Takes the nacks and the key frame requests of the subscriber,
+ * and gives the rest of its rtcp, or all of it while nothing forwarded,
+ * to |next|, the packetizer.
+ */
+class RtpForwarder final
+    : public erizo::FeedbackSink,
+      public std::enable_shared_from_this<RtpForwarder> {
+  DECLARE_LOGGER();
+
+ public:
+  struct Config {
+    bool audio{false};
+    wa::Worker* worker{nullptr};
+  };
+
+  explicit RtpForwarder(const Config& config);
+  ~RtpForwarder() override;
+
+  void close();
+
+  void bindTransport(erizo::MediaStream* stream, erizo::FeedbackSink* next);
+  void unbindTransport();
+  void enable(bool enabled);
+
+  // By the source on its worker.
+  void attach(std::shared_ptr<RtpForwardSource> source);
+  void detach(RtpForwardSource* source);
+  void forward(RtpForwardSource* source,
+               std::shared_ptr<erizo::DataPacket> packet,
+               std::shared_ptr<const RtpExtensionMap> extensions);
+  void onSenderReport(RtpForwardSource* source, uint64_t ntp, uint32_t rtp_ts);
+
+ private:
+  // Implement erizo::FeedbackSink
+  int deliverFeedback_(std::shared_ptr<erizo::DataPacket> data_packet) override;
+
+  // run |f| on the worker, at once if on it.
+  void post(std::function<void(std::shared_ptr<RtpForwarder>)> f);
+
+  void send(RtpForwardSource* source,
+            std::shared_ptr<erizo::DataPacket> packet,
+            const std::shared_ptr<const RtpExtensionMap>& extensions);
+  void sendSenderReport(uint64_t ntp, uint32_t rtp_ts);
+  void remapExtensions(const std::shared_ptr<const RtpExtensionMap>& extensions);
+  void rewriteExtensions(erizo::DataPacket* packet);
+  void deliver(std::shared_ptr<erizo::DataPacket> packet);
+  uint32_t ssrc();
+
+ private:
+  Config config_;
+  bool enabled_{true};
+  erizo::MediaStream* stream_{nullptr};
+  erizo::FeedbackSink* next_{nullptr};
+
+  // the source forwarded now, on the worker.
+  RtpForwardSource* current_{nullptr};
+  std::weak_ptr<RtpForwardSource> source_;
+
+  // continue the sequence numbers and the timestamps on a new source.
+  bool started_{false};
+  bool rebase_{true};
+  uint16_t seq_offset_{0};
+  uint32_t ts_offset_{0};
+  uint16_t last_seq_{0};
+  uint32_t last_ts_{0};
+  uint32_t packets_sent_{0};
+  uint32_t octets_sent_{0};
+  // the transport-cc sequence numbers to the subscriber.
+  uint16_t transport_seq_{0};
+
+  // the extension id of the publisher => the one of the subscriber, 0 if
+  // not negotiated and removed.
+  std::shared_ptr<const RtpExtensionMap> extensions_;
+  std::array<uint8_t, erizo::kRtpExtSize> ext_ids_;
+};
+
+} // namespace owt_base
+
+#endif /* RtpForwarder_h */
@@ -32,6 +32,7 @@ VideoFrameConstructor::~VideoFrameConstructor() {
 
 void VideoFrameConstructor::close() {
   unbindTransport();
+  packet_sink_ = nullptr;
   if (videoReceive_) {
     rtcAdapter_->destoryVideoReceiver(videoReceive_);
     videoReceive_ = nullptr;
@@ -102,12 +103,16 @@ void VideoFrameConstructor::onAdapterData(char* data, int len) {
   // Data come from video receive stream is RTCP
   if (fb_sink_) {
     fb_sink_->deliverFeedback(
-      std::make_shared<erizo::DataPacket>(0, data, len, erizo::VIDEO_PACKET));
+      erizo::makeDataPacket(0, data, len, erizo::VIDEO_PACKET));
   }
 }
 
 int VideoFrameConstructor::deliverVideoData_(
     std::shared_ptr<erizo::DataPacket> video_packet) {
+  if (packet_sink_ && enable_) {
+    packet_sink_->deliverVideoData(video_packet);
+  }
+
   char* data = video_packet->data;
   int len = video_packet->length;
   erizo::RtcpHeader* chead = 
@@ -59,6 +59,8 @@ public:
   void bindTransport(erizo::MediaSource* source, erizo::FeedbackSink* fbSink);
   void unbindTransport();
   void enable(bool enabled);
+  // The packets received are given to |sink| too, before framing.
+  void setPacketSink(erizo::MediaSink* sink) { packet_sink_ = sink; }
 
   //timer 1s
   void onTimeout();
@@ -94,6 +96,7 @@ private:
   uint32_t ssrc_{0};
 
   erizo::MediaSource* transport_{nullptr};
+  erizo::MediaSink* packet_sink_{nullptr};
   uint32_t pendingKeyFrameRequests_{0};
 
   VideoInfoListener* videoInfoListener_;
@@ -52,6 +52,7 @@ bool VideoFramePacketizer::init(VideoFramePacketizer::Config& config) {
   rtc_adapter::RtcAdapter::Config sendConfig;
 
   sendConfig.transport_cc = config.transportccExt;
+  sendConfig.abs_send_time = config.absSendTimeExt;
   sendConfig.red_payload = config.Red;
   sendConfig.ulpfec_payload = config.Ulpfec;
   if (!config.mid.empty()) {
@@ -99,7 +100,7 @@ void VideoFramePacketizer::onAdapterData(char* data, int len) {
     return;
   }
 
-  video_sink_->deliverVideoData(std::make_shared<erizo::DataPacket>(
+  video_sink_->deliverVideoData(erizo::makeDataPacket(
       0, data, len, erizo::VIDEO_PACKET));
 }
 
@@ -36,6 +36,7 @@ class VideoFramePacketizer
       int Red{false};
       int Ulpfec{-1};
       int transportccExt{-1};
+      int absSendTimeExt{-1};
       bool selfRequestKeyframe{false};
       std::string mid{""};
       uint32_t midExtId{0};
@@ -91,6 +91,8 @@ public:
     int rtp_payload_type = 0;
     // Transport-cc extension ID
     int transport_cc = -1;
+    // Abs-send-time extension ID, video sender only
+    int abs_send_time = -1;
     int red_payload = -1;
     int ulpfec_payload = -1;
     bool flex_fec = false;
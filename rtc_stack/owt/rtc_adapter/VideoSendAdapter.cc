@@ -93,6 +93,11 @@ bool VideoSendAdapterImpl::init() {
     rtpRtcp_->RegisterRtpHeaderExtension(
       webrtc::RtpExtension::kTransportSequenceNumberUri, config_.transport_cc);
   }
+
+  if (config_.abs_send_time != -1) {
+    rtpRtcp_->RegisterRtpHeaderExtension(
+      webrtc::RtpExtension::kAbsSendTimeUri, config_.abs_send_time);
+  }
   
   if (config_.mid_ext) {
     config_.mid[sizeof(config_.mid) - 1] = '\0';
@@ -0,0 +1,88 @@
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "erizo/IceLiteConnection.h"
+#include "erizo/MediaDefinitions.h"
+
+using erizo::IceConnection;
+using erizo::IceLiteConnection;
+using erizo::IceLiteMux;
+using erizo::IceState;
+
+namespace {
+
+// Counts the packets, and the ones after the connection closed.
+class CountingListener : public erizo::IceConnectionListener {
+ public:
+  void onPacketReceived(std::shared_ptr<erizo::DataPacket>) override {
+    ++received;
+    if (closed) {
+      ++late;
+    }
+  }
+  void onCandidate(const erizo::CandidateInfo&, IceConnection*) override { }
+  void updateIceState(IceState, IceConnection*) override { }
+
+  std::atomic<bool> closed{false};
+  std::atomic<int64_t> received{0};
+  std::atomic<int64_t> late{0};
+};
+
+}  // namespace
+
+// the packets delivered by the io workers while the connection is closed
+// by its worker, none of them after close returns.
+TEST(IceLiteConnection, close_while_receiving) {
+  // no socket, the packets given by the test as read.
+  ASSERT_TRUE(IceLiteMux::start("127.0.0.1", 0, {}));
+  IceLiteMux* mux = IceLiteMux::get();
+  ASSERT_NE(mux, nullptr);
+
+  char payload[1000];
+  memset(payload, 0x80, sizeof(payload));
+
+  for (int round = 0; round < 100; ++round) {
+    auto listener = std::make_shared<CountingListener>();
+    auto conn = std::make_shared<IceLiteConnection>(mux, erizo::IceConfig{});
+    conn->setIceListener(listener);
+    conn->start();
+    conn->updateIceState(IceState::READY);
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 4; ++i) {
+      // large ones moved, small ones copied.
+      int len = (i % 2) ? 1000 : 100;
+      workers.emplace_back([&stop, &payload, conn, len] {
+        while (!stop) {
+          auto packet = erizo::makeDataPacket(0, payload, len);
+          conn->onPacket(packet);
+        }
+      });
+    }
+    while (listener->received < 100) {
+      std::this_thread::yield();
+    }
+
+    conn->close();
+    listener->closed = true;
+    // the workers still delivering, and this thread too.
+    for (int i = 0; i < 1000; ++i) {
+      auto packet = erizo::makeDataPacket(0, payload, 1000);
+      conn->onPacket(packet);
+    }
+    stop = true;
+    for (auto& t : workers) {
+      t.join();
+    }
+
+    EXPECT_EQ(conn->checkIceState(), IceState::FINISHED);
+    EXPECT_EQ(listener->late, 0);
+  }
+  IceLiteMux::stop();
+}
@@ -0,0 +1,196 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "erizo/MediaDefinitions.h"
+
+using erizo::DataPacket;
+using erizo::PacketPool;
+
+namespace {
+
+// the packet before the pool, the mtu inline and by std::make_shared.
+struct LegacyPacket {
+  LegacyPacket(int _comp, const char* _data, int _length)
+      : comp{_comp}, length{_length} {
+    memcpy(data, _data, _length);
+  }
+  int comp{-1};
+  erizo::packetType type{erizo::VIDEO_PACKET};
+  uint64_t received_time_ms{0};
+  int length{0};
+  char data[DataPacket::MTU_SIZE];
+};
+
+// The packets made on one thread and released on another, like the ones
+// read by an io worker and sent to a worker, in batches of 64.
+template <typename Make>
+double cross_thread(int packets, Make make) {
+  using Ptr = decltype(make());
+  std::mutex lock;
+  std::vector<std::vector<Ptr>> batches;
+  std::atomic<bool> done{false};
+
+  std::thread consumer([&] {
+    for (;;) {
+      std::vector<std::vector<Ptr>> taken;
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        taken.swap(batches);
+      }
+      if (taken.empty()) {
+        if (done) {
+          break;
+        }
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<Ptr> batch;
+  for (int i = 0; i < packets; ++i) {
+    batch.emplace_back(make());
+    if (batch.size() == 64) {
+      std::lock_guard<std::mutex> guard(lock);
+      batches.emplace_back(std::move(batch));
+      batch.clear();
+    }
+  }
+  done = true;
+  consumer.join();
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename Make>
+double same_thread(int packets, Make make) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<decltype(make())> batch;
+  for (int i = 0; i < packets; ++i) {
+    batch.emplace_back(make());
+    if (batch.size() == 64) {
+      batch.clear();
+    }
+  }
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+TEST(PacketPool, size_class) {
+  size_t capacity = 0;
+  char* small = PacketPool::alloc(100, &capacity);
+  EXPECT_EQ(capacity, 128u);
+  char* mtu = PacketPool::alloc(DataPacket::MTU_SIZE, &capacity);
+  EXPECT_EQ(capacity, 1536u);
+  char* large = PacketPool::alloc(4000, &capacity);
+  EXPECT_EQ(capacity, 4000u);
+  memset(large, 0, 4000);
+
+  PacketPool::free(small);
+  PacketPool::free(mtu);
+  PacketPool::free(large);
+
+  // reused by the same thread.
+  EXPECT_EQ(PacketPool::alloc(120), small);
+  PacketPool::free(small);
+}
+
+TEST(PacketPool, data_packet) {
+  char payload[1200];
+  memset(payload, 7, sizeof(payload));
+
+  auto audio = erizo::makeDataPacket(0, payload, 100, erizo::AUDIO_PACKET);
+  EXPECT_EQ(audio->capacity(), 128u);
+  EXPECT_EQ(audio->length, 100);
+  EXPECT_EQ(audio->data[99], 7);
+
+  auto video = erizo::makeDataPacket(0, payload, 1200, erizo::VIDEO_PACKET);
+  EXPECT_EQ(video->capacity(), 1536u);
+
+  video->Init(1, payload, 50, erizo::OTHER_PACKET, 0);
+  EXPECT_EQ(video->capacity(), 1536u);
+  EXPECT_EQ(video->comp, 1);
+}
+
+TEST(PacketPool, free_on_other_thread) {
+  char payload[1000] = {0};
+  std::vector<std::shared_ptr<DataPacket>> packets;
+  for (int i = 0; i < 1000; ++i) {
+    packets.emplace_back(erizo::makeDataPacket(0, payload, 1000));
+  }
+  std::set<char*> made;
+  for (auto& p : packets) {
+    made.insert(p->data);
+  }
+
+  std::thread([&packets] { packets.clear(); }).join();
+
+  // taken back by the owner.
+  auto again = erizo::makeDataPacket(0, payload, 1000);
+  EXPECT_EQ(made.count(again->data), 1u);
+
+  // the buffers out survive the exit of their thread, and are freed, not
+  // cached, when released, the leak left to asan.
+  std::shared_ptr<DataPacket> orphan;
+  std::thread([&orphan] {
+    char filled[1000];
+    memset(filled, 9, sizeof(filled));
+    orphan = erizo::makeDataPacket(0, filled, 1000);
+  }).join();
+  ASSERT_NE(orphan, nullptr);
+  EXPECT_EQ(orphan->length, 1000);
+  EXPECT_EQ(orphan->data[0], 9);
+  EXPECT_EQ(orphan->data[999], 9);
+  EXPECT_EQ(made.count(orphan->data), 0u);
+  orphan = nullptr;
+
+  // released while the owner exits, each buffer freed once, by asan.
+  for (int i = 0; i < 100; ++i) {
+    std::atomic<DataPacket*> handed{nullptr};
+    std::shared_ptr<DataPacket> raced;
+    std::thread owner([&raced, &handed, &payload] {
+      raced = erizo::makeDataPacket(0, payload, 1000);
+      handed = raced.get();
+    });
+    while (!handed) {
+      std::this_thread::yield();
+    }
+    std::thread releaser([&raced] { raced = nullptr; });
+    owner.join();
+    releaser.join();
+    EXPECT_EQ(raced, nullptr);
+  }
+}
+
+// the benchmark, compared with std::make_shared of the mtu inline.
+TEST(PacketPool, benchmark) {
+  const int packets = 1000000;
+  char payload[DataPacket::MTU_SIZE] = {0};
+  for (int size : {100, 1200}) {
+    auto legacy = [&] {
+      return std::make_shared<LegacyPacket>(0, payload, size);
+    };
+    auto pooled = [&] {
+      return erizo::makeDataPacket(0, payload, size);
+    };
+    std::cout << size << " bytes, make_shared: " <<
+        (int64_t)(packets / same_thread(packets, legacy)) << "/s, " <<
+        (int64_t)(packets / cross_thread(packets, legacy)) << "/s cross thread" <<
+        std::endl;
+    std::cout << size << " bytes, pool: " <<
+        (int64_t)(packets / same_thread(packets, pooled)) << "/s, " <<
+        (int64_t)(packets / cross_thread(packets, pooled)) << "/s cross thread" <<
+        std::endl;
+  }
+}
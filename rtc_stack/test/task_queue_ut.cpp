@@ -0,0 +1,167 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "myrtc/api/default_task_queue_factory.h"
+#include "myrtc/rtc_base/to_queued_task.h"
+
+using webrtc::TaskQueueBase;
+using webrtc::TaskQueueFactory;
+using webrtc::ToQueuedTask;
+
+static void wait_for(const std::function<bool()>& done, int timeout_ms) {
+  auto deadline = std::chrono::steady_clock::now() + 
+                  std::chrono::milliseconds(timeout_ms);
+  while (!done() && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+}
+
+// post from the producers, check the order of each one, and report the
+// posts per second and the wakeups per 1000 posts of mpsc.
+// @param busy hold the consumer until all posted, as it's behind.
+static void post_from_producers(TaskQueueFactory* factory, 
+                                const char* name, 
+                                int producers, 
+                                int posts,
+                                bool busy = false) {
+  auto queue = factory->CreateTaskQueue(
+      name, TaskQueueFactory::Priority::NORMAL);
+  bool factory_is_mpsc = std::string(name) == "mpsc";
+
+  std::atomic<int64_t> done{0};
+  std::vector<int> last(producers, -1);
+  std::atomic<bool> in_order{true};
+  uint64_t wakeups = webrtc::MpscTaskQueueWakeups();
+
+  std::atomic<bool> hold{busy};
+  queue->PostTask(ToQueuedTask([&] {
+    while (hold) std::this_thread::yield();
+  }));
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p] {
+      for (int i = 0; i < posts; ++i) {
+        queue->PostTask(ToQueuedTask([&, p, i] {
+          if (last[p] + 1 != i) {
+            in_order = false;
+          }
+          last[p] = i;
+          ++done;
+        }));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  hold = false;
+
+  int64_t total = (int64_t)producers * posts;
+  wait_for([&] { return done == total; }, 30000);
+  double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  wakeups = webrtc::MpscTaskQueueWakeups() - wakeups;
+
+  EXPECT_EQ(done, total);
+  EXPECT_TRUE(in_order);
+
+  std::cout << name << ": " << producers << " producers" << 
+      (busy ? " busy consumer, " : ", ") << 
+      (int64_t)(total / seconds) << " posts/s";
+  if (factory_is_mpsc) {
+    std::cout << ", " << wakeups * 1000.0 / total << " wakeups/1000 posts";
+  }
+  std::cout << std::endl;
+}
+
+TEST(MpscTaskQueue, post_in_order) {
+  auto factory = webrtc::CreateMpscTaskQueueFactory();
+  post_from_producers(factory.get(), "mpsc", 4, 10000);
+}
+
+TEST(MpscTaskQueue, delayed_task) {
+  auto factory = webrtc::CreateMpscTaskQueueFactory();
+  auto queue = factory->CreateTaskQueue(
+      "mpsc", TaskQueueFactory::Priority::NORMAL);
+
+  std::atomic<bool> fired{false};
+  auto start = std::chrono::steady_clock::now();
+  queue->PostDelayedTask(ToQueuedTask([&] { fired = true; }), 20);
+  wait_for([&] { return fired.load(); }, 1000);
+
+  EXPECT_TRUE(fired);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 
+            std::chrono::milliseconds(20));
+}
+
+TEST(MpscTaskQueue, delete_pending) {
+  auto factory = webrtc::CreateMpscTaskQueueFactory();
+  auto queue = factory->CreateTaskQueue(
+      "mpsc", TaskQueueFactory::Priority::NORMAL);
+
+  auto alive = std::make_shared<int>(0);
+  std::atomic<bool> block{true};
+  queue->PostTask(ToQueuedTask([&] { 
+    while (block) std::this_thread::yield(); 
+  }));
+  for (int i = 0; i < 100; ++i) {
+    queue->PostTask(ToQueuedTask([alive] {}));
+  }
+  block = false;
+  queue = nullptr;
+
+  // the tasks run or deleted without running.
+  EXPECT_EQ(alive.use_count(), 1);
+}
+
+// the nodes of the tasks run on the queue come back to the poster.
+TEST(MpscTaskQueue, inline_task_node) {
+  auto factory = webrtc::CreateMpscTaskQueueFactory();
+  auto queue = factory->CreateTaskQueue(
+      "mpsc", TaskQueueFactory::Priority::NORMAL);
+
+  std::atomic<int> done{0};
+  std::set<void*> nodes;
+  for (int i = 0; i < 64; ++i) {
+    auto task = ToQueuedTask([&done] { ++done; });
+    nodes.insert(task.get());
+    queue->PostTask(std::move(task));
+  }
+  wait_for([&] { return done == 64; }, 1000);
+  ASSERT_EQ(done, 64);
+
+  // freed by the queue thread, taken back by the next posts.
+  int reused = 0;
+  for (int i = 0; i < 64; ++i) {
+    auto task = ToQueuedTask([&done] { ++done; });
+    reused += nodes.count(task.get());
+  }
+  EXPECT_GT(reused, 0);
+
+  // the large closures are allocated as before.
+  char big[webrtc::TaskNodePool::kNodeSize] = {0};
+  auto task = ToQueuedTask([big, &done] { done += big[0] + 1; });
+  task->Run();
+  EXPECT_EQ(done, 65);
+}
+
+// the benchmark, compared with the libevent task queue.
+TEST(MpscTaskQueue, benchmark) {
+  auto libevent = webrtc::CreateDefaultTaskQueueFactory();
+  auto mpsc = webrtc::CreateMpscTaskQueueFactory();
+  for (bool busy : {false, true}) {
+    for (int producers : {1, 4}) {
+      post_from_producers(libevent.get(), "libevent", producers, 100000, busy);
+      post_from_producers(mpsc.get(), "mpsc", producers, 100000, busy);
+    }
+  }
+}
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "myrtc/api/default_task_queue_factory.h"
 #include "myrtc/rtc_base/to_queued_task.h"
@@ -26,11 +27,84 @@ Worker::Worker(webrtc::TaskQueueFactory* factory, int id, std::shared_ptr<Clock>
 { }
 
 void Worker::task(Task t) {
-  task_queue_->PostTask(webrtc::ToQueuedTask(std::forward<Task>(t)));
+  task_queue_->PostTask(webrtc::ToQueuedTask(
+      [this, f = std::forward<Task>(t), queued = clock_->now()]() {
+        run(f, queued);
+      }));
 }
 
 void Worker::task(Task t, const rtc::Location& r) {
-  task_queue_->PostTask(webrtc::ToQueuedTask(std::forward<Task>(t), r));
+  task_queue_->PostTask(webrtc::ToQueuedTask(
+      [this, f = std::forward<Task>(t), queued = clock_->now()]() {
+        run(f, queued);
+      }, r));
+}
+
+namespace {
+// the functions run on the end of the current task.
+thread_local std::vector<Worker::Task>* t_task_end = nullptr;
+}
+
+bool Worker::atTaskEnd(Task f) {
+  if (!t_task_end) {
+    return false;
+  }
+  t_task_end->emplace_back(std::move(f));
+  return true;
+}
+
+void Worker::run(const Task& t, time_point queued) {
+  time_point start = clock_->now();
+  std::vector<Task> task_end;
+  t_task_end = &task_end;
+  t();
+  // may add more.
+  for (size_t i = 0; i < task_end.size(); ++i) {
+    task_end[i]();
+  }
+  t_task_end = nullptr;
+  busy_ += clock_->now() - start;
+  queue_delay_ += std::max(start - queued, duration(0));
+  ++tasks_;
+}
+
+bool Worker::sampleLoad() {
+  time_point now = clock_->now();
+  duration elapsed = now - sample_time_;
+  if (elapsed <= duration(0)) {
+    return !closed_;
+  }
+
+  using std::chrono::microseconds;
+  using std::chrono::duration_cast;
+  int busy = std::min<int64_t>(busy_.count() * 1000 / elapsed.count(), 1000);
+  int64_t tasks = tasks_ * 1000 / std::max<int64_t>(
+      ClockUtils::durationToMs(elapsed), 1);
+  int64_t delay = 0, cost = 0;
+  if (tasks_ > 0) {
+    delay = duration_cast<microseconds>(queue_delay_).count() / tasks_;
+    cost = duration_cast<microseconds>(busy_).count() / tasks_;
+  }
+
+  // smooth it over the last seconds.
+  load_busy_ = (load_busy_ + busy) / 2;
+  load_queue_delay_ = (load_queue_delay_ + delay) / 2;
+  load_task_cost_ = (load_task_cost_ + cost) / 2;
+  load_tasks_ = (load_tasks_ + tasks) / 2;
+
+  busy_ = queue_delay_ = duration(0);
+  tasks_ = 0;
+  sample_time_ = now;
+  return !closed_;
+}
+
+WorkerLoad Worker::load() {
+  WorkerLoad l;
+  l.busy = load_busy_;
+  l.queue_delay = load_queue_delay_;
+  l.task_cost = load_task_cost_;
+  l.tasks = load_tasks_;
+  return l;
 }
 
 void Worker::start(const std::string& name) {
@@ -50,6 +124,11 @@ void Worker::start(std::shared_ptr<std::promise<void>> start_promise,
   task_queue_->PostTask([start_promise] {
     start_promise->set_value();
   });
+
+  sample_time_ = clock_->now();
+  scheduleEvery([this]() {
+    return sampleLoad();
+  }, std::chrono::seconds(1));
 }
 
 void Worker::close() {
@@ -69,9 +148,10 @@ std::shared_ptr<ScheduledTaskReference>
   auto id = std::make_shared<ScheduledTaskReference>();
   task_queue_->PostDelayedTask(
       webrtc::ToQueuedTask(std::forward<std::function<void()>>(
-          [f = std::forward<Task>(t), id]() {
+          [this, f = std::forward<Task>(t), id, 
+           due = clock_->now() + delta]() {
             if (!id->isCancelled()) {
-              f();
+              run(f, due);
             }
           }), l),
       ClockUtils::durationToMs(delta));
@@ -112,14 +192,23 @@ void Worker::unschedule(std::shared_ptr<ScheduledTaskReference> id) {
 ////////////////////////////////////////////////////////////////////////////////
 //ThreadPool
 ////////////////////////////////////////////////////////////////////////////////
+// the locked one of libevent by default, the lock-free mpsc one if opted in.
 static std::unique_ptr<webrtc::TaskQueueFactory> g_task_queue_factory = 
     webrtc::CreateDefaultTaskQueueFactory();
+static std::unique_ptr<webrtc::TaskQueueFactory> g_mpsc_task_queue_factory = 
+    webrtc::CreateMpscTaskQueueFactory();
+static std::atomic<bool> g_use_mpsc{false};
+
+void ThreadPool::useMpscTaskQueue(bool on) {
+  g_use_mpsc = on;
+}
 
 ThreadPool::ThreadPool(unsigned int num_workers) {
+  webrtc::TaskQueueFactory* factory = g_use_mpsc ? 
+      g_mpsc_task_queue_factory.get() : g_task_queue_factory.get();
   workers_.reserve(num_workers);
   for (unsigned int index = 0; index < num_workers; ++index) {
-    workers_.push_back( 
-        std::make_shared<Worker>(g_task_queue_factory.get(), index));
+    workers_.push_back(std::make_shared<Worker>(factory, index));
   }
 }
 
@@ -127,11 +216,27 @@ ThreadPool::~ThreadPool() {
   close();
 }
 
+// the loads differ less than it are close.
+static constexpr int kLoadBucket = 50;  // permille
+
 std::shared_ptr<Worker> ThreadPool::getLessUsedWorker() {
-  std::shared_ptr<Worker> chosen_worker = workers_.front();
+  return getLessUsedWorker(std::vector<Worker*>{});
+}
+
+std::shared_ptr<Worker> ThreadPool::getLessUsedWorker(
+    const std::vector<Worker*>& excluded) {
+  std::shared_ptr<Worker> chosen_worker;
+  int chosen_load = 0;
   for (auto worker : workers_) {
-    if (chosen_worker.use_count() > worker.use_count()) {
+    if (std::find(excluded.begin(), excluded.end(), worker.get()) != 
+        excluded.end()) {
+      continue;
+    }
+    int load = worker->load().busy / kLoadBucket;
+    if (!chosen_worker || load < chosen_load || (load == chosen_load && 
+        chosen_worker.use_count() > worker.use_count())) {
       chosen_worker = worker;
+      chosen_load = load;
     }
   }
   return chosen_worker;
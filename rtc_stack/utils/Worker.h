@@ -8,6 +8,7 @@
 #define __WA_SRC_THREAD_WORKER_H__
 
 #include <algorithm>
+#include <atomic>
 #include <memory>
 #include <future>  // NOLINT
 #include <vector>
@@ -28,6 +29,14 @@ class ScheduledTaskReference {
   std::atomic<bool> cancelled_{false};
 };
 
+// The load of a worker, smoothed per second.
+struct WorkerLoad {
+  int busy{0};                // permille of the time running tasks
+  int64_t queue_delay{0};     // us, the average latency before running
+  int64_t task_cost{0};       // us, the average running time of a task
+  int64_t tasks{0};           // tasks per second
+};
+
 class Worker final : public std::enable_shared_from_this<Worker> {
  public:
   typedef std::function<void()> Task;
@@ -66,9 +75,20 @@ class Worker final : public std::enable_shared_from_this<Worker> {
     return task_queue_base_->IsCurrent();
   }
 
+  // thread safe.
+  WorkerLoad load();
+
+  // Run |f| on the end of the task running on the current thread, to batch
+  // the work of a task like the packets it sends. Returns false if not in
+  // a task of a worker.
+  static bool atTaskEnd(Task f);
+
  private:
   void scheduleEvery(ScheduledTask&& f, duration period, 
       duration next_delaym, const rtc::Location& l);
+  // run the task and account the time.
+  void run(const Task& t, time_point queued);
+  bool sampleLoad();
 
  protected:
   int next_scheduled_ = 0;
@@ -80,6 +100,18 @@ class Worker final : public std::enable_shared_from_this<Worker> {
   std::atomic<bool> closed_{false};
   std::unique_ptr<rtc::TaskQueue> task_queue_;
   webrtc::TaskQueueBase* task_queue_base_;
+
+  // the load accounted in worker thread since the last sample.
+  duration busy_{0};
+  duration queue_delay_{0};
+  int64_t tasks_{0};
+  time_point sample_time_;
+
+  // the smoothed load.
+  std::atomic<int> load_busy_{0};
+  std::atomic<int64_t> load_queue_delay_{0};
+  std::atomic<int64_t> load_task_cost_{0};
+  std::atomic<int64_t> load_tasks_{0};
 };
 
 class ThreadPool {
@@ -87,10 +119,23 @@ class ThreadPool {
   explicit ThreadPool(unsigned int num_workers);
   ~ThreadPool();
 
+  // The task queues of the pools made after it, the lock-free mpsc one of
+  // CreateMpscTaskQueueFactory if |on|, the one of libevent by default.
+  static void useMpscTaskQueue(bool on);
+
+  // the least loaded one by the busy time measured, the one used by less
+  // users if the loads are close.
   std::shared_ptr<Worker> getLessUsedWorker();
+  // the less used one except the excluded, nullptr if all excluded.
+  std::shared_ptr<Worker> getLessUsedWorker(
+      const std::vector<Worker*>& excluded);
   void start(const std::string& name);
   void close();
 
+  inline const std::vector<std::shared_ptr<Worker>>& getWorkers() {
+    return workers_;
+  }
+
  private:
   std::vector<std::shared_ptr<Worker>> workers_;
 };
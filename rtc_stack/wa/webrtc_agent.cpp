@@ -10,6 +10,7 @@
 #include "webrtc_agent_pc.h"
 #include "webrtc_track.h"
 #include "erizo/global_init.h"
+#include "erizo/IceLiteConnection.h"
 #include "event.h"
 
 using namespace erizo;
@@ -49,6 +50,23 @@ int WebrtcAgent::Open(uint32_t num_workers,
 
     event_set_log_callback(lib_evnet_log);
     global_init_ = true;
+
+    // "udp://ip:port", all the peers share the port by ice-lite.
+    const std::string scheme{"udp://"};
+    size_t colon = service_addr.rfind(':');
+    if (service_addr.compare(0, scheme.size(), scheme) == 0 &&
+        colon > scheme.size()) {
+      std::vector<std::shared_ptr<IOWorker>> ioworkers;
+      for (uint32_t i = 0; i < num_workers; ++i) {
+        ioworkers.emplace_back(io_workers_->getIOWorker(i));
+      }
+      std::string ip = service_addr.substr(scheme.size(), colon - scheme.size());
+      int port = atoi(service_addr.c_str() + colon + 1);
+      if (port <= 0 || port > 65535 || 
+          !IceLiteMux::start(ip, (uint16_t)port, ioworkers)) {
+        ELOG_WARN("listen %s failed, use libnice", service_addr.c_str());
+      }
+    }
   }
 
   ELOG_INFO("WebrtcAgent initiate %d workers, ip:%s", 
@@ -69,6 +87,7 @@ void WebrtcAgent::Close() {
     event_set_log_callback(nullptr);
     workers_->close();
     io_workers_->close();
+    IceLiteMux::stop();
     global_init_ = false;
   }
 }
@@ -68,13 +68,26 @@ void WrtcAgentPcBase::subscribe_i(
       continue;
     }
     
+    // the packets forwarded as received if both webrtc of the same format,
+    // the frames packetized otherwise.
+    auto forwarder = dest_track->forwarder(isAudio);
     if (isSub) {
+      if (forwarder && 
+          src_track->format(isAudio) == dest_track->format(isAudio) &&
+          src_track->addForwarder(isAudio, forwarder)) {
+        OLOG_INFO("sub forward, s:" << track_name <<
+                  id() << ", d:" << dest_track->pcId());
+        continue;
+      }
       OLOG_INFO("sub, s:" << track_name <<
                 id() << ", d:" << dest_track->pcId());
       src_track->addDestination(isAudio, receiver);
     } else {
       OLOG_INFO("unsub, s:" << track_name <<
                 id() << ", d:" << dest_track->pcId());
+      if (forwarder) {
+        src_track->removeForwarder(isAudio, forwarder.get());
+      }
       src_track->removeDestination(isAudio, receiver.get());
     }
   }
@@ -438,6 +451,7 @@ srs_error_t WrtcAgentPc::setupTransport(MediaDesc& media, bool& bPublish) {
   auto& rids = media.rids_;
   bPublish = (opSettings.sdp_direction_ == "sendonly");
   TrackSetting trackSetting = media.getTrackSettings();
+  trackSetting.forward_rtp = config_.forward_rtp_;
 
   if (rids.empty()) {
     // No simulcast    
@@ -8,6 +8,11 @@
 namespace wa {
 static log4cxx::LoggerPtr logger = log4cxx::Logger::getLogger("wa.track");
 
+// The extension ids of the packets packetized once, the subscribers' ids
+// and values stamped by the forwarders.
+constexpr uint8_t kSharedTransportCcId = 1;
+constexpr uint8_t kSharedAbsSendTimeId = 2;
+
 ///////////////////////////////////////////////////////////////////////////////
 //WebrtcTrackBase
 ///////////////////////////////////////////////////////////////////////////////
@@ -28,6 +33,17 @@ WebrtcTrackBase::WebrtcTrackBase(const std::string& mid, WrtcAgentPcBase* pc,
       audioFrameConstructor_->bindTransport(
           dynamic_cast<erizo::MediaSource*>(ms),
           dynamic_cast<erizo::FeedbackSink*>(ms));
+      if (ms) {
+        owt_base::RtpForwardSource::Config forward;
+        forward.audio = true;
+        forward.ssrc = setting.ssrcs[0];
+        forward.rtp_payload_type = setting.format;
+        forward.worker = pc->worker_.get();
+        forward.stream = ms;
+        audioForwardSource_ = std::make_shared<owt_base::RtpForwardSource>(
+            forward, audioFrameConstructor_);
+        audioFrameConstructor_->setPacketSink(audioForwardSource_.get());
+      }
       pc->setAudioSsrc(mid_, setting.ssrcs[0]);
     } else {
       videoFormat_ = setting.format;
@@ -49,12 +65,33 @@ WebrtcTrackBase::WebrtcTrackBase(const std::string& mid, WrtcAgentPcBase* pc,
       videoFrameConstructor_->bindTransport(
           dynamic_cast<erizo::MediaSource*>(ms),
           dynamic_cast<erizo::FeedbackSink*>(ms));
+      if (ms) {
+        owt_base::RtpForwardSource::Config forward;
+        forward.ssrc = setting.ssrcs[0];
+        forward.rtx_ssrc = setting.ssrcs[1];
+        forward.rtp_payload_type = setting.format;
+        forward.worker = pc->worker_.get();
+        forward.stream = ms;
+        videoForwardSource_ = std::make_shared<owt_base::RtpForwardSource>(
+            forward, videoFrameConstructor_);
+        videoFrameConstructor_->setPacketSink(videoForwardSource_.get());
+      }
       pc->setVideoSsrcList(mid_, setting.ssrcs);
     }
   }
 }
 
 void WebrtcTrackBase::close() {
+  if (audioForwardSource_) {
+    audioForwardSource_->close();
+    audioForwardSource_ = nullptr;
+  }
+
+  if (videoForwardSource_) {
+    videoForwardSource_->close();
+    videoForwardSource_ = nullptr;
+  }
+
   if (audioFrameConstructor_) {
     audioFrameConstructor_->close();
     audioFrameConstructor_ = nullptr;
@@ -65,6 +102,24 @@ void WebrtcTrackBase::close() {
     videoFrameConstructor_ = nullptr;
   }
 }
+
+bool WebrtcTrackBase::addForwarder(
+    bool isAudio, std::shared_ptr<owt_base::RtpForwarder> forwarder) {
+  auto& source = isAudio ? audioForwardSource_ : videoForwardSource_;
+  if (!source) {
+    return false;
+  }
+  source->addForwarder(std::move(forwarder));
+  return true;
+}
+
+void WebrtcTrackBase::removeForwarder(
+    bool isAudio, owt_base::RtpForwarder* forwarder) {
+  auto& source = isAudio ? audioForwardSource_ : videoForwardSource_;
+  if (source) {
+    source->removeForwarder(forwarder);
+  }
+}
 ///////////////////////////////////////////////////////////////////////////////
 //WebrtcTrack
 ///////////////////////////////////////////////////////////////////////////////
@@ -87,6 +142,13 @@ WebrtcTrack::WebrtcTrack(const std::string& mid,
       audioFramePacketizer_ = 
           std::move(std::make_shared<owt_base::AudioFramePacketizer>(config));
       audioFramePacketizer_->bindTransport(dynamic_cast<erizo::MediaSink*>(ms));
+      if (setting.forward_rtp) {
+        owt_base::RtpForwarder::Config forward;
+        forward.audio = true;
+        forward.worker = pc->worker_.get();
+        audioForwarder_ = std::make_shared<owt_base::RtpForwarder>(forward);
+        audioForwarder_->bindTransport(ms, audioFramePacketizer_.get());
+      }
       audioFormat_ = setting.format;
     } else {
       owt_base::VideoFramePacketizer::Config config;
@@ -101,6 +163,12 @@ WebrtcTrack::WebrtcTrack(const std::string& mid,
       videoFramePacketizer_ =
           std::move(std::make_shared<owt_base::VideoFramePacketizer>(config));
       videoFramePacketizer_->bindTransport(dynamic_cast<erizo::MediaSink*>(ms));
+      if (setting.forward_rtp) {
+        owt_base::RtpForwarder::Config forward;
+        forward.worker = pc->worker_.get();
+        videoForwarder_ = std::make_shared<owt_base::RtpForwarder>(forward);
+        videoForwarder_->bindTransport(ms, videoFramePacketizer_.get());
+      }
       videoFormat_ = setting.format;
     }
   }
@@ -112,6 +180,16 @@ WebrtcTrack::~WebrtcTrack() {
 }
 
 void WebrtcTrack::close() {
+  if (audioForwarder_) {
+    audioForwarder_->close();
+    audioForwarder_ = nullptr;
+  }
+
+  if (videoForwarder_) {
+    videoForwarder_->close();
+    videoForwarder_ = nullptr;
+  }
+
   if (audioFramePacketizer_) {
     audioFramePacketizer_->close();
     audioFramePacketizer_ = nullptr;
@@ -162,6 +240,13 @@ std::shared_ptr<owt_base::FrameDestination>
   return videoFramePacketizer_;
 }
 
+std::shared_ptr<owt_base::RtpForwarder> WebrtcTrack::forwarder(bool isAudio) {
+  if (isAudio) {
+    return audioForwarder_;
+  }
+  return videoForwarder_;
+}
+
 srs_error_t WebrtcTrack::trackControl(
     ETrackCtrl track, bool isIn, bool isOn) {
   bool trackUpdate = false;
@@ -172,6 +257,9 @@ srs_error_t WebrtcTrack::trackControl(
     }
     if (!isIn && audioFramePacketizer_) {
       audioFramePacketizer_->enable(isOn);
+      if (audioForwarder_) {
+        audioForwarder_->enable(isOn);
+      }
       trackUpdate = true;
     }
   }
@@ -183,6 +271,9 @@ srs_error_t WebrtcTrack::trackControl(
     }
     if (!isIn && videoFramePacketizer_) {
       videoFramePacketizer_->enable(isOn);
+      if (videoForwarder_) {
+        videoForwarder_->enable(isOn);
+      }
       trackUpdate = true;
     }
   }
@@ -232,6 +323,12 @@ WebrtcTrackDumy::WebrtcTrackDumy(const std::string& mid,
   : WebrtcTrackBase(mid, pc, isPublish, setting, nullptr) { }
 
 void WebrtcTrackDumy::close() {
+  if (audioPacketizer_) {
+    stopPacketizer(true);
+  }
+  if (videoPacketizer_) {
+    stopPacketizer(false);
+  }
   WebrtcTrackBase::close();
 }
 
@@ -253,6 +350,114 @@ void WebrtcTrackDumy::removeDestination(
   }    
 }
 
+bool WebrtcTrackDumy::addForwarder(
+    bool isAudio, std::shared_ptr<owt_base::RtpForwarder> forwarder) {
+  auto& forwarders = isAudio ? audioForwarders_ : videoForwarders_;
+  if (forwarders.empty() && !startPacketizer(isAudio)) {
+    return false;
+  }
+  forwarders.insert(forwarder.get());
+
+  // the forwarders of a source on its worker.
+  auto source = isAudio ? audioForwardSource_ : videoForwardSource_;
+  pc_->worker_->task([source, forwarder = std::move(forwarder)] {
+    source->addForwarder(forwarder);
+  }, RTC_FROM_HERE);
+  return true;
+}
+
+void WebrtcTrackDumy::removeForwarder(
+    bool isAudio, owt_base::RtpForwarder* forwarder) {
+  auto& forwarders = isAudio ? audioForwarders_ : videoForwarders_;
+  if (forwarders.erase(forwarder) == 0) {
+    return;
+  }
+
+  auto source = isAudio ? audioForwardSource_ : videoForwardSource_;
+  pc_->worker_->task([source, forwarder] {
+    source->removeForwarder(forwarder);
+  }, RTC_FROM_HERE);
+  if (forwarders.empty()) {
+    stopPacketizer(isAudio);
+  }
+}
+
+bool WebrtcTrackDumy::startPacketizer(bool isAudio) {
+  if (!pc_->adapter_factory_) {
+    return false;
+  }
+
+  owt_base::RtpForwardSource::Config forward;
+  forward.audio = isAudio;
+  forward.rtp_payload_type = format(isAudio);
+  forward.worker = pc_->worker_.get();
+
+  if (isAudio) {
+    owt_base::AudioFramePacketizer::Config config;
+    config.factory = pc_->adapter_factory_.get();
+    config.task_queue = pc_->worker_->getTaskQueue();
+    audioPacketizer_ = 
+        std::make_shared<owt_base::AudioFramePacketizer>(config);
+    forward.ssrc = audioPacketizer_->getSsrc();
+    audioForwardSource_ = std::make_shared<owt_base::RtpForwardSource>(
+        forward, weak_from_this());
+    audioPacketizer_->bindTransport(audioForwardSource_.get());
+    addAudioDestination(audioPacketizer_);
+  } else {
+    // the slots restamped for each subscriber, no red, no fec.
+    owt_base::VideoFramePacketizer::Config config;
+    config.Red = -1;
+    config.Ulpfec = -1;
+    config.transportccExt = kSharedTransportCcId;
+    config.absSendTimeExt = kSharedAbsSendTimeId;
+    config.factory = pc_->adapter_factory_.get();
+    config.task_queue = pc_->worker_->getTaskQueue();
+    videoPacketizer_ = 
+        std::make_shared<owt_base::VideoFramePacketizer>(config);
+
+    auto extensions = std::make_shared<owt_base::RtpExtensionMap>();
+    extensions->fill(erizo::UNKNOWN);
+    (*extensions)[kSharedTransportCcId] = erizo::TRANSPORT_CC;
+    (*extensions)[kSharedAbsSendTimeId] = erizo::ABS_SEND_TIME;
+    forward.extensions = std::move(extensions);
+    forward.ssrc = videoPacketizer_->getSsrc();
+    videoForwardSource_ = std::make_shared<owt_base::RtpForwardSource>(
+        forward, weak_from_this());
+    videoPacketizer_->bindTransport(videoForwardSource_.get());
+    addVideoDestination(videoPacketizer_);
+  }
+  OLOG_INFO(pc_id_ << ", " << name_ << " packetized once for the forwarders");
+  return true;
+}
+
+void WebrtcTrackDumy::stopPacketizer(bool isAudio) {
+  std::shared_ptr<owt_base::AudioFramePacketizer> audio;
+  std::shared_ptr<owt_base::VideoFramePacketizer> video;
+  std::shared_ptr<owt_base::RtpForwardSource> source;
+  if (isAudio) {
+    removeAudioDestination(audioPacketizer_.get());
+    audio = std::move(audioPacketizer_);
+    source = std::move(audioForwardSource_);
+    audioForwarders_.clear();
+  } else {
+    removeVideoDestination(videoPacketizer_.get());
+    video = std::move(videoPacketizer_);
+    source = std::move(videoForwardSource_);
+    videoForwarders_.clear();
+  }
+
+  // the packets of the packetizer are given to the source on the worker.
+  pc_->worker_->task([audio, video, source] {
+    source->close();
+    if (audio) {
+      audio->close();
+    }
+    if (video) {
+      video->close();
+    }
+  }, RTC_FROM_HERE);
+}
+
 void WebrtcTrackDumy::onFrame(std::shared_ptr<owt_base::Frame> frm) {  
   deliverFrame(std::move(frm));
 }
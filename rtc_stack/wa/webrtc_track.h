@@ -9,6 +9,7 @@
 
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
 
 #include "owt/owt_base/AudioFramePacketizer.h"
@@ -46,6 +47,7 @@ class WebrtcTrack final : public WebrtcTrackBase,
       std::shared_ptr<owt_base::FrameDestination> dest) override;
   void removeDestination(bool isAudio, owt_base::FrameDestination* dest) override;
   std::shared_ptr<owt_base::FrameDestination> receiver(bool isAudio) override;
+  std::shared_ptr<owt_base::RtpForwarder> forwarder(bool isAudio) override;
   
   uint32_t ssrc(bool isAudio) override;
   
@@ -60,6 +62,9 @@ class WebrtcTrack final : public WebrtcTrackBase,
 
   std::shared_ptr<owt_base::AudioFramePacketizer> audioFramePacketizer_;
   std::shared_ptr<owt_base::VideoFramePacketizer> videoFramePacketizer_;
+  // not null if forward_rtp, the packetizers for the frame sources only.
+  std::shared_ptr<owt_base::RtpForwarder> audioForwarder_;
+  std::shared_ptr<owt_base::RtpForwarder> videoForwarder_;
 };
 
 class WrtcAgentPcDummy;
@@ -92,7 +97,24 @@ class WebrtcTrackDumy : public WebrtcTrackBase, public owt_base::FrameSource {
   void requestKeyFrame() override {}
   void stopRequestKeyFrame() override {}
 
+  // The frames packetized once for all the forwarders instead of by the
+  // packetizer of each subscriber, by the caller of the frames.
+  bool addForwarder(bool isAudio, 
+      std::shared_ptr<owt_base::RtpForwarder> forwarder) override;
+  void removeForwarder(bool isAudio, owt_base::RtpForwarder* forwarder) override;
+
   void onFrame(std::shared_ptr<owt_base::Frame>);
+
+ private:
+  bool startPacketizer(bool isAudio);
+  void stopPacketizer(bool isAudio);
+
+ private:
+  // shared by the forwarders, the packets to the forward sources.
+  std::shared_ptr<owt_base::AudioFramePacketizer> audioPacketizer_;
+  std::shared_ptr<owt_base::VideoFramePacketizer> videoPacketizer_;
+  std::unordered_set<owt_base::RtpForwarder*> audioForwarders_;
+  std::unordered_set<owt_base::RtpForwarder*> videoForwarders_;
 };
 
 } //namespace wa
@@ -10,6 +10,7 @@
 #include "erizo/MediaStream.h"
 #include "owt/owt_base/VideoFrameConstructor.h"
 #include "owt/owt_base/AudioFrameConstructor.h"
+#include "owt/owt_base/RtpForwarder.h"
 
 namespace wa {
 
@@ -26,6 +27,8 @@ struct TrackSetting {
   int ulpfec{-1};
   bool flexfec{false};
   int transportcc{-1};
+  // subscribe the rtp packets of a webrtc publisher instead of the frames.
+  bool forward_rtp{false};
 };
 
 class WrtcAgentPc;
@@ -57,6 +60,17 @@ class WebrtcTrackBase {
   virtual void requestKeyFrame() = 0;
   virtual void stopRequestKeyFrame() = 0;
 
+  // the forwarder of a subscriber track in the rtp forwarding.
+  virtual std::shared_ptr<owt_base::RtpForwarder> forwarder(bool isAudio) {
+    return nullptr;
+  }
+
+  // Forwards the rtp packets received to |forwarder|, false if not a 
+  // webrtc publisher.
+  virtual bool addForwarder(bool isAudio, 
+      std::shared_ptr<owt_base::RtpForwarder> forwarder);
+  virtual void removeForwarder(bool isAudio, owt_base::RtpForwarder* forwarder);
+
   int32_t format(bool isAudio) { return isAudio?audioFormat_:videoFormat_; }
   
   inline bool isAudio() {
@@ -82,6 +96,8 @@ class WebrtcTrackBase {
 
   std::shared_ptr<owt_base::AudioFrameConstructor> audioFrameConstructor_;  
   std::shared_ptr<owt_base::VideoFrameConstructor> videoFrameConstructor_;
+  std::shared_ptr<owt_base::RtpForwardSource> audioForwardSource_;
+  std::shared_ptr<owt_base::RtpForwardSource> videoForwardSource_;
 };
 
 }; //namespace wa
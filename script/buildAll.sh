@@ -130,6 +130,12 @@ RTMP_PUBLISHER_SRC_FILES="$EXAMPLE_PATH/main.cpp \
 	$EXAMPLE_PATH/example_flv_loop_reader.cpp \
 	$EXAMPLE_PATH/example_rtmp_publisher.cpp"
 
+TEST_PATH=$CURRENT_DIR/test
+MA_TEST_SRC_FILES="$TEST_PATH/media_consumer_ut.cpp \
+	$TEST_PATH/http_parser_ut.cpp \
+	$TEST_PATH/http_writev_ut.cpp \
+	$TEST_PATH/media_sharded_map_ut.cpp"
+
 DEPS_LIBS="./build/ma/libma.a \
 	$PREFIX_DIR/lib/libavcodec.a \
 	$PREFIX_DIR/lib/libswresample.a \
@@ -160,6 +166,10 @@ g++ -o mia $DEBUG_FLAG $COMMON_FLAG $MIA_SRC_FILES $DEPS_INCLUDE $DEPS_LIBS
 g++ -o rtc_push $DEBUG_FLAG $COMMON_FLAG $RTC_PUBLISHER_SRC_FILES $DEPS_INCLUDE $DEPS_LIBS
 
 g++ -o rtmp_push $DEBUG_FLAG -$COMMON_FLAG $RTMP_PUBLISHER_SRC_FILES $DEPS_INCLUDE $DEPS_LIBS
+
+g++ -o ma_test $DEBUG_FLAG $COMMON_FLAG $MA_TEST_SRC_FILES $DEPS_INCLUDE \
+	-I$PREFIX_DIR/include $DEPS_LIBS \
+	$PREFIX_DIR/lib/libgtest.a $PREFIX_DIR/lib/libgtest_main.a
 	
 echo "build mia done"
 
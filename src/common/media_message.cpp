@@ -60,6 +60,8 @@ MediaMessage::MediaMessage(MediaMessage&& r)
   header_ = r.header_;
   payload_ = r.payload_;
   r.payload_ = nullptr;
+  flv_tag_ = r.flv_tag_;
+  r.flv_tag_ = nullptr;
 }
 
 MediaMessage::~MediaMessage() {
@@ -67,16 +69,29 @@ MediaMessage::~MediaMessage() {
     payload_->DestroyChained();
     payload_ = nullptr;
   }
+  if (flv_tag_) {
+    flv_tag_->DestroyChained();
+    flv_tag_ = nullptr;
+  }
 }
 
 void MediaMessage::operator=(MediaMessage&& r) {
   header_ = r.header_;
   payload_ = r.payload_;
   r.payload_ = nullptr;
+  if (flv_tag_) {
+    flv_tag_->DestroyChained();
+  }
+  flv_tag_ = r.flv_tag_;
+  r.flv_tag_ = nullptr;
 }
 
 void MediaMessage::operator=(const MediaMessage& r) {
   header_ = r.header_;
+  if (flv_tag_) {
+    flv_tag_->DestroyChained();
+    flv_tag_ = nullptr;
+  }
   if (r.payload_) {
     payload_ = r.payload_->DuplicateChained();
   } else {
@@ -89,6 +104,10 @@ void MediaMessage::create(MessageHeader* pheader, MessageChain* data) {
   if (payload_) {
     payload_->DestroyChained();
   }
+  if (flv_tag_) {
+    flv_tag_->DestroyChained();
+    flv_tag_ = nullptr;
+  }
   payload_ = data->DuplicateChained();
 }
 
@@ -80,6 +80,20 @@ class MediaMessage final {
   int64_t& timestamp_;
   int32_t& size_;
   MessageChain* payload_{nullptr};
+  // The serialized flv tag(tag header, payload and previous tag size) 
+  // stamped with timestamp_, encoded once by the live source and shared 
+  // by all the flv consumers, never copied with the message.
+  // @see SrsFlvStreamEncoder::encode_tag
+  MessageChain* flv_tag_{nullptr};
+};
+
+// The message delivered to a consumer.
+// The MediaMessage is shared by all consumers of a stream and must not be
+// modified after dispatching, the timestamp is corrected for each consumer
+// by its jitter algorithm, and used when the message is muxed.
+struct MediaPacket {
+  std::shared_ptr<MediaMessage> msg_;
+  int64_t timestamp_{0};
 };
 
 
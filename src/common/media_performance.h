@@ -10,6 +10,7 @@
 #define __MEDIA_PERFORMACE_H__
 
 #include <chrono>
+#include <cstdint>
 
 namespace ma {
 // following annotation is useless
@@ -57,6 +58,67 @@ namespace ma {
  */
 constexpr int SRS_PERF_MW_MSGS = 10;
 
+/**
+ * the max bytes queued by the http response writer, not sent to socket,
+ * the writer would block the caller when exceed it, to bound the memory
+ * of the slow peer, about 1s of a 8Mbps stream.
+ */
+constexpr int64_t SRS_PERF_WRITER_QUEUED_BYTES = 1024 * 1024;
+
+/**
+ * the low watermark of the http response writer, the blocked caller is
+ * woken up only when the queued bytes drain below it, so it does not 
+ * bounce around the high watermark by every packet sent.
+ */
+constexpr int64_t SRS_PERF_WRITER_LOW_BYTES = 256 * 1024;
+
+/**
+ * the max iovecs sent by one writev, a chain longer than it is sent by 
+ * more writev, the linux IOV_MAX is 1024.
+ */
+constexpr int SRS_PERF_WRITEV_IOVS = 256;
+
+/**
+ * the writes submitted by one media worker to one io thread and not drained,
+ * a write is posted alone when the ring is full.
+ */
+constexpr int SRS_PERF_WRITE_SUBMIT_RING = 8192;
+
+/**
+ * the hot file cache of the http file server, the files not larger than 
+ * SRS_PERF_FILE_CACHE_MAX_FILE, like the player pages, are served from
+ * memory, the larger ones are sent by sendfile.
+ */
+constexpr int64_t SRS_PERF_FILE_CACHE_BYTES = 16 * 1024 * 1024;
+constexpr int64_t SRS_PERF_FILE_CACHE_MAX_FILE = 256 * 1024;
+
+/**
+ * the http messages released and kept by each thread for reuse, so the
+ * connection storm, for example all players reconnect after a restart,
+ * parses the requests without allocating the messages.
+ */
+constexpr int SRS_PERF_HTTP_MESSAGE_POOL = 256;
+
+/**
+ * the http connection kept alive is closed when nothing is read and no 
+ * response is pending for it, so the idle signalling clients do not hold 
+ * the sockets for ever.
+ */
+constexpr int SRS_PERF_HTTP_KEEPALIVE_IDLE_MS = 30 * 1000;
+
+/**
+ * the sends of one io_uring submission, the http-flv writes drained by an 
+ * io thread at once are sent by one io_uring_enter, the rest by more.
+ */
+constexpr int SRS_PERF_IO_URING_ENTRIES = 256;
+
+/**
+ * the shards of the registries of the streams and connections looked up 
+ * by all the io threads, each shard with its own lock, so the players 
+ * reconnecting together rarely contend.
+ */
+constexpr int SRS_PERF_REGISTRY_SHARDS = 32;
+
 } //namespace ma
 
 #endif //!__MEDIA_PERFORMACE_H__
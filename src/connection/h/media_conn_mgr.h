@@ -8,12 +8,11 @@
 #define __MEDIA_CONNECTION_MANAGER_H__
 
 #include <memory>
-#include <map>
-#include <mutex>
 #include <vector>
 #include <string>
 
 #include "utils/sigslot.h"
+#include "utils/media_sharded_map.h"
 
 namespace ma {
 
@@ -43,8 +42,8 @@ class MediaConnMgr {
  public:
   sigslot::signal1<std::shared_ptr<IMediaConnection>> signal_destroy_conn_;
  private: 
-  std::mutex source_lock_;
-  std::map<IMediaConnection*, std::shared_ptr<IMediaConnection>> connections_;
+  ShardedMap<IMediaConnection*, std::shared_ptr<IMediaConnection>> 
+      connections_;
 
   std::unique_ptr<MediaListenerMgr> listener_;
 };
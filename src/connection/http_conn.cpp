@@ -103,15 +103,33 @@ srs_error_t MediaHttpConn::set_crossdomain_enabled(bool v) {
 
 srs_error_t MediaHttpConn::process_request(std::string_view req) {
   MLOG_TRACE(req);
+  return serve_requests(req, false);
+}
+
+srs_error_t MediaHttpConn::serve_requests(std::string_view req, bool stream) {
   srs_error_t err = srs_success;
-  std::shared_ptr<ISrsHttpMessage> msg;
-  if((err = parser_->parse_message(req, msg)) != srs_success) {
-    return srs_error_wrap(err, "parse_message failed");
-  }
 
-  auto writer = factory_->CreateResponseWriter(false);
-  writer->open();
-  if (msg) {
+  // The pipelined requests are served one by one, the responses are 
+  // written in order of the writers opened.
+  while (true) {
+    std::shared_ptr<ISrsHttpMessage> msg;
+    if((err = parser_->parse_message(req, msg)) != srs_success) {
+      return srs_error_wrap(err, "parse_message failed");
+    }
+
+    if (!msg) {
+      break;
+    }
+    req = std::string_view();
+
+    auto writer = factory_->CreateResponseWriter(stream);
+    writer->open();
+
+    // keep alive unless the client asks to close.
+    if (!msg->is_keep_alive()) {
+      writer->header()->set("Connection", "Close");
+    }
+
     msg->connection(shared_from_this());
     if ((err = cors_->serve_http(writer, msg)) != srs_success) {
       return srs_error_wrap(err, "mux serve");
@@ -152,22 +170,7 @@ MediaResponseOnlyHttpConn::MediaResponseOnlyHttpConn(
 
 srs_error_t MediaResponseOnlyHttpConn::process_request(std::string_view req) {
   MLOG_TRACE(req);
-  srs_error_t err = srs_success;
-  std::shared_ptr<ISrsHttpMessage> msg;
-  if((err = parser_->parse_message(req, msg)) != srs_success) {
-    return srs_error_wrap(err, "parse_message failed");
-  }
-
-  auto writer = factory_->CreateResponseWriter(true);
-  writer->open();
-  if (msg) {
-    msg->connection(shared_from_this());
-    if ((err = cors_->serve_http(writer, msg)) != srs_success) {
-      return srs_error_wrap(err, "mux serve");
-    }
-  }
-
-  return err;
+  return serve_requests(req, true);
 }
 
 }
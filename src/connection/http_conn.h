@@ -37,6 +37,9 @@ class MediaHttpConn : public IMediaConnection,
   std::string Ip() override;
  
  protected:
+  // parse and serve all the requests received, pipelined or not.
+  srs_error_t serve_requests(std::string_view, bool stream);
+
   std::shared_ptr<IHttpRequestReader>  reader_;
   std::unique_ptr<IHttpMessageParser>  parser_;
   IMediaHttpHandler* http_mux_;
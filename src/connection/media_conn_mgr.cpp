@@ -19,17 +19,15 @@ int MediaConnMgr::Init(uint32_t ioworkers,
   }
   
   listener_ = std::move(std::make_unique<MediaListenerMgr>());
-  return listener_->Init(addrs);
+  return listener_->Init(ioworkers, addrs);
 }
 
 void MediaConnMgr::Close() {
   listener_->Close();
 
-  std::lock_guard<std::mutex> guard(source_lock_);
-  for(auto& i : connections_) {
-    i.second->Disconnect();
+  for(auto& i : connections_.Clear()) {
+    i->Disconnect();
   }
-  connections_.clear();
 }
 
 std::shared_ptr<IMediaConnection> MediaConnMgr::CreateConnection(
@@ -46,9 +44,7 @@ std::shared_ptr<IMediaConnection> MediaConnMgr::CreateConnection(
     conn = std::make_shared<MediaDummyConnection>();
   }
 
-  std::lock_guard<std::mutex> guard(source_lock_);
-  connections_.insert(
-      std::make_pair(static_cast<IMediaConnection*>(conn.get()), conn));
+  connections_.Insert(static_cast<IMediaConnection*>(conn.get()), conn);
 
   return conn;
 }
@@ -56,8 +52,7 @@ std::shared_ptr<IMediaConnection> MediaConnMgr::CreateConnection(
 void MediaConnMgr::RemoveConnection(std::shared_ptr<IMediaConnection> p) {
   signal_destroy_conn_(p);
 
-  std::lock_guard<std::mutex> guard(source_lock_);
-  connections_.erase(p.get());
+  connections_.Erase(p.get());
 }
 
 MediaConnMgr g_conn_mgr_;
@@ -1,5 +1,7 @@
 #include "connection/media_listener.h"
 
+#include <atomic>
+
 #include "rtc_base/socket_address.h"
 #include "rtc_base/ssl_adapter.h"
 #include "network/basic_packet_socket_factory.h"
@@ -31,6 +33,9 @@ MediaListenerMgr::IMediaListener::GetSocketType() {
   rtc::PacketSocketServerOptions op;
   op.opts = rtc::PacketSocketFactory::OPT_RAW |
             rtc::PacketSocketFactory::OPT_ADDRESS_REUSE;
+  if (reuse_port_) {
+    op.opts |= rtc::PacketSocketFactory::OPT_PORT_REUSE;
+  }
 
   return op;
 }
@@ -135,10 +140,12 @@ class MediaHttpsListener : public MediaListenerMgr::IMediaListener {
   void CheckClean();
  private:
   rtc::PacketSocketServerOptions GetSocketType() override;
-  static bool inited_;
+  // the ssl is initialized once for the listeners of all io workers.
+  static std::atomic<int> ssl_refs_;
+  bool inited_{false};
 };
 
-bool MediaHttpsListener::inited_{false};
+std::atomic<int> MediaHttpsListener::ssl_refs_{0};
 
 MediaHttpsListener::MediaHttpsListener() {
   CheckInit();
@@ -186,43 +193,60 @@ rtc::PacketSocketServerOptions MediaHttpsListener::GetSocketType() {
   op.opts = rtc::PacketSocketFactory::OPT_RAW |
             rtc::PacketSocketFactory::OPT_TLS_INSECURE |
             rtc::PacketSocketFactory::OPT_ADDRESS_REUSE;
+  if (reuse_port_) {
+    op.opts |= rtc::PacketSocketFactory::OPT_PORT_REUSE;
+  }
+  if (g_server_.config_.https_ktls) {
+    op.opts |= rtc::PacketSocketFactory::OPT_KERNEL_TLS;
+  }
   return op;
 }
 
 void MediaHttpsListener::CheckInit() {
   if (!inited_) {
-    rtc::InitializeSSL();
+    if (ssl_refs_++ == 0) {
+      rtc::InitializeSSL();
+    }
     inited_ = true;
   }
 }
 
 void MediaHttpsListener::CheckClean() {
   if (inited_) {
-    rtc::CleanupSSL();
+    if (--ssl_refs_ == 0) {
+      rtc::CleanupSSL();
+    }
     inited_ = false;
   }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-//MediaHttpsListener
+//MediaListenerMgr
 ///////////////////////////////////////////////////////////////////////////////
 MediaListenerMgr::MediaListenerMgr() = default;
 
-int MediaListenerMgr::Init(const std::vector<std::string>& addr) {
+int MediaListenerMgr::Init(uint32_t ioworkers, 
+                           const std::vector<std::string>& addr) {
+  if (ioworkers == 0) {
+    ioworkers = 1;
+  }
 
-  worker_ = std::move(rtc::Thread::CreateWithSocketServer());
+  workers_.resize(ioworkers);
+  for (uint32_t n = 0; n < ioworkers; ++n) {
+    IoWorker& worker = workers_[n];
+    worker.thread_ = std::move(rtc::Thread::CreateWithSocketServer());
 
-  worker_->SetName("media_listener", nullptr);
-  bool ret = worker_->Start();
-  MA_ASSERT(ret);
+    worker.thread_->SetName("media_listener" + std::to_string(n), nullptr);
+    bool ret = worker.thread_->Start();
+    MA_ASSERT(ret);
 
-  socket_factory_ = std::move(
-      std::make_unique<rtc::BasicPacketSocketFactory>(worker_.get()));
+    worker.socket_factory_ = std::move(
+        std::make_unique<rtc::BasicPacketSocketFactory>(worker.thread_.get()));
+  }
 
   int result = kma_ok;
 
   for(auto& i : addr) {
-    result = worker_->Invoke<int>(RTC_FROM_HERE, [this, i]() {
     std::string_view schema, host;
     int port;
     split_schema_host_port(i, schema, host, port);
@@ -230,17 +254,23 @@ int MediaListenerMgr::Init(const std::vector<std::string>& addr) {
                  << ", port:" << port << "]");
 
     rtc::SocketAddress host_port(std::string{host.data(), host.length()}, port);
-      std::unique_ptr<IMediaListener> listener = CreateListener(schema);
-      int ret = kma_ok;
-      if ((ret = listener->Listen(host_port, socket_factory_.get())) == kma_ok){
-        listeners_.emplace_back(std::move(listener));
+    for (auto& worker : workers_) {
+      result = worker.thread_->Invoke<int>(RTC_FROM_HERE, 
+          [this, &worker, schema, host_port]() {
+        std::unique_ptr<IMediaListener> listener = CreateListener(schema);
+        listener->ReusePort(workers_.size() > 1);
+        int ret = kma_ok;
+        if ((ret = listener->Listen(
+            host_port, worker.socket_factory_.get())) == kma_ok) {
+          worker.listeners_.emplace_back(std::move(listener));
+        }
+        return ret;
+      });
+
+      if (result != kma_ok) {
+        MLOG_CERROR("listen failed, code:%d, address:%s", result, i.c_str());
+        return kma_listen_failed;
       }
-      return ret;
-    });
-
-    if (result != kma_ok) {
-      MLOG_CERROR("listen failed, code:%d, address:%s", result, i.c_str());
-      return kma_listen_failed;
     }
   }
 
@@ -248,12 +278,14 @@ int MediaListenerMgr::Init(const std::vector<std::string>& addr) {
 }
 
 void MediaListenerMgr::Close() {
-  for(auto& i : listeners_) {
-    i->Stop();
-  }
-  listeners_.clear();
+  for (auto& worker : workers_) {
+    for(auto& i : worker.listeners_) {
+      i->Stop();
+    }
+    worker.listeners_.clear();
 
-  worker_->Stop();
+    worker.thread_->Stop();
+  }
 }
 
 std::unique_ptr<MediaListenerMgr::IMediaListener> 
@@ -30,23 +30,32 @@ class MediaListenerMgr {
     virtual void Stop() = 0;
     virtual void OnNewConnectionEvent(
       rtc::AsyncPacketSocket*, rtc::AsyncPacketSocket*);
+    // Listen the address shared with the listeners of other io workers.
+    void ReusePort(bool on) { reuse_port_ = on; }
    protected:
     virtual rtc::PacketSocketServerOptions GetSocketType();  
    protected:
     std::unique_ptr<rtc::AsyncPacketSocket> listen_socket_;
+    bool reuse_port_{false};
   };
  
   MediaListenerMgr();
-  int Init(const std::vector<std::string>& addr);
+  // Every io worker listens all the addresses with SO_REUSEPORT, the kernel
+  // balances the accepted connections among them, and a connection stays
+  // on the worker accepted it.
+  int Init(uint32_t ioworkers, const std::vector<std::string>& addr);
   void Close();
 
  private:
   std::unique_ptr<MediaListenerMgr::IMediaListener> 
       CreateListener(std::string_view);
  private:
-  std::unique_ptr<rtc::Thread> worker_;
-  std::unique_ptr<rtc::PacketSocketFactory> socket_factory_;
-  std::vector<std::unique_ptr<IMediaListener>> listeners_;
+  struct IoWorker {
+    std::unique_ptr<rtc::Thread> thread_;
+    std::unique_ptr<rtc::PacketSocketFactory> socket_factory_;
+    std::vector<std::unique_ptr<IMediaListener>> listeners_;
+  };
+  std::vector<IoWorker> workers_;
 };
 
 } //namespace ma
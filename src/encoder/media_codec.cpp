@@ -176,6 +176,50 @@ bool SrsFlvVideo::h264(const char* data, int size) {
   return codec_id == SrsVideoCodecIdAVC;
 }
 
+bool SrsFlvVideo::disposable(const char* data, int size) {
+  // 1bytes required.
+  if (size < 1) {
+    return false;
+  }
+  
+  char frame_type = data[0];
+  frame_type = (frame_type >> 4) & 0x0F;
+  
+  if (frame_type == SrsVideoAvcFrameTypeDisposableInterFrame) {
+    return true;
+  }
+  
+  // 5bytes header required, frame type, avc packet type and cts.
+  if (frame_type != SrsVideoAvcFrameTypeInterFrame || !h264(data, size) || 
+      size < 5 || data[1] != SrsVideoAvcFrameTraitNALU) {
+    return false;
+  }
+  
+  bool has_slice = false;
+  int pos = 5;
+  while (pos + 4 < size) {
+    uint32_t len = ((uint8_t)data[pos] << 24) | ((uint8_t)data[pos + 1] << 16) |
+        ((uint8_t)data[pos + 2] << 8) | (uint8_t)data[pos + 3];
+    pos += 4;
+    if (len == 0 || len > (uint32_t)(size - pos)) {
+      return false;
+    }
+    
+    uint8_t nalu = (uint8_t)data[pos];
+    int nalu_type = nalu & 0x1f;
+    // the non-IDR and IDR slice.
+    if (nalu_type == 1 || nalu_type == 5) {
+      if (nalu & 0x60) {
+        return false;
+      }
+      has_slice = true;
+    }
+    pos += len;
+  }
+  
+  return has_slice;
+}
+
 bool SrsFlvVideo::acceptable(const char* data, int size) {
   // 1bytes required.
   if (size < 1) {
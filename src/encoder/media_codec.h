@@ -238,6 +238,13 @@ public:
    * check codec h264.
    */
   static bool h264(const char* data, int size);
+  /**
+   * check the frame is not referenced by others, which is safe to drop,
+   * the disposable inter frame, or the h264 inter frame of which all
+   * slices are with nal_ref_idc 0.
+   * @remark the h264 NALUs are assumed to be prefixed by 4bytes length.
+   */
+  static bool disposable(const char* data, int size);
   /**
    * check the video RTMP/flv header info,
    * @return true if video RTMP/flv header is ok.
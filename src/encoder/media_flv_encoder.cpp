@@ -7,6 +7,10 @@
 
 #include "media_flv_encoder.h"
 
+#include <sys/uio.h>
+
+#include <vector>
+
 #include "common/media_kernel_error.h"
 #include "utils/media_kernel_buffer.h"
 #include "common/media_io.h"
@@ -15,8 +19,6 @@
 
 namespace ma {
 
-#define __MIA_OPTIMIZE__
-
 #define SRS_FLV_TAG_HEADER_SIZE 11
 
 #define SRS_FLV_PREVIOUS_TAG_SIZE 4
@@ -59,44 +61,38 @@ class SrsFlvTransmuxer final {
   static int size_tag(int data_size);
 
   // Write the tags in a time.
-  srs_error_t write_tags(std::vector<std::shared_ptr<MediaMessage>>& msgs);
+  srs_error_t write_tags(std::vector<MediaPacket>& msgs);
+
+  // Serialize the flv tag of msg stamped with timestamp.
+  static MessageChain* encode_tag(MediaMessage* msg, int64_t timestamp);
  private:
-  void cache_metadata(char type, char* data, int size, char* cache);
-  void cache_audio(int64_t timestamp, char* data, int size, char* cache);
-  void cache_video(int64_t timestamp, char* data, int size, char* cache);
-  void cache_pts(int size, char* cache);
+  // Add the iovecs of the flv tag of the packet, the shared tag of the 
+  // message if the timestamp is not corrected by jitter, otherwise the tag
+  // header of this consumer in |scratch| before the shared payload.
+  // @return the scratch left.
+  char* fill_tag(const MediaPacket& pkt, char* scratch);
+  // Add the iovecs of the buffers of the chain.
+  void fill(const MessageChain* chain);
+
+  static void cache_metadata(char type, char* data, int size, char* cache);
+  static void cache_audio(int64_t timestamp, char* data, int size, char* cache);
+  static void cache_video(int64_t timestamp, char* data, int size, char* cache);
+  static void cache_pts(int size, char* cache);
   srs_error_t write_tag(char* header, int header_size, char* tag, int tag_size);
  private:
   char tag_header[SRS_FLV_TAG_HEADER_SIZE];
-  // The cache tag header.
-  int nb_tag_headers;
-  char* tag_headers;
-  // The cache pps(previous tag size)
-  int nb_ppts;
-  char* ppts;
-  // The cache iovss.
-  int nb_iovss_cache;
-  iovec* iovss_cache;
+
+  // the tag headers and previous tag sizes of this consumer, and the 
+  // iovecs of the tags written, reused by the writes.
+  std::vector<char> scratch_;
+  std::vector<iovec> iovs_;
 
   ISrsWriter* writer{nullptr};
 };
 
-SrsFlvTransmuxer::SrsFlvTransmuxer() {
-  writer = NULL;
-  
-  nb_tag_headers = 0;
-  tag_headers = NULL;
-  nb_iovss_cache = 0;
-  iovss_cache = NULL;
-  nb_ppts = 0;
-  ppts = NULL;
-}
+SrsFlvTransmuxer::SrsFlvTransmuxer() = default;
 
-SrsFlvTransmuxer::~SrsFlvTransmuxer() {
-  srs_freepa(tag_headers);
-  srs_freepa(iovss_cache);
-  srs_freepa(ppts);
-}
+SrsFlvTransmuxer::~SrsFlvTransmuxer() = default;
 
 srs_error_t SrsFlvTransmuxer::initialize(ISrsWriter* fw) {
   srs_assert(fw);
@@ -195,126 +191,105 @@ int SrsFlvTransmuxer::size_tag(int data_size) {
   return SRS_FLV_TAG_HEADER_SIZE + data_size + SRS_FLV_PREVIOUS_TAG_SIZE;
 }
 
-srs_error_t SrsFlvTransmuxer::write_tags(std::vector<std::shared_ptr<MediaMessage>>& msgs) {
-  int count = (int)msgs.size();
-  srs_error_t err = srs_success;
-  
-  // realloc the tag headers.
-  char* cache = tag_headers;
-  if (nb_tag_headers < count) {
-    srs_freepa(tag_headers);
-    
-    nb_tag_headers = count;
-    cache = tag_headers = new char[SRS_FLV_TAG_HEADER_SIZE * count];
+MessageChain* SrsFlvTransmuxer::encode_tag(MediaMessage* msg, int64_t timestamp) {
+  char header[SRS_FLV_TAG_HEADER_SIZE];
+  char pts[SRS_FLV_PREVIOUS_TAG_SIZE];
+
+  if (msg->is_audio()) {
+    cache_audio(timestamp, nullptr, msg->size_, header);
+  } else if (msg->is_video()) {
+    cache_video(timestamp, nullptr, msg->size_, header);
+  } else {
+    cache_metadata(SrsFrameTypeScript, nullptr, msg->size_, header);
   }
-  
-  // realloc the pts.
-  char* pts = ppts;
-  if (nb_ppts < count) {
-    srs_freepa(ppts);
-    
-    nb_ppts = count;
-    pts = ppts = new char[SRS_FLV_PREVIOUS_TAG_SIZE * count];
+  cache_pts(SRS_FLV_TAG_HEADER_SIZE + msg->size_, pts);
+
+  MessageChain header_mb(SRS_FLV_TAG_HEADER_SIZE, 
+                         header, 
+                         MessageChain::DONT_DELETE, 
+                         SRS_FLV_TAG_HEADER_SIZE);
+  MessageChain pts_mb(SRS_FLV_PREVIOUS_TAG_SIZE, 
+                      pts, 
+                      MessageChain::DONT_DELETE, 
+                      SRS_FLV_PREVIOUS_TAG_SIZE);
+
+  // the payload is not copied, only referenced.
+  MessageChain* tag = header_mb.DuplicateChained();
+  if (msg->payload_) {
+    tag->Append(msg->payload_->DuplicateChained());
   }
+  tag->Append(pts_mb.DuplicateChained());
+  return tag;
+}
 
-#ifndef __MIA_OPTIMIZE__
-  // realloc the iovss.
-  int nb_iovss = 3 * count;
-  iovec* iovss = iovss_cache;
-  if (nb_iovss_cache < nb_iovss) {
-    srs_freepa(iovss_cache);
+char* SrsFlvTransmuxer::fill_tag(const MediaPacket& pkt, char* scratch) {
+  MediaMessage* msg = pkt.msg_.get();
 
-    nb_iovss_cache = nb_iovss;
-    iovss = iovss_cache = new iovec[nb_iovss];
+  // the whole tag is shared if the timestamp is not corrected by jitter.
+  if (msg->flv_tag_ && pkt.timestamp_ == msg->timestamp_) {
+    fill(msg->flv_tag_);
+    return scratch;
   }
-  
-  //TOD need optimizing
-  std::vector<std::string> data_buffer;
-  
-  // the cache is ok, write each messages.
-  iovec* iovs = iovss;
-  for (int i = 0; i < count; i++) {
-    auto& msg = msgs[i];
-
-    data_buffer.emplace_back(std::move(msg->payload_->FlattenChained()));
-    
-    // cache all flv header.
-    if (msg->is_audio()) {
-      cache_audio(msg->timestamp_, nullptr, msg->size_, cache);
-    } else if (msg->is_video()) {
-      cache_video(msg->timestamp_, nullptr, msg->size_, cache);
-    } else {
-      cache_metadata(SrsFrameTypeScript, nullptr, msg->size_, cache);
-    }
-    
-    // cache all pts.
-    cache_pts(SRS_FLV_TAG_HEADER_SIZE + msg->size_, pts);
-    
-    // all ioves.
-    iovs[0].iov_base = cache;
-    iovs[0].iov_len = SRS_FLV_TAG_HEADER_SIZE;
-    iovs[1].iov_base = const_cast<char*>(data_buffer[i].c_str());
-    iovs[1].iov_len = msg->size_;
-    iovs[2].iov_base = pts;
-    iovs[2].iov_len = SRS_FLV_PREVIOUS_TAG_SIZE;
-    
-    // move next.
-    cache += SRS_FLV_TAG_HEADER_SIZE;
-    pts += SRS_FLV_PREVIOUS_TAG_SIZE;
-    iovs += 3;
+
+  // otherwise only the tag header belongs to this consumer.
+  if (msg->is_audio()) {
+    cache_audio(pkt.timestamp_, nullptr, msg->size_, scratch);
+  } else if (msg->is_video()) {
+    cache_video(pkt.timestamp_, nullptr, msg->size_, scratch);
+  } else {
+    cache_metadata(SrsFrameTypeScript, nullptr, msg->size_, scratch);
   }
-  
-  if ((err = writer->writev(iovss, nb_iovss, NULL)) != srs_success) {
-    return srs_error_wrap(err, "write flv tags failed");
+  iovs_.push_back(iovec{scratch, SRS_FLV_TAG_HEADER_SIZE});
+  scratch += SRS_FLV_TAG_HEADER_SIZE;
+
+  // the payload and previous tag size are still shared.
+  if (msg->flv_tag_) {
+    fill(msg->flv_tag_->GetNext());
+    return scratch;
   }
-#else
-  int n_msg = 3 * count;
-  std::vector<MessageChain> tmp_msgs;
-  tmp_msgs.reserve(n_msg);
 
-  int tmp_msgs_idx = 0;
-  
-  for (auto& msg : msgs) {
-    // cache all flv header.
-    if (msg->is_audio()) {
-      cache_audio(msg->timestamp_, nullptr, msg->size_, cache);
-    } else if (msg->is_video()) {
-      cache_video(msg->timestamp_, nullptr, msg->size_, cache);
-    } else {
-      cache_metadata(SrsFrameTypeScript, nullptr, msg->size_, cache);
-    }
-    
-    // cache all pts.
-    cache_pts(SRS_FLV_TAG_HEADER_SIZE + msg->size_, pts);
-    
-    // all ioves.
-    tmp_msgs.emplace_back(SRS_FLV_TAG_HEADER_SIZE,
-                          cache,
-                          MessageChain::DONT_DELETE,
-                          SRS_FLV_TAG_HEADER_SIZE);
-    
-    assert(msg->payload_->GetNext() == nullptr);
-    tmp_msgs.emplace_back(*(msg->payload_));
-    tmp_msgs.emplace_back(SRS_FLV_PREVIOUS_TAG_SIZE,
-                          pts,
-                          MessageChain::DONT_DELETE,
-                          SRS_FLV_PREVIOUS_TAG_SIZE);
-    tmp_msgs[tmp_msgs_idx].Append(&tmp_msgs[tmp_msgs_idx+1]);
-    tmp_msgs[tmp_msgs_idx+1].Append(&tmp_msgs[tmp_msgs_idx+2]);
-    
-    if (tmp_msgs_idx != 0) {
-      tmp_msgs[tmp_msgs_idx - 1].Append(&tmp_msgs[tmp_msgs_idx]);
-    }
-    // move next.
-    cache += SRS_FLV_TAG_HEADER_SIZE;
-    pts += SRS_FLV_PREVIOUS_TAG_SIZE;
-    tmp_msgs_idx += 3;
+  if (msg->payload_) {
+    fill(msg->payload_);
   }
-  
-  if ((err = writer->write(&tmp_msgs[0], nullptr)) != srs_success) {
+  cache_pts(SRS_FLV_TAG_HEADER_SIZE + msg->size_, scratch);
+  iovs_.push_back(iovec{scratch, SRS_FLV_PREVIOUS_TAG_SIZE});
+  return scratch + SRS_FLV_PREVIOUS_TAG_SIZE;
+}
+
+void SrsFlvTransmuxer::fill(const MessageChain* chain) {
+  while (chain) {
+    iovec iovs[16];
+    uint32_t len = 0;
+    const MessageChain* remainder = nullptr;
+    uint32_t n = chain->FillIov(iovs, 16, len, remainder);
+    iovs_.insert(iovs_.end(), iovs, iovs + n);
+    chain = remainder;
+  }
+}
+
+srs_error_t SrsFlvTransmuxer::write_tags(std::vector<MediaPacket>& msgs) {
+  srs_error_t err = srs_success;
+
+  if (msgs.empty()) {
+    return err;
+  }
+
+  // room for the tag header and previous tag size of each tag, sized 
+  // first, the iovecs point to it.
+  scratch_.resize(msgs.size() * 
+      (SRS_FLV_TAG_HEADER_SIZE + SRS_FLV_PREVIOUS_TAG_SIZE));
+  iovs_.clear();
+  char* scratch = scratch_.data();
+  for (auto& pkt : msgs) {
+    scratch = fill_tag(pkt, scratch);
+  }
+
+  // all the tags are sent in one writev, the shared buffers are borrowed
+  // for the call, the writer copies what it keeps.
+  err = writer->writev(iovs_.data(), (int)iovs_.size(), nullptr);
+  if (err != srs_success) {
     return srs_error_wrap(err, "write flv tags failed");
   }
-#endif
   return err;
 }
 
@@ -474,6 +449,12 @@ srs_error_t SrsFlvStreamEncoder::write_metadata(
   return enc->write_metadata(SrsFrameTypeScript, data, size);
 }
 
+void SrsFlvStreamEncoder::encode_tag(MediaMessage* msg) {
+  if (!msg->flv_tag_) {
+    msg->flv_tag_ = SrsFlvTransmuxer::encode_tag(msg, msg->timestamp_);
+  }
+}
+
 bool SrsFlvStreamEncoder::has_cache() {
   // for flv stream, use gop cache of SrsLiveSource is ok.
   return false;
@@ -484,7 +465,7 @@ srs_error_t SrsFlvStreamEncoder::dump_cache(MediaConsumer*, JitterAlgorithm) {
   return srs_success;
 }
 
-srs_error_t SrsFlvStreamEncoder::write_tags(std::vector<std::shared_ptr<MediaMessage>>& msgs) {
+srs_error_t SrsFlvStreamEncoder::write_tags(std::vector<MediaPacket>& msgs) {
   int count = (int)msgs.size();
   srs_error_t err = srs_success;
 
@@ -494,7 +475,7 @@ srs_error_t SrsFlvStreamEncoder::write_tags(std::vector<std::shared_ptr<MediaMes
     bool has_audio = false;
 
     for (int i = 0; i < count && (!has_video || !has_audio); i++) {
-      auto& msg = msgs[i];
+      auto& msg = msgs[i].msg_;
       if (msg->is_video()) {
         has_video = true;
       } else if (msg->is_audio()) {
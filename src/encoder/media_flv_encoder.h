@@ -64,7 +64,11 @@ class SrsFlvStreamEncoder : public ISrsBufferEncoder {
 
   bool has_cache() override;
   srs_error_t dump_cache(MediaConsumer* consumer, JitterAlgorithm jitter) override;
-  srs_error_t write_tags(std::vector<std::shared_ptr<MediaMessage>>& msgs);
+  srs_error_t write_tags(std::vector<MediaPacket>& msgs);
+
+  // Serialize the flv tag of msg once, before it's dispatched to consumers,
+  // then write_tags sends the shared tag instead of muxing it per viewer.
+  static void encode_tag(MediaMessage* msg);
 
  private:
   srs_error_t write_header(bool has_video = true, bool has_audio = true);
@@ -26,22 +26,58 @@ class MediaServerApi {
  public:
   struct Config {
     uint32_t workers_{1};               // live workers
-    uint32_t ioworkers_{1};             // TODO multi-theads not implement
+    uint32_t ioworkers_{1};             // io workers for http(s)
+    // the lock-free mpsc task queue of all the workers instead of the
+    // one of libevent.
+    bool mpsc_task_queue_{false};
     bool enable_gop_{true};
+    // the duration of gops cached for instant start and time-shift play,
+    // 0 to cache the last gop only, the time-shift disabled.
+    int gop_duration_{0};               // ms
     bool flv_record_{false};
     int consumer_queue_size_{30000};    // ms
     JitterAlgorithm jitter_algo_{JitterAlgorithmZERO};
     bool mix_correct_{false};           // fix live timestamp by map
+    // merged-write of live consumers, flush when the first queued message
+    // is mw_sleep_ms_ old or mw_msgs_ messages are queued, 
+    // mw_sleep_ms_ 0 to flush immediately for the lowest latency.
+    int mw_sleep_ms_{0};                // ms
+    int mw_msgs_{10};
+    // backpressure of slow players, by the delivery delay of the queued 
+    // messages and bytes, drop the non-reference frames then the gops of 
+    // video above the high watermark, until below the low one, and 
+    // disconnect the player behind longer than the timeout, 0 to never.
+    int bp_high_ms_{3000};              // ms
+    int bp_low_ms_{1000};               // ms
+    int bp_timeout_ms_{30000};          // ms
+    // fan out a hot stream by the relay replicas on the other workers, 
+    // when every replica serves relay_threshold players, 0 to disable.
+    int relay_threshold_{0};
+    // move a source off the busiest worker by its measured cost, when the
+    // workers are unbalanced for two rebalance_sec_ in a row, 0 to disable.
+    int rebalance_sec_{0};
  
     //for rtc
     uint32_t rtc_workers_{1};
     std::vector<std::string> candidates_;  // candidates [ip]
-    uint16_t stun_port{9000}; //not use
+    // the udp port of all the peers if rtc_single_port, by ice-lite.
+    uint16_t stun_port{9000};
+    // one port demuxed by ufrag and address instead of one for each peer.
+    bool rtc_single_port{false};
+    // forward the rtp of the webrtc publishers to the webrtc players, 
+    // not framed and packetized again for each of them, and packetize
+    // the other publishers once for all of them.
+    bool rtc_forward_rtp{false};
 
     //for https
     std::string https_key{"./conf/mia.key"};  // pem fromat private key file path
     std::string https_crt{"./conf/mia.crt"};  // pem fromat certificate file path
     std::string https_hostname;
+    // encrypt the https sending by the kernel (kTLS) if supported.
+    bool https_ktls{false};
+    // send the http-flv drained by an io thread at once by one io_uring 
+    // submission, if supported by the kernel.
+    bool http_io_uring{false};
 
     //for rtmp2rtc
     bool enable_rtmp2rtc_{true};
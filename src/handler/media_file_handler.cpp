@@ -6,10 +6,17 @@
 
 #include "media_file_handler.h"
 
-#include "myrtc/api/default_task_queue_factory.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
 #include "common/media_log.h"
+#include "common/media_performance.h"
+#include "http/http_consts.h"
 #include "http/h/http_message.h"
 #include "http/h/http_protocal.h"
+#include "utils/media_msg_chain.h"
 #include "utils/media_protocol_utility.h"
 #include "media_error_handler.h"
 #include "media_server.h"
@@ -49,19 +56,72 @@ std::string srs_http_fs_fullpath(
 
 static log4cxx::LoggerPtr logger = log4cxx::Logger::getLogger("ma.fileserver");
 
+//MediaFileCache
+std::shared_ptr<DataBlock> MediaFileCache::Get(
+    const std::string& path, int64_t mtime, int64_t size) {
+  std::lock_guard<std::mutex> guard(lock_);
+  auto found = entries_.find(path);
+  if (found == entries_.end()) {
+    return nullptr;
+  }
+
+  Entry& entry = found->second;
+  // modified, reload it.
+  if (entry.mtime != mtime || entry.data->GetLength() != size) {
+    bytes_ -= entry.data->GetLength();
+    lru_.erase(entry.pos);
+    entries_.erase(found);
+    return nullptr;
+  }
+
+  lru_.splice(lru_.begin(), lru_, entry.pos);
+  return entry.data;
+}
+
+void MediaFileCache::Put(const std::string& path, 
+                         int64_t mtime, 
+                         std::shared_ptr<DataBlock> data) {
+  std::lock_guard<std::mutex> guard(lock_);
+  auto found = entries_.find(path);
+  if (found != entries_.end()) {
+    bytes_ -= found->second.data->GetLength();
+    lru_.erase(found->second.pos);
+    entries_.erase(found);
+  }
+
+  bytes_ += data->GetLength();
+  lru_.push_front(path);
+  entries_[path] = Entry{std::move(data), mtime, lru_.begin()};
+
+  while (bytes_ > capacity_ && !lru_.empty()) {
+    auto last = entries_.find(lru_.back());
+    bytes_ -= last->second.data->GetLength();
+    entries_.erase(last);
+    lru_.pop_back();
+  }
+}
+
+//MediaFileHandler
+MediaFileHandler::MediaFileHandler() 
+    : cache_{SRS_PERF_FILE_CACHE_BYTES} {
+}
+
 srs_error_t MediaFileHandler::serve_http(
     std::shared_ptr<IHttpResponseWriter> w, 
     std::shared_ptr<ISrsHttpMessage> r) {
 
   static HttpNotFoundHandler s_not_found;
-  std::string pattern{""};
-  // use short-term HTTP connection.
-  SrsHttpHeader* h = w->header();
-  h->set("Connection", "Close");
-
   std::string upath = r->path();
+  std::string pattern = upath == HTTP_TEST ? "/test" : "/";
+
+  // never serve the files out of the www path.
+  if (upath.find("..") != std::string::npos) {
+    MLOG_CWARN("http forbidden upath=%s", upath.c_str());
+    return srs_go_http_error(w.get(), SRS_CONSTS_HTTP_Forbidden);
+  }
+
   std::string fullpath = 
-      srs_http_fs_fullpath(g_server_.config_.path, "/test", upath);
+      srs_http_fs_fullpath(g_server_.config_.path, pattern, upath);
 
   // stat current dir, if exists, return error.
   if (!srs_path_exists(fullpath)) {
@@ -72,18 +132,8 @@ srs_error_t MediaFileHandler::serve_http(
   MLOG_CTRACE("http match file=%s, pattern=%s, upath=%s",
             fullpath.c_str(), pattern.c_str(), upath.c_str());
 
-  if (!worker_) {
-    auto task_queue_factory = webrtc::CreateDefaultTaskQueueFactory();
-    worker_ = std::make_shared<wa::Worker>(task_queue_factory.get());
-    worker_->start("file server");
-  }
-
-  // serve common static file.
-  worker_->task([this, w, r, fullpath] {
-      serve_file(std::move(w), std::move(r), fullpath);
-    }, RTC_FROM_HERE);
-  
-  return srs_success;
+  // served in the io thread, nothing is copied by the worker.
+  return serve_file(std::move(w), std::move(r), fullpath);
 }
 
 static std::map<std::string, std::string> g_mime {
@@ -119,94 +169,157 @@ static std::map<std::string, std::string> g_mime {
   {".mp4v", "video/mp4"}
 };
 
+// Parse the single byte range of https://tools.ietf.org/html/rfc7233,
+// returns 1 for the range, 0 to ignore it and serve the whole file, 
+// -1 if not satisfiable.
+static int http_parse_range(const std::string& value, 
+                            int64_t size, 
+                            int64_t& offset, 
+                            int64_t& length) {
+  static const std::string kUnit = "bytes=";
+  // the multiple ranges are not supported.
+  if (!srs_string_starts_with(value, kUnit) || 
+      value.find(',') != std::string::npos) {
+    return 0;
+  }
+
+  std::string spec = value.substr(kUnit.length());
+  size_t dash = spec.find('-');
+  if (dash == std::string::npos) {
+    return 0;
+  }
+
+  const char* p = spec.c_str();
+  char* end = nullptr;
+  int64_t first = -1;
+  int64_t last = -1;
+  if (dash > 0) {
+    first = strtoll(p, &end, 10);
+    if (end != p + dash || first < 0) {
+      return 0;
+    }
+  }
+  if (dash + 1 < spec.length()) {
+    last = strtoll(p + dash + 1, &end, 10);
+    if (*end || last < 0) {
+      return 0;
+    }
+  }
+
+  // the suffix, bytes=-500 is the last 500 bytes.
+  if (first == -1) {
+    if (last == -1) {
+      return 0;
+    }
+    length = std::min(last, size);
+    offset = size - length;
+    return length > 0 ? 1 : -1;
+  }
+
+  if (last != -1 && last < first) {
+    return 0;
+  }
+  if (first >= size) {
+    return -1;
+  }
+
+  if (last == -1 || last >= size) {
+    last = size - 1;
+  }
+  offset = first;
+  length = last - first + 1;
+  return 1;
+}
+
 srs_error_t MediaFileHandler::serve_file(
     std::shared_ptr<IHttpResponseWriter> w, 
     std::shared_ptr<ISrsHttpMessage> r, 
     const std::string&  fullpath) {
-  srs_error_t err = srs_success;
-
-  std::unique_ptr<SrsFileReader> fs( 
-      ISrsFileReaderFactory().create_file_reader());
+  int fd = ::open(fullpath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return srs_error_new(ERROR_SYSTEM_FILE_OPENE, 
+        "open file %s, errno=%d", fullpath.c_str(), errno);
+  }
 
-  if ((err = fs->open(fullpath)) != srs_success) {
-    return srs_error_wrap(err, "open file %s", fullpath.c_str());
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return srs_go_http_error(w.get(), SRS_CONSTS_HTTP_NotFound);
   }
+  int64_t size = st.st_size;
+  int64_t mtime = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
 
-  // The length of bytes we could response to.
-  int64_t length = fs->filesize() - fs->tellg();
-  
-  // unset the content length to encode in chunked encoding.
-  w->header()->set_content_length(length);
-  
   std::string ext = srs_path_filext(fullpath);
-  
-  if (g_mime.find(ext) == g_mime.end()) {
-      w->header()->set_content_type("application/octet-stream");
+  auto found = g_mime.find(ext);
+  if (found == g_mime.end()) {
+    w->header()->set_content_type("application/octet-stream");
   } else {
-      w->header()->set_content_type(ext);
+    w->header()->set_content_type(found->second);
+  }
+  w->header()->set("Accept-Ranges", "bytes");
+
+  // The range of bytes we could response to.
+  int64_t offset = 0;
+  int64_t length = size;
+  int status = SRS_CONSTS_HTTP_OK;
+  std::string range = r->header().get("Range");
+  if (!range.empty()) {
+    int ret = http_parse_range(range, size, offset, length);
+    if (ret < 0) {
+      ::close(fd);
+      w->header()->set("Content-Range", "bytes */" + srs_int2str(size));
+      return srs_go_http_error(w.get(), 
+          SRS_CONSTS_HTTP_RequestedRangeNotSatisfiable);
+    }
+    if (ret > 0) {
+      w->header()->set("Content-Range", "bytes " + srs_int2str(offset) + 
+          "-" + srs_int2str(offset + length - 1) + "/" + srs_int2str(size));
+      status = SRS_CONSTS_HTTP_PartialContent;
+    }
   }
 
-  // Enter chunked mode, because we didn't set the content-length.
-  w->write_header(SRS_CONSTS_HTTP_OK);
-  
-  // write body.
-  int64_t left = length;
-  if ((err = copy(std::move(w), std::move(fs), std::move(r), (int)left)) != srs_success) {
-    return srs_error_wrap(err, "copy file=%s size=%d", fullpath.c_str(), (int)left);
+  w->header()->set_content_length(length);
+  w->write_header(status);
+
+  if (length == 0) {
+    ::close(fd);
+    return w->final_request();
   }
-    
-  return err;
-}
-    
-void MediaFileHandler::conn_destroy(std::shared_ptr<IMediaConnection> c) {
-  std::lock_guard<std::mutex> guard(lock_);
-  s_list_.erase(c.get());
-}
 
-static constexpr int MEDIA_HTTP_SEND_BUFFER_SIZE = MA_MAX_PACKET_SIZE;
+  if (size > SRS_PERF_FILE_CACHE_MAX_FILE) {
+    return serve_sendfile(std::move(w), std::move(r), fd, offset, length);
+  }
+
+  // the small hot file, read it once.
+  std::shared_ptr<DataBlock> data = cache_.Get(fullpath, mtime, size);
+  if (!data) {
+    data = DataBlock::Create((int32_t)size, nullptr);
+    ssize_t nread = ::pread(fd, data->GetBasePtr(), size, 0);
+    if (nread != size) {
+      ::close(fd);
+      return srs_error_new(ERROR_SYSTEM_FILE_READ, 
+          "read file %s, size=%d, nread=%d", 
+          fullpath.c_str(), (int)size, (int)nread);
+    }
+    cache_.Put(fullpath, mtime, data);
+  }
+  ::close(fd);
+
+  return serve_cached(std::move(w), std::move(data), offset, length);
+}
 
-srs_error_t MediaFileHandler::copy(
+srs_error_t MediaFileHandler::serve_cached(
     std::shared_ptr<IHttpResponseWriter> w, 
-    std::unique_ptr<SrsFileReader> fs, 
-    std::shared_ptr<ISrsHttpMessage> msg, 
-    int size) {
+    std::shared_ptr<DataBlock> data, 
+    int64_t offset, 
+    int64_t length) {
   srs_error_t err = srs_success;
-  
-  int file_left = size;
-
-  std::unique_ptr<char[]> buf(new char[MEDIA_HTTP_SEND_BUFFER_SIZE]);
-  while (file_left > 0) {
-    ssize_t nread = -1;
-    int max_read = std::min(file_left, MEDIA_HTTP_SEND_BUFFER_SIZE);
-    if ((err = fs->read(buf.get(), max_read, &nread)) != srs_success) {
-      return srs_error_wrap(err, "read limit=%d, left=%d", max_read, file_left);
-    }
 
-    file_left -= nread;
-
-    if ((err = w->write(buf.get(), (int)nread)) != srs_success) {
-      if (srs_error_code(err) != ERROR_SOCKET_WOULD_BLOCK) {
-        return srs_error_wrap(err, 
-            "error on underlying socket, write limit=%d, bytes=%d, left=%d", 
-            max_read, (int)nread, file_left);
-      }
-
-      // would block, save job
-      auto job = std::make_shared<doing_job>();
-      w->SignalOnWrite_.connect(job.get(), &doing_job::on_write_event);
-      job->fs_ = std::move(fs);
-      job->buf_ = std::move(buf);
-      job->w_ = std::move(w);
-      job->buf_left_ = nread;
-      job->file_left_ = file_left;
-      job->worker_ = worker_;
-      {
-        std::lock_guard<std::mutex> guard(lock_);
-        s_list_.emplace(msg->connection().get(), std::move(job));
-      }
-      delete err;
-      return srs_success;
-    }
+  // the header and the body by one writev, only the bytes not sent are 
+  // copied by the writer.
+  iovec iov{data->GetBasePtr() + offset, (size_t)length};
+  if ((err = w->writev(&iov, 1, nullptr)) != srs_success) {
+    return srs_error_wrap(err, "write cached size=%d", (int)length);
   }
 
   if ((err = w->final_request()) != srs_success) {
@@ -215,69 +328,89 @@ srs_error_t MediaFileHandler::copy(
   return err;
 }
 
-void MediaFileHandler::doing_job::on_write_event(IHttpResponseWriter* w) {
-  auto func = [this, w]() {
-    MA_ASSERT(w == w_.get());
-    srs_error_t err = srs_success;
-    if (buf_left_ <= 0) {
-      return;
-    }
-
-    // send buffer first
-    if ((err = w->write(buf_.get(), buf_left_)) != srs_success) {
-      if (srs_error_code(err) != ERROR_SOCKET_WOULD_BLOCK) {
-        MLOG_CERROR("error on underlying socket, left=%d, desc:%s", 
-            buf_left_ + file_left_, srs_error_desc(err).c_str());
-        delete err;
-        return ;
-      }
-
-      // unreachable code
-      MA_ASSERT(false);
-    }
+srs_error_t MediaFileHandler::serve_sendfile(
+    std::shared_ptr<IHttpResponseWriter> w, 
+    std::shared_ptr<ISrsHttpMessage> r, 
+    int fd, 
+    int64_t offset, 
+    int64_t length) {
+  auto job = std::make_shared<doing_job>();
+  job->fd_ = fd;
+  job->offset_ = offset;
+  job->left_ = length;
+  job->w_ = std::move(w);
+  if (job->send()) {
+    return srs_success;
+  }
 
-    buf_left_ = 0;
+  // would block, save job
+  job->w_->SignalOnWrite_.connect(job.get(), &doing_job::on_write_event);
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    // the pipelined files of the connection, drop the ones done.
+    auto& jobs = s_list_[r->connection().get()];
+    jobs.remove_if([](auto& i) { return i->fd_ == -1; });
+    jobs.push_back(std::move(job));
+  }
+  return srs_success;
+}
     
-    while (file_left_ > 0) {
-      ssize_t nread = -1;
-      int max_read = std::min(file_left_, MEDIA_HTTP_SEND_BUFFER_SIZE);
-      if ((err = fs_->read(buf_.get(), max_read, &nread)) != srs_success) {
-        MLOG_CERROR("read limit=%d, left=%d, desc:%s", 
-            max_read, file_left_, srs_error_desc(err).c_str());
-        delete err;
-        return ;
-      }
-
-      MA_ASSERT(max_read == nread && nread > 0);
-      file_left_ -= nread;
-
-      if ((err = w->write(buf_.get(), (int)nread)) != srs_success) {
-        if (srs_error_code(err) != ERROR_SOCKET_WOULD_BLOCK) {
-          MLOG_CERROR("error on underlying socket, left=%d, desc:%s", 
-            nread + file_left_, srs_error_desc(err).c_str());
-          delete err;
-          return ;
-        }
-
-        buf_left_ = nread;
-        delete err;
-        return ;
-      }
+void MediaFileHandler::conn_destroy(std::shared_ptr<IMediaConnection> c) {
+  std::lock_guard<std::mutex> guard(lock_);
+  s_list_.erase(c.get());
+}
+
+MediaFileHandler::doing_job::~doing_job() {
+  close();
+}
+
+void MediaFileHandler::doing_job::close() {
+  if (fd_ != -1) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+bool MediaFileHandler::doing_job::send() {
+  srs_error_t err = srs_success;
+  while (left_ > 0) {
+    int64_t sent = 0;
+    err = w_->sendfile(fd_, offset_, left_, &sent);
+    offset_ += sent;
+    left_ -= sent;
+    if (err == srs_success) {
+      continue;
     }
 
-    if ((err = w->final_request()) != srs_success) {
-      MLOG_CERROR("final request, desc:%s", srs_error_desc(err).c_str());
+    if (srs_error_code(err) == ERROR_SOCKET_WOULD_BLOCK) {
       delete err;
+      return false;
     }
-  };
-
-  auto weak_this = weak_from_this();
-  worker_->task([weak_this, func] {
-      if (auto this_ptr = weak_this.lock()) {
-        func();
-      }
-    }, RTC_FROM_HERE);
+
+    MLOG_CERROR("error on sendfile, left=%d, desc:%s", 
+        (int)left_, srs_error_desc(err).c_str());
+    delete err;
+    close();
+    // the response is broken, so are the ones after it.
+    w_->disconnect();
+    return true;
+  }
+
+  close();
+  if ((err = w_->final_request()) != srs_success) {
+    MLOG_CERROR("final request, desc:%s", srs_error_desc(err).c_str());
+    delete err;
+  }
+  return true;
 }
 
+void MediaFileHandler::doing_job::on_write_event(IHttpResponseWriter* w) {
+  MA_ASSERT(w == w_.get());
+  // done, kept until the next file of the connection, or it destroyed.
+  if (fd_ == -1) {
+    return;
+  }
+  send();
 }
 
+}
@@ -7,64 +7,97 @@
 #ifndef __MEDIA_FILE_HANDLER_H__
 #define __MEDIA_FILE_HANDLER_H__
 
+#include <list>
 #include <memory>
 #include <unordered_map>
 #include <mutex>
 
-#include "utils/Worker.h"
 #include "handler/h/media_handler.h"
 #include "utils/sigslot.h"
-#include "common/media_io.h"
 
 namespace ma {
 
 class IHttpResponseWriter;
-class SrsFileReader;
 class ISrsHttpMessage;
+class DataBlock;
+
+// The small hot files in memory, keyed by path and validated by mtime and
+// size, the least recently used ones are evicted.
+class MediaFileCache final {
+ public:
+  explicit MediaFileCache(int64_t capacity) : capacity_{capacity} { }
+
+  std::shared_ptr<DataBlock> Get(
+      const std::string& path, int64_t mtime, int64_t size);
+  void Put(const std::string& path, int64_t mtime, std::shared_ptr<DataBlock>);
+
+ private:
+  struct Entry {
+    std::shared_ptr<DataBlock> data;
+    int64_t mtime{0};
+    std::list<std::string>::iterator pos;
+  };
+
+  std::mutex lock_;
+  // the front is the most recently used.
+  std::list<std::string> lru_;
+  std::unordered_map<std::string, Entry> entries_;
+  int64_t bytes_{0};
+  const int64_t capacity_;
+};
 
 class MediaFileHandler : public IMediaHttpHandler {
  public:
-  srs_error_t serve_http(std::shared_ptr<IHttpResponseWriter>, 
+  MediaFileHandler();
+
+  srs_error_t serve_http(std::shared_ptr<IHttpResponseWriter>,
                                  std::shared_ptr<ISrsHttpMessage>) override;
 
-  srs_error_t mount_service(std::shared_ptr<MediaSource> s, 
+  srs_error_t mount_service(std::shared_ptr<MediaSource> s,
                                     std::shared_ptr<MediaRequest> r) override {
     return nullptr;
   }
-  
-  void unmount_service(std::shared_ptr<MediaSource> s, 
+
+  void unmount_service(std::shared_ptr<MediaSource> s,
                                std::shared_ptr<MediaRequest> r) override {}
 
   void conn_destroy(std::shared_ptr<IMediaConnection>) override;
 
-  void on_write_event(IHttpResponseWriter*);
  private:
-  srs_error_t serve_file(std::shared_ptr<IHttpResponseWriter> w, 
-                         std::shared_ptr<ISrsHttpMessage> r, 
+  srs_error_t serve_file(std::shared_ptr<IHttpResponseWriter> w,
+                         std::shared_ptr<ISrsHttpMessage> r,
                          const std::string&  fullpath);
-  
-  srs_error_t copy(std::shared_ptr<IHttpResponseWriter> w, 
-    std::unique_ptr<SrsFileReader> fs, 
-    std::shared_ptr<ISrsHttpMessage> r, int size);
+
+  // from memory to socket by one writev.
+  srs_error_t serve_cached(std::shared_ptr<IHttpResponseWriter> w,
+                           std::shared_ptr<DataBlock> data,
+                           int64_t offset, int64_t length);
+
+  // by sendfile, continue on write event if blocked, takes the fd.
+  srs_error_t serve_sendfile(std::shared_ptr<IHttpResponseWriter> w,
+                             std::shared_ptr<ISrsHttpMessage> r,
+                             int fd, int64_t offset, int64_t length);
 
  private:
   struct doing_job : public sigslot::has_slots<>,
                      public std::enable_shared_from_this<doing_job> {
     doing_job() = default;
-    std::unique_ptr<SrsFileReader> fs_;
-    std::unique_ptr<char[]> buf_;
+    ~doing_job();
+    int fd_{-1};
+    int64_t offset_{0};
+    int64_t left_{0};
     std::shared_ptr<IHttpResponseWriter> w_;
-    int buf_left_{0};
-    int file_left_{0};
-    std::shared_ptr<wa::Worker> worker_;
+    // returns false if blocked.
+    bool send();
+    void close();
     void on_write_event(IHttpResponseWriter*);
   };
 
   std::mutex lock_;
-  std::unordered_map<IMediaConnection*, std::shared_ptr<doing_job>> s_list_;
+  std::unordered_map<IMediaConnection*, 
+                     std::list<std::shared_ptr<doing_job>>> s_list_;
 
-  // for test
-  std::shared_ptr<wa::Worker> worker_;
+  MediaFileCache cache_;
 };
 
 } //namespace ma
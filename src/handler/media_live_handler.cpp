@@ -6,11 +6,15 @@
 
 #include "media_live_handler.h"
 
+#include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <map>
+#include <mutex>
 
 #include "common/media_log.h"
 #include "rtc_base/sequence_checker.h"
+#include "rtc_base/time_utils.h"
 #include "http/http_consts.h"
 #include "utils/media_protocol_utility.h"
 #include "connection/h/conn_interface.h"
@@ -33,21 +37,55 @@ namespace ma {
 static log4cxx::LoggerPtr logger = 
     log4cxx::Logger::getLogger("ma.liveserver");
 
+// parse the time-shift of ?start=-10s, in seconds or with the unit s/ms.
+// @return the offset in ms to the live, 0 if not specified or invalid.
+static int64_t parse_start_offset(const std::string& start) {
+  if (start.empty()) {
+    return 0;
+  }
+
+  char* end = nullptr;
+  int64_t offset = ::strtoll(start.c_str(), &end, 10);
+  if (end == start.c_str()) {
+    return 0;
+  }
+
+  std::string unit(end);
+  if (unit.empty() || unit == "s") {
+    offset *= 1000;
+  } else if (unit != "ms") {
+    return 0;
+  }
+
+  // never play ahead of the live.
+  return std::min<int64_t>(offset, 0);
+}
+
 class StreamEntry final
-    : public std::enable_shared_from_this<StreamEntry> {
+    : public std::enable_shared_from_this<StreamEntry>,
+      public MediaConsumerSink,
+      public sigslot::has_slots<> {
   struct customer {
     customer(std::shared_ptr<MediaConsumer> consumer,
              std::unique_ptr<SrsFileWriter> buffer,
-             std::unique_ptr<ISrsBufferEncoder> encoder)
+             std::unique_ptr<ISrsBufferEncoder> encoder,
+             std::shared_ptr<IHttpResponseWriter> writer,
+             std::string id)
              : consumer_{std::move(consumer)},
                buffer_writer_{std::move(buffer)},
-               encoder_{std::move(encoder)} {
+               encoder_{std::move(encoder)},
+               writer_{std::move(writer)},
+               id_{std::move(id)} {
     }
 
     customer(customer&& r)
       : consumer_{std::move(r.consumer_)},
         buffer_writer_{std::move(r.buffer_writer_)},
-        encoder_{std::move(r.encoder_)} {
+        encoder_{std::move(r.encoder_)},
+        writer_{std::move(r.writer_)},
+        id_{std::move(r.id_)},
+        rate_time_{r.rate_time_},
+        level_time_{r.level_time_} {
     }
 
     customer(const customer&) = delete;
@@ -60,17 +98,38 @@ class StreamEntry final
     std::unique_ptr<SrsFileWriter>  buffer_writer_;
     std::unique_ptr<ISrsBufferEncoder> encoder_;
 
-    std::vector<std::shared_ptr<MediaMessage>> cache_;
+    std::vector<MediaPacket> cache_;
 
     int sent_{0};
+
+    // The http response, nullptr for the flv record.
+    std::shared_ptr<IHttpResponseWriter> writer_;
+    // The client id of statistics.
+    std::string id_;
+
+    // backpressure, the socket drain rate in bytes per second, and the 
+    // time in ms when it's updated, the delay exceeds the high watermark,
+    // and the drop level changed.
+    int64_t last_sent_bytes_{0};
+    int64_t drain_rate_{0};
+    // the send system calls per second of the socket.
+    int64_t last_send_calls_{0};
+    int64_t send_call_rate_{0};
+    int64_t rate_time_{0};
+    int64_t behind_since_{-1};
+    int64_t level_time_{0};
   };
  public:
   StreamEntry(std::shared_ptr<MediaSource> s,
-              std::shared_ptr<MediaRequest> r);
+              std::shared_ptr<MediaRequest> r,
+              int replica = 0);
   ~StreamEntry();
 
   void initialize();
 
+  // the entry of the replica to serve a new player, called on the origin.
+  std::shared_ptr<StreamEntry> place();
+
   void update() { }
   
   srs_error_t serve_http(std::shared_ptr<IHttpResponseWriter> writer, 
@@ -80,10 +139,27 @@ class StreamEntry final
   void add_customer(IMediaConnection* conn, 
                     std::shared_ptr<MediaConsumer> consumer,
                     std::unique_ptr<SrsFileWriter> buffer,
-                    std::unique_ptr<ISrsBufferEncoder> encoder);
+                    std::unique_ptr<ISrsBufferEncoder> encoder,
+                    std::shared_ptr<IHttpResponseWriter> writer = nullptr,
+                    std::string id = "");
   void delete_customer(IMediaConnection* conn);
-  bool on_timer();
-  void consumer_push(customer&, std::vector<std::shared_ptr<MediaMessage>>&);
+  void OnConsumerReady(MediaConsumer*, bool full) override;
+  // called in io thread when the blocked socket is writable again.
+  void on_write_event(IHttpResponseWriter*);
+  // called in the old worker when the source moves to another one.
+  void on_migrate(std::shared_ptr<wa::Worker> to);
+  void start_backpressure_timer();
+  // whether running in the worker of the stream now.
+  bool is_current();
+  // flush after mw_sleep, or immediately if now.
+  void schedule_flush(bool now);
+  void flush();
+  void consumer_push(customer&, std::vector<MediaPacket>&);
+  // check the slow players per second, 
+  // @return false to stop checking for no customers.
+  bool on_backpressure_timer();
+  // @return false if the player is behind for too long.
+  bool check_backpressure(customer&, int64_t now);
   void async_task(std::function<void()> f, const rtc::Location& l);
  private:
   std::map<IMediaConnection*, customer> conns_customers_; // in worker thread
@@ -92,18 +168,47 @@ class StreamEntry final
   std::shared_ptr<MediaRequest> req_;
   std::unique_ptr<SrsBufferCache> cache_;
 
+  // the replica of live source, 0 for the origin.
+  int replica_;
   std::shared_ptr<wa::Worker> worker_;
 
+  // the entries of the relay replicas, in the origin entry.
+  std::mutex replicas_lock_;
+  std::vector<std::shared_ptr<StreamEntry>> replicas_;
+
+  // merged-write
+  std::chrono::milliseconds mw_sleep_;
+  int mw_msgs_;
+  bool flush_pending_{false};
+  std::shared_ptr<wa::ScheduledTaskReference> flush_timer_;
+
+  // backpressure watermarks and timeout, in ms.
+  int64_t bp_high_;
+  int64_t bp_low_;
+  int64_t bp_timeout_;
+  bool bp_timer_{false};
+
   webrtc::SequenceChecker thread_check_;
 };
 
 StreamEntry::StreamEntry(std::shared_ptr<MediaSource> s, 
-                         std::shared_ptr<MediaRequest> r) 
+                         std::shared_ptr<MediaRequest> r,
+                         int replica) 
   : source_{s},  
     req_{std::move(r)}, 
-    worker_{source_->get_worker()} {
+    replica_{replica},
+    worker_{source_->get_worker(replica_)},
+    mw_sleep_{g_server_.config_.mw_sleep_ms_},
+    mw_msgs_{g_server_.config_.mw_msgs_},
+    bp_high_{g_server_.config_.bp_high_ms_},
+    bp_low_{g_server_.config_.bp_low_ms_},
+    bp_timeout_{g_server_.config_.bp_timeout_ms_} {
   thread_check_.Detach();
-  MLOG_TRACE("service created:" << req_->get_stream_url());
+  if (replica_ == 0) {
+    source_->signal_migrate_.connect(this, &StreamEntry::on_migrate);
+  }
+  MLOG_TRACE("service created:" << req_->get_stream_url() << 
+             ", replica:" << replica_);
 }
 
 StreamEntry::~StreamEntry() {
@@ -156,34 +261,44 @@ void StreamEntry::initialize() {
   }, RTC_FROM_HERE);
 }
 
+std::shared_ptr<StreamEntry> StreamEntry::place() {
+  int replica = source_->PlaceConsumer();
+  if (replica == 0) {
+    return shared_from_this();
+  }
+
+  std::lock_guard<std::mutex> guard(replicas_lock_);
+  if ((int)replicas_.size() < replica) {
+    replicas_.resize(replica);
+  }
+
+  auto& entry = replicas_[replica - 1];
+  if (!entry) {
+    entry = std::make_shared<StreamEntry>(source_, req_, replica);
+  }
+  return entry;
+}
+
 void StreamEntry::add_customer(IMediaConnection* conn, 
                                std::shared_ptr<MediaConsumer> consumer,
                                std::unique_ptr<SrsFileWriter> buffer,
-                               std::unique_ptr<ISrsBufferEncoder> encoder) {
+                               std::unique_ptr<ISrsBufferEncoder> encoder,
+                               std::shared_ptr<IHttpResponseWriter> writer,
+                               std::string id) {
   RTC_DCHECK_RUN_ON(&thread_check_);
-  bool need_timer = false;
-  if (conns_customers_.empty()) {
-    need_timer = true;
-  }
+  consumer->set_sink(this, mw_msgs_);
   
-  customer c{consumer, std::move(buffer), std::move(encoder)};
+  customer c{consumer, std::move(buffer), std::move(encoder), 
+             std::move(writer), std::move(id)};
+  c.rate_time_ = c.level_time_ = rtc::TimeMillis();
   conns_customers_.emplace(conn, std::move(c));
 
-  if (!need_timer) {
-    return;
+  if (!bp_timer_) {
+    start_backpressure_timer();
   }
 
-  static constexpr auto TIME_OUT = std::chrono::milliseconds(SRS_PERF_MW_SLEEP);
-
-  //TODO timer push need optimizing
-  auto weak_this = weak_from_this();
-  worker_->scheduleEvery([weak_this]() {
-    if (auto stream = weak_this.lock()) {
-      return stream->on_timer();
-    }
-    
-    return false;
-  }, TIME_OUT, RTC_FROM_HERE);
+  // send the dumped sequence header and gop cache.
+  schedule_flush(true);
 }
 
 void StreamEntry::delete_customer(IMediaConnection* conn) {
@@ -196,7 +311,7 @@ void StreamEntry::delete_customer(IMediaConnection* conn) {
 }
 
 void StreamEntry::consumer_push(
-    customer& c, std::vector<std::shared_ptr<MediaMessage>>& cache) {
+    customer& c, std::vector<MediaPacket>& cache) {
   srs_error_t err = srs_success;
   SrsFlvStreamEncoder* fast = 
       dynamic_cast<SrsFlvStreamEncoder*>(c.encoder_.get());
@@ -231,21 +346,192 @@ void StreamEntry::consumer_push(
   } while(true);
 }
 
-bool StreamEntry::on_timer() {
-  RTC_DCHECK_RUN_ON(&thread_check_);
+void StreamEntry::start_backpressure_timer() {
+  bp_timer_ = true;
+  auto weak_this = weak_from_this();
+  worker_->scheduleEvery([weak_this]() {
+    auto stream = weak_this.lock();
+    // the timer of the old worker stops after moved.
+    if (!stream || !stream->is_current()) {
+      return false;
+    }
+    return stream->on_backpressure_timer();
+  }, std::chrono::seconds(1), RTC_FROM_HERE);
+}
 
-  bool result = true;
+bool StreamEntry::on_backpressure_timer() {
+  RTC_DCHECK_RUN_ON(&thread_check_);
   if (conns_customers_.empty()) {
-    return result = false;
+    bp_timer_ = false;
+    return false;
   }
- 
-  std::vector<std::shared_ptr<MediaMessage>> msgs;
-  msgs.reserve(SRS_PERF_MW_MSGS);
-  for (auto& i : conns_customers_) {
-    consumer_push(i.second, msgs);
+
+  int64_t now = rtc::TimeMillis();
+  for (auto i = conns_customers_.begin(); i != conns_customers_.end();) {
+    customer& c = i->second;
+    if (check_backpressure(c, now)) {
+      ++i;
+      continue;
+    }
+
+    MLOG_CWARN("disconnect the slow player %s, behind for %dms", 
+               c.id_.c_str(), (int)(now - c.behind_since_));
+    c.writer_->disconnect();
+    conns_customers_.erase(i++);
+  }
+  return true;
+}
+
+bool StreamEntry::check_backpressure(customer& c, int64_t now) {
+  // never drop for the flv record.
+  if (!c.writer_) {
+    return true;
+  }
+
+  // the drain rate of socket, smoothed.
+  if (now > c.rate_time_) {
+    int64_t sent = c.writer_->sent_bytes();
+    int64_t rate = (sent - c.last_sent_bytes_) * 1000 / (now - c.rate_time_);
+    c.drain_rate_ = c.drain_rate_ ? (c.drain_rate_ * 3 + rate) / 4 : rate;
+    c.last_sent_bytes_ = sent;
+    int64_t calls = c.writer_->send_calls();
+    c.send_call_rate_ = 
+        (calls - c.last_send_calls_) * 1000 / (now - c.rate_time_);
+    c.last_send_calls_ = calls;
+    c.rate_time_ = now;
+  }
+
+  // the delay to deliver the messages in consumer, and the bytes queued 
+  // in writer, nothing is sent means the socket is stalled.
+  int64_t delay = c.consumer_->lag();
+  int64_t queued = c.writer_->queued_bytes();
+  if (queued > 0) {
+    delay += c.drain_rate_ > 0 ? queued * 1000 / c.drain_rate_ : bp_high_;
+  }
+
+  ConsumerDropLevel level = c.consumer_->drop_level();
+  if (delay >= bp_high_) {
+    if (c.behind_since_ == -1) {
+      c.behind_since_ = now;
+    }
+
+    // escalate the drop level one by one, to see it works.
+    if (level != ConsumerDropGop && now - c.level_time_ >= 1000) {
+      level = (ConsumerDropLevel)(level + 1);
+      c.consumer_->set_drop_level(level);
+      c.level_time_ = now;
+      MLOG_CWARN("player %s delay %dms, rate %dB/s, drop level %d", 
+                 c.id_.c_str(), (int)delay, (int)c.drain_rate_, level);
+    }
+  } else if (delay <= bp_low_) {
+    c.behind_since_ = -1;
+    if (level != ConsumerDropNone) {
+      c.consumer_->set_drop_level(ConsumerDropNone);
+      c.level_time_ = now;
+      MLOG_CTRACE("player %s delay %dms, catch up", c.id_.c_str(), (int)delay);
+    }
+  }
+
+  const ConsumerDropStats& stats = c.consumer_->drop_stats();
+  MediaStatistics::ClientDelivery delivery;
+  delivery.delay_ms = delay;
+  delivery.dropped_disposable = stats.disposable;
+  delivery.dropped_gops = stats.gops;
+  delivery.dropped_gop_frames = stats.gop_frames;
+  delivery.send_calls_per_sec = c.send_call_rate_;
+  delivery.queued_bytes = queued;
+  delivery.sent_bytes = c.writer_->sent_bytes();
+  delivery.high_watermark_ms = c.writer_->high_watermark_ms();
+  Stat().OnClientDelivery(c.id_, delivery);
+
+  return bp_timeout_ <= 0 || c.behind_since_ == -1 || 
+         now - c.behind_since_ < bp_timeout_;
+}
+
+void StreamEntry::OnConsumerReady(MediaConsumer*, bool full) {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+  schedule_flush(full);
+}
+
+void StreamEntry::on_write_event(IHttpResponseWriter*) {
+  async_task([this]() {
+    RTC_DCHECK_RUN_ON(&thread_check_);
+    schedule_flush(true);
+  }, RTC_FROM_HERE);
+}
+
+void StreamEntry::on_migrate(std::shared_ptr<wa::Worker> to) {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+  if (flush_timer_) {
+    worker_->unschedule(flush_timer_);
+    flush_timer_.reset();
+  }
+  flush_pending_ = false;
+
+  std::atomic_store(&worker_, std::move(to));
+  thread_check_.Detach();
+
+  // the tasks of the old worker are dropped or follow it.
+  if (bp_timer_) {
+    start_backpressure_timer();
+  }
+  schedule_flush(true);
+}
+
+bool StreamEntry::is_current() {
+  return std::atomic_load(&worker_)->IsCurrent();
+}
+
+void StreamEntry::schedule_flush(bool now) {
+  now = now || mw_sleep_.count() == 0;
+
+  // one flush for all the consumers, unless the pending one is delayed
+  // and an immediate one is required.
+  if (flush_pending_ && (!now || !flush_timer_)) {
+    return;
+  }
+
+  if (flush_timer_) {
+    worker_->unschedule(flush_timer_);
+    flush_timer_.reset();
+  }
+  flush_pending_ = true;
+
+  auto weak_this = weak_from_this();
+  auto f = [weak_this]() {
+    auto stream = weak_this.lock();
+    if (stream && stream->is_current()) {
+      stream->flush();
+    }
+  };
+
+  if (now) {
+    worker_->task(std::move(f), RTC_FROM_HERE);
+  } else {
+    flush_timer_ = worker_->scheduleFromNow(std::move(f), mw_sleep_, 
+                                            RTC_FROM_HERE);
+  }
+}
+
+void StreamEntry::flush() {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+  flush_pending_ = false;
+  flush_timer_.reset();
+
+  int64_t start = rtc::TimeMicros();
+  {
+    // one task to each io thread for the writes of all the consumers.
+    HttpWriteBatch batch;
+    std::vector<MediaPacket> msgs;
+    msgs.reserve(SRS_PERF_MW_MSGS);
+    for (auto& i : conns_customers_) {
+      consumer_push(i.second, msgs);
+    }
+  }
+  // the players of the origin move with the source, not the relays.
+  if (replica_ == 0) {
+    source_->AddCost(rtc::TimeMicros() - start);
   }
- 
-  return result;
 }
 
 srs_error_t StreamEntry::serve_http(std::shared_ptr<IHttpResponseWriter> writer, 
@@ -278,10 +564,13 @@ srs_error_t StreamEntry::serve_http(std::shared_ptr<IHttpResponseWriter> writer,
       return;
     }
     
-    auto consumer = source_->CreateConsumer();
+    auto consumer = source_->CreateConsumer(replica_);
+
+    // play from the keyframe before the offset in gop cache for time-shift.
+    int64_t start_offset = parse_start_offset(message->query_get("start"));
 
-    if ((err = source_->ConsumerDumps(
-        consumer.get(), true, true, !encoder->has_cache())) != srs_success) {
+    if ((err = source_->ConsumerDumps(consumer.get(), true, true, 
+        !encoder->has_cache(), start_offset, replica_)) != srs_success) {
       MLOG_CERROR("dumps consumer, desc:%s", srs_error_desc(err));
       delete err;
       if ((err = shared_writer->final_request()) != srs_success) {
@@ -307,21 +596,27 @@ srs_error_t StreamEntry::serve_http(std::shared_ptr<IHttpResponseWriter> writer,
       }
     }
 
-    IMediaConnection* key = message->connection().get();
-    add_customer(key, std::move(consumer), std::move(bw), std::move(encoder));
+    // wake up to send the cached packets when the socket is writable.
+    shared_writer->SignalOnWrite_.connect(this, &StreamEntry::on_write_event);
 
     // statistics
+    IMediaConnection* key = message->connection().get();
     auto req = message->to_request(g_server_.config_.vhost);
     std::ostringstream oss;
     oss << req->ip;
     oss << (uint64_t)key;
     Stat().OnClient(oss.str(), req, TRtmpPlay);
+
+    add_customer(key, std::move(consumer), std::move(bw), std::move(encoder),
+                 shared_writer, oss.str());
   }, RTC_FROM_HERE);
 
   return srs_success;
 }
 
 void StreamEntry::conn_destroy(std::shared_ptr<IMediaConnection> conn) {
+  source_->ReleaseConsumer(replica_);
+
   async_task([this, raw_conn = conn.get()]() {
     delete_customer(raw_conn);
   }, RTC_FROM_HERE);
@@ -329,15 +624,22 @@ void StreamEntry::conn_destroy(std::shared_ptr<IMediaConnection> conn) {
 
 void StreamEntry::async_task(std::function<void()> f, const rtc::Location& l) {
   std::weak_ptr<StreamEntry> weak_this{weak_from_this()};
-  worker_->task([weak_this, f] {
+  std::atomic_load(&worker_)->task([weak_this, f, l] {
     if (auto this_ptr = weak_this.lock()) {
+      // posted before the stream moved, follow it.
+      if (!this_ptr->is_current()) {
+        this_ptr->async_task(f, l);
+        return;
+      }
       f();
     }
   }, l);
 }
 
 //MediaFlvPlayHandler
-MediaFlvPlayHandler::MediaFlvPlayHandler() = default;
+MediaFlvPlayHandler::MediaFlvPlayHandler(IMediaHttpHandler* files)
+    : files_{files} {
+}
 
 MediaFlvPlayHandler::~MediaFlvPlayHandler() = default;
 
@@ -345,23 +647,21 @@ srs_error_t MediaFlvPlayHandler::mount_service(
     std::shared_ptr<MediaSource> s, std::shared_ptr<MediaRequest> r) {
 
   srs_error_t result = srs_success;
-  std::map<std::string, std::shared_ptr<StreamEntry>>::iterator found;
-  
-  {
-    std::string stream_id = srs_generate_stream_url("", r->app, r->stream);
-    std::lock_guard<std::mutex> guard(stream_lock_);
-    found = steams_.find(stream_id);
-
-    if (found == steams_.end()) {
-      auto stream = std::make_shared<StreamEntry>(s, r);
+  std::string stream_id = srs_generate_stream_url("", r->app, r->stream);
+  std::shared_ptr<StreamEntry> stream;
+
+  if (!steams_.Find(stream_id, &stream)) {
+    // created out of the lock, and dropped if mounted by others meanwhile.
+    auto created = std::make_shared<StreamEntry>(s, r);
+    stream = steams_.Emplace(stream_id, created);
+    if (stream == created) {
       stream->initialize();
-      steams_.emplace(stream_id, stream);
       return result;
-    } 
+    }
   }
   
   //reuse it and update
-  found->second->update();
+  stream->update();
 
   return result;
 }
@@ -370,22 +670,12 @@ void MediaFlvPlayHandler::unmount_service(std::shared_ptr<MediaSource>,
                                        std::shared_ptr<MediaRequest> r) {
 
   std::string service_id = srs_generate_stream_url("", r->app, r->stream);
-  std::lock_guard<std::mutex> guard(stream_lock_);
-  steams_.erase(service_id);
+  steams_.Erase(service_id);
 }
 
 void MediaFlvPlayHandler::conn_destroy(std::shared_ptr<IMediaConnection> conn) {
   std::shared_ptr<StreamEntry> handler;
-  {
-    std::lock_guard<std::mutex> guard(index_lock_);
-    auto found = index_.find(conn.get());
-    if (found != index_.end()) {
-      handler = found->second;
-      index_.erase(found);
-    }
-  }
-  
-  if (handler) {
+  if (index_.Erase(conn.get(), &handler)) {
     handler->conn_destroy(conn);
   }
   
@@ -417,20 +707,17 @@ srs_error_t MediaFlvPlayHandler::serve_http(
             ", port:" << req->port << 
             ", param:" << req->param);
 
-  {
-    std::lock_guard<std::mutex> guard(stream_lock_);
-    auto found = steams_.find(req->get_stream_url());
-    if (found == steams_.end()) {
-      return srs_go_http_error(writer.get(), SRS_CONSTS_HTTP_NotFound);
+  if (!steams_.Find(req->get_stream_url(), &handler)) {
+    if (files_) {
+      return files_->serve_http(std::move(writer), std::move(msg));
     }
-
-    handler = found->second;
+    return srs_go_http_error(writer.get(), SRS_CONSTS_HTTP_NotFound);
   }
 
-  {
-    std::lock_guard<std::mutex> guard(index_lock_);
-    index_.emplace(msg->connection().get(), handler);
-  }
+  // spread the players of a hot stream over the relay replicas.
+  handler = handler->place();
+
+  index_.Insert(msg->connection().get(), handler);
 
   return handler->serve_http(writer, msg);
 }
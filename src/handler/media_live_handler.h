@@ -8,11 +8,11 @@
 #define __MEDIA_LIVE_SERVER_HANDLER_H__
 
 #include <memory>
-#include <map>
-#include <mutex>
+#include <string>
 
 #include "encoder/media_flv_encoder.h"
 #include "handler/h/media_handler.h"
+#include "utils/media_sharded_map.h"
 
 namespace ma {
 
@@ -24,7 +24,8 @@ class StreamEntry;
 
 class MediaFlvPlayHandler : public IMediaHttpHandler {
  public:
-  MediaFlvPlayHandler();
+  // the flv not in live is served by |files|, the recorded one.
+  explicit MediaFlvPlayHandler(IMediaHttpHandler* files = nullptr);
   ~MediaFlvPlayHandler() override;
   
   srs_error_t mount_service(std::shared_ptr<MediaSource> s, 
@@ -39,11 +40,12 @@ class MediaFlvPlayHandler : public IMediaHttpHandler {
                          std::shared_ptr<ISrsHttpMessage> msg) override;
 
  private:
-  std::mutex stream_lock_;
-  std::map<std::string, std::shared_ptr<StreamEntry>> steams_; //need lock
+  // looked up by every player without lock.
+  ReadMostlyMap<std::string, std::shared_ptr<StreamEntry>> steams_;
 
-  std::mutex index_lock_;
-  std::map<IMediaConnection*, std::shared_ptr<StreamEntry>> index_;
+  ShardedMap<IMediaConnection*, std::shared_ptr<StreamEntry>> index_;
+
+  IMediaHttpHandler* files_;
 };
 
 }
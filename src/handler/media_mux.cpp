@@ -21,8 +21,8 @@ namespace ma {
 
 MediaHttpServeMux::MediaHttpServeMux() 
     : rtc_sevice_{new MediaHttpRtcServeMux},
-      flv_sevice_{new MediaFlvPlayHandler},
-      file_sevice_{new MediaFileHandler} {
+      file_sevice_{new MediaFileHandler},
+      flv_sevice_{new MediaFlvPlayHandler(file_sevice_.get())} {
   g_conn_mgr_.signal_destroy_conn_.connect(this, &MediaHttpServeMux::conn_destroy);
 }
 
@@ -42,7 +42,8 @@ srs_error_t MediaHttpServeMux::serve_http(
     return rtc_sevice_->serve_http(std::move(writer), std::move(msg));
   }
 
-  if (path == HTTP_TEST) {
+  // the player pages and the other static files under www path.
+  if (path == HTTP_TEST || msg->ext() != ".flv") {
     return file_sevice_->serve_http(std::move(writer), std::move(msg));
   }
 
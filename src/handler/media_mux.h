@@ -39,8 +39,8 @@ public:
   void conn_destroy(std::shared_ptr<IMediaConnection>) override;
 private:
   std::unique_ptr<IMediaHttpHandler> rtc_sevice_;
-  std::unique_ptr<IMediaHttpHandler> flv_sevice_;
   std::unique_ptr<IMediaHttpHandler> file_sevice_;
+  std::unique_ptr<IMediaHttpHandler> flv_sevice_;
 };
 
 }
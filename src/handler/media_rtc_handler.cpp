@@ -289,8 +289,6 @@ srs_error_t MediaHttpPublishHandler::serve_http(
             ", param:" << req->param <<
             ", clientip:" << clientip);
   
-  writer->header()->set("Connection", "Close");
-  
   json::Object jroot;
   jroot["code"] = SRS_CONSTS_HTTP_Conflict;
   jroot["server"] = "mia rtc";
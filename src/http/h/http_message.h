@@ -10,8 +10,10 @@
 
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "rtc_base/sigslot.h"
 #include "rtmp/media_req.h"
@@ -26,7 +28,10 @@ private:
   // general-header fields first, followed by request-header or response-
   // header fields, and ending with the entity-header fields.
   // @doc https://tools.ietf.org/html/rfc2616#section-4.2
-  std::map<std::string, std::string> headers;
+  // A small flat array in received order, the fields are few so looked up
+  // linearly, the strings of the cleared fields are reused.
+  std::vector<std::pair<std::string, std::string>> headers;
+  size_t count_{0};
 public:
   SrsHttpHeader() = default;
   ~SrsHttpHeader() = default;
@@ -39,6 +44,10 @@ public:
   // To access multiple values of a key, access the map directly
   // with CanonicalHeaderKey.
   std::string get(const std::string& key) const;
+  // Get the value without copy, case-insensitive, valid until changed.
+  std::string_view find(std::string_view key) const;
+  // Add the field as received, the key is not canonicalized.
+  void add(std::string_view key, std::string_view value);
   // Delete the http header indicated by key.
   // Return the removed header field.
   void del(const std::string&);
@@ -57,9 +66,8 @@ public:
 public:
   // write all headers to string stream.
   void write(std::stringstream& ss);
-  const std::map<std::string, std::string>& header();
 
-  void clear() { headers.clear(); }
+  void clear() { count_ = 0; }
 };
 
 class IMediaConnection;
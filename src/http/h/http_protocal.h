@@ -47,12 +47,42 @@ public:
 
   virtual srs_error_t writev(const iovec* iov, int iovcnt, ssize_t* pnwrite) = 0;
 
+  // Send the file range without copying it to user space, called in the io
+  // thread of the writer only, with the content length set. The bytes sent 
+  // are returned by psent, wait for SignalOnWrite_ to send the rest when 
+  // ERROR_SOCKET_WOULD_BLOCK, the fd is never closed by the writer.
+  virtual srs_error_t sendfile(
+      int fd, int64_t offset, int64_t size, int64_t* psent) = 0;
+
   virtual void write_header(int code) = 0;
 
+  // The bytes accepted by write but not sent to socket yet.
+  virtual int64_t queued_bytes() = 0;
+  // The bytes sent to socket in total.
+  virtual int64_t sent_bytes() = 0;
+  // The send system calls issued on socket in total.
+  virtual int64_t send_calls() = 0;
+  // The time in ms the queued bytes stay above the high watermark in total.
+  virtual int64_t high_watermark_ms() = 0;
+  // Close the connection actively, for example the peer is too slow.
+  virtual void disconnect() = 0;
+
   // Used only for OnWriteEvent.
   sigslot::signal1<IHttpResponseWriter*> SignalOnWrite_;
 };
 
+// Batch the writes of the response writers on the current thread, they're 
+// submitted to the io threads by one task per io thread when the outermost 
+// batch ends, instead of one task per write.
+class HttpWriteBatch final {
+ public:
+  HttpWriteBatch();
+  ~HttpWriteBatch();
+
+  HttpWriteBatch(const HttpWriteBatch&) = delete;
+  void operator=(const HttpWriteBatch&) = delete;
+};
+
 enum http_parser_type { 
   HTTP_REQUEST, 
   HTTP_RESPONSE, 
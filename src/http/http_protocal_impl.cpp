@@ -1,10 +1,17 @@
 #include "http/http_protocal_impl.h"
 
+#include <strings.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
 #include "rtc_base/thread.h"
 #include "common/media_define.h"
 #include "common/media_log.h"
 #include "http/http_stack.h"
 #include "utils/media_msg_chain.h"
+#include "utils/media_io_uring.h"
 
 namespace ma {
 
@@ -38,6 +45,11 @@ void AsyncSokcetWrapper::Open(bool is_server, rtc::Thread* thread) {
   
   server_ = is_server;
   thread_ = thread;
+
+  if (server_) {
+    last_read_ms_ = rtc::TimeMillis();
+    thread_->PostDelayed(RTC_FROM_HERE, kIdleTimeoutMs, this);
+  }
 }
 
 void AsyncSokcetWrapper::Close() {
@@ -49,39 +61,46 @@ void AsyncSokcetWrapper::Close() {
   conn_->Close();
 }
 
+void AsyncSokcetWrapper::Disconnect() {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+  if (close_) {
+    return ;
+  }
+
+  OnCloseEvent(conn_.get(), 0);
+}
+
 srs_error_t AsyncSokcetWrapper::Write(MessageChain* msg, int* sent) {
   RTC_DCHECK_RUN_ON(&thread_check_);
 
+  if (sent) {
+    *sent = 0;
+  }
+
   if (close_) {
     return srs_error_new(ERROR_SOCKET_CLOSED, "socket closed");
   }
 
+  if (UNLIKELY(blocked_)) {
+    return srs_error_new(ERROR_SOCKET_WOULD_BLOCK, "need on send");
+  }
+
   srs_error_t err = srs_success;
   int isent = 0;
   
-  if (UNLIKELY(blocked_)) {
-    err = srs_error_new(ERROR_SOCKET_WOULD_BLOCK, "need on send");
-  } else {
-    MessageChain* pnext = msg;
-    while (pnext) {
-      int msg_sent = 0;
-      uint32_t len = pnext->GetFirstMsgLength();
-      if (len != 0) {
-        const char* c_data = pnext->GetFirstMsgReadPtr();
-        MA_ASSERT(c_data + len == pnext->GetFirstMsgWritePtr());
-        err = Write_i(c_data, len, &msg_sent);
-        isent += msg_sent;
-        if (err != srs_success) {
-          //error occur, mybe would block
-          MA_ASSERT(srs_error_code(err) == ERROR_SOCKET_WOULD_BLOCK);
-          if (srs_error_code(err) == ERROR_SOCKET_WOULD_BLOCK) {
-            blocked_ = true;
-          }
-          break;
-        }
-      }
-      pnext = pnext->GetNext();
+  // one writev for the whole chain, unless it's longer than kMaxIovecs.
+  iovec iov[kMaxIovecs];
+  const MessageChain* pnext = msg;
+  while (pnext && err == srs_success) {
+    uint32_t len = 0;
+    const MessageChain* remainder = nullptr;
+    int iovcnt = (int)pnext->FillIov(iov, kMaxIovecs, len, remainder);
+    if (iovcnt == 0) {
+      break;
     }
+
+    err = Writev_i(iov, iovcnt, len, &isent);
+    pnext = remainder;
   }
 
   if (sent) {
@@ -91,30 +110,64 @@ srs_error_t AsyncSokcetWrapper::Write(MessageChain* msg, int* sent) {
   return err;
 }
 
-srs_error_t AsyncSokcetWrapper::Write_i(const char* c_data, int c_size, int* sent) {
+srs_error_t AsyncSokcetWrapper::Writev(const iovec* iov, int iovcnt, int* sent) {
   RTC_DCHECK_RUN_ON(&thread_check_);
 
+  if (sent) {
+    *sent = 0;
+  }
+
+  if (close_) {
+    return srs_error_new(ERROR_SOCKET_CLOSED, "socket closed");
+  }
+
+  if (UNLIKELY(blocked_)) {
+    return srs_error_new(ERROR_SOCKET_WOULD_BLOCK, "need on send");
+  }
+
   srs_error_t err = srs_success;
-  
-  int left_size = c_size;
-  int size;
-  const char* data;
-  
-  do {
-    data = c_data + c_size - left_size;
-    size = std::min(left_size, kMaxPacketSize);
-    
-    if (size <= 0) {
-      break;
+  int isent = 0;
+  for (int i = 0; i < iovcnt && err == srs_success; i += kMaxIovecs) {
+    int count = std::min(iovcnt - i, kMaxIovecs);
+    uint32_t len = 0;
+    for (int j = i; j < i + count; ++j) {
+      len += iov[j].iov_len;
     }
-    
-    rtc::PacketOptions option;
-    int ret = conn_->Send(data, size, option);
+    err = Writev_i(iov + i, count, len, &isent);
+  }
+
+  if (sent) {
+    *sent = isent;
+  }
+
+  return err;
+}
+
+srs_error_t AsyncSokcetWrapper::SendFile(
+    int fd, int64_t offset, int64_t size, int64_t* sent) {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+
+  *sent = 0;
+
+  if (close_) {
+    return srs_error_new(ERROR_SOCKET_CLOSED, "socket closed");
+  }
+
+  if (UNLIKELY(blocked_)) {
+    return srs_error_new(ERROR_SOCKET_WOULD_BLOCK, "need on send");
+  }
+
+  srs_error_t err = srs_success;
+  rtc::PacketOptions option;
+  while (*sent < size) {
+    size_t count = (size_t)std::min<int64_t>(size - *sent, kMaxSendFile);
+    int ret = conn_->SendFile(fd, offset + *sent, count, option);
+    ++send_calls_;
     if (UNLIKELY(ret <= 0)) {
-      MA_ASSERT(EMSGSIZE != conn_->GetError());
       if (conn_->GetError() == EWOULDBLOCK) {
+        blocked_ = true;
         err = srs_error_new(ERROR_SOCKET_WOULD_BLOCK, 
-            "need on send, sent:%d", c_size - left_size);
+            "need on send, sent:%d", (int)*sent);
       } else {
         err = srs_error_new(ERROR_SOCKET_ERROR, 
             "unexpect low level error code:%d", conn_->GetError());
@@ -122,15 +175,54 @@ srs_error_t AsyncSokcetWrapper::Write_i(const char* c_data, int c_size, int* sen
       break;
     }
 
-    // must be total sent
-    MA_ASSERT(ret == size);
-    left_size -= ret;
-  } while(true);
+    *sent += ret;
+    if ((size_t)ret < count) {
+      blocked_ = true;
+      err = srs_error_new(ERROR_SOCKET_WOULD_BLOCK, 
+          "need on send, sent:%d", (int)*sent);
+      break;
+    }
+  }
 
-  if (sent) {
-    *sent = c_size - left_size;
+  return err;
+}
+
+int AsyncSokcetWrapper::SendDescriptor() {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+  if (close_ || blocked_) {
+    return -1;
   }
+  return conn_->GetSendDescriptor();
+}
 
+srs_error_t AsyncSokcetWrapper::Writev_i(
+    const iovec* iov, int iovcnt, uint32_t len, int* sent) {
+  srs_error_t err = srs_success;
+
+  rtc::PacketOptions option;
+  int ret = conn_->SendV(iov, iovcnt, option);
+  ++send_calls_;
+  if (UNLIKELY(ret <= 0)) {
+    if (conn_->GetError() == EWOULDBLOCK) {
+      err = srs_error_new(ERROR_SOCKET_WOULD_BLOCK, 
+          "need on send, sent:%d", *sent);
+    } else {
+      err = srs_error_new(ERROR_SOCKET_ERROR, 
+          "unexpect low level error code:%d", conn_->GetError());
+    }
+  } else {
+    *sent += ret;
+    // partial written, the caller advances by sent bytes.
+    if ((uint32_t)ret < len) {
+      err = srs_error_new(ERROR_SOCKET_WOULD_BLOCK, 
+          "need on send, sent:%d", *sent);
+    }
+  }
+
+  if (err != srs_success && 
+      srs_error_code(err) == ERROR_SOCKET_WOULD_BLOCK) {
+    blocked_ = true;
+  }
   return err;
 }
 
@@ -143,6 +235,7 @@ void AsyncSokcetWrapper::OnReadEvent(rtc::AsyncPacketSocket*,
   MA_ASSERT_RETURN(c_size, );
   std::string_view str_req{c_msg, c_size};
   if (server_) {
+    last_read_ms_ = rtc::TimeMillis();
     auto p = req_reader_.lock();
     if (p) {
       p->OnRequest(str_req);
@@ -158,6 +251,8 @@ void AsyncSokcetWrapper::OnCloseEvent(rtc::AsyncPacketSocket* socket, int err) {
     conn_->Close();
   }
   close_ = true;
+  // the responses not sent are dropped.
+  writers_.clear();
 
   // avoid dtor in this function, will cause dead lock
   rtc::Thread* thread = rtc::ThreadManager::Instance()->CurrentThread();
@@ -186,12 +281,74 @@ void AsyncSokcetWrapper::OnWriteEvent(rtc::AsyncPacketSocket*) {
   }
   
   blocked_ = false;
-  auto ptr = writer_.lock();
+  if (writers_.empty()) {
+    return ;
+  }
+
+  auto ptr = writers_.front().writer.lock();
   if (ptr) {
     ptr->OnWriteEvent();
   }
 }
 
+bool AsyncSokcetWrapper::AddWriter(std::weak_ptr<HttpResponseWriterProxy> w) {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+  writers_.push_back(PendingWriter{std::move(w), nullptr});
+  return writers_.size() == 1;
+}
+
+void AsyncSokcetWrapper::KeepWriter(std::shared_ptr<HttpResponseWriterProxy> w) {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+  for (auto& i : writers_) {
+    if (i.writer.lock() == w) {
+      i.flushing = std::move(w);
+      return;
+    }
+  }
+}
+
+void AsyncSokcetWrapper::NextWriter() {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+
+  // drop the responses sent, or the writers released without finished.
+  while (!writers_.empty()) {
+    auto ptr = writers_.front().writer.lock();
+    if (ptr && !ptr->done()) {
+      break;
+    }
+    writers_.pop_front();
+  }
+
+  if (close_ || writers_.empty()) {
+    return ;
+  }
+
+  // activated out of the call stack of the one finished.
+  thread_->PostTask(RTC_FROM_HERE, [w = writers_.front().writer] {
+    if (auto ptr = w.lock()) {
+      ptr->activate();
+    }
+  });
+}
+
+void AsyncSokcetWrapper::OnMessage(rtc::Message*) {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+  if (close_) {
+    return ;
+  }
+
+  int64_t idle = rtc::TimeMillis() - last_read_ms_;
+  // a response in progress, such as the flv stream, is not idle.
+  if (writers_.empty() && idle >= kIdleTimeoutMs) {
+    MLOG_TRACE("idle timeout, " << idle << "ms");
+    Disconnect();
+    return ;
+  }
+
+  int delay = idle < kIdleTimeoutMs ? kIdleTimeoutMs - (int)idle : kIdleTimeoutMs;
+  thread_->PostDelayed(RTC_FROM_HERE, delay, this);
+}
+
 std::string AsyncSokcetWrapper::Ip() {
   if (conn_)
     return conn_->GetRemoteAddress().HostAsURIString();
@@ -250,17 +407,18 @@ srs_error_t HttpMessageParser::parse_message(
     
     if (!msg_out_) {
       //coming in on SrsHttpParseStateStart
-      auto msg = std::make_shared<HttpMessage>(buffer_view_);
+      auto msg = HttpMessage::Create(buffer_view_);
       // Initialize the basic information.
       msg->set_basic(hp_header_.type, 
                      hp_header_.method, 
                      hp_header_.status_code, 
                      hp_header_.content_length);
-      msg->set_header(*(header_.get()), http_should_keep_alive(&hp_header_));
+      msg->set_header(fields_, http_should_keep_alive(&hp_header_));
       if ((err = msg->set_url(url_, jsonp_)) != srs_success) {
         // Reset request data.
         state_ = SrsHttpParseStateInit;         
-        return srs_error_wrap(err, "set url=%s, jsonp=%d", url_.c_str(), jsonp_);
+        return srs_error_wrap(err, "set url=%.*s, jsonp=%d", 
+            (int)url_.length(), url_.data(), jsonp_);
       }
 
       msg_out_ = std::move(msg);
@@ -292,10 +450,9 @@ srs_error_t HttpMessageParser::parse_message(
   // The body that we have read from cache.
   p_body_start_ = p_header_tail_ = NULL;
   // We must reset the field name and value, because we may get a partial value in on_header_value.
-  field_name_ = field_value_ = "";
-  // The header of the request.
-
-  header_ = std::move(std::make_unique<SrsHttpHeader>());
+  field_name_ = field_value_ = url_ = std::string_view();
+  // The header of the request, the capacity is reused.
+  fields_.clear();
 
   // Reset parser for each message.
   // If the request is large, such as the fifth message at 
@@ -311,7 +468,7 @@ srs_error_t HttpMessageParser::parse_message(
   // callback object ptr.
   parser_.data = (void*)this;
 
-  buffer_.clear();
+  // the bytes left are the pipelined requests, parsed by the empty input.
   
   // do parse
   if ((err = parse_message_imp(str_msg)) != srs_success) {
@@ -334,18 +491,19 @@ srs_error_t HttpMessageParser::parse_message(
   }
 
   //header completed
-  auto msg = std::make_shared<HttpMessage>(buffer_view_);
+  auto msg = HttpMessage::Create(buffer_view_);
 
   // Initialize the basic information.
   msg->set_basic(hp_header_.type, 
                  hp_header_.method, 
                  hp_header_.status_code, 
                  hp_header_.content_length);
-  msg->set_header(*(header_.get()), http_should_keep_alive(&hp_header_));
+  msg->set_header(fields_, http_should_keep_alive(&hp_header_));
   if ((err = msg->set_url(url_, jsonp_)) != srs_success) {
     // Reset request data.
     state_ = SrsHttpParseStateInit;
-    return srs_error_wrap(err, "set url=%s, jsonp=%d", url_.c_str(), jsonp_);
+    return srs_error_wrap(err, "set url=%.*s, jsonp=%d", 
+        (int)url_.length(), url_.data(), jsonp_);
   }
 
   if (state_ == SrsHttpParseStateMessageComplete) {
@@ -373,16 +531,33 @@ srs_error_t HttpMessageParser::parse_message_imp(std::string_view str_msg) {
   srs_error_t err = srs_success;
 
   buffer_.erase(0, consumed_);
+  consumed_ = 0;
   buffer_.append(str_msg.data(), str_msg.length());
   buffer_view_ = buffer_;
+
+  // wait for the whole header, to slice the fields from buffer.
+  if (state_ < SrsHttpParseStateHeaderComplete && 
+      buffer_.find(SRS_HTTP_CRLFCRLF) == std::string::npos &&
+      buffer_.find("\n\n") == std::string::npos) {
+    if (buffer_.length() > kMaxHeaderSize) {
+      return srs_error_new(ERROR_HTTP_PARSE_HEADER, 
+          "header exceed %d bytes", (int)kMaxHeaderSize);
+    }
+    state_ = SrsHttpParseStateStart;
+    return err;
+  }
   
   if (!buffer_view_.empty()) {
     consumed_ = http_parser_execute(
         &parser_, &settings_, buffer_view_.data(), buffer_view_.length());
 
-    // The error is set in http_errno.
-    enum http_errno code;
-    if ((code = HTTP_PARSER_ERRNO(&parser_)) != HPE_OK) {
+    // The error is set in http_errno, paused at the end of a message, the 
+    // pipelined requests after it are left in buffer.
+    enum http_errno code = HTTP_PARSER_ERRNO(&parser_);
+    bool paused = (code == HPE_PAUSED);
+    if (paused) {
+      parser_.http_errno = HPE_OK;
+    } else if (code != HPE_OK) {
       return srs_error_new(ERROR_HTTP_PARSE_HEADER, 
           "parse %dB, nparsed=%d, err=%d/%s %s", buffer_view_.length(), 
                                                  (int)consumed_, 
@@ -415,14 +590,12 @@ srs_error_t HttpMessageParser::parse_message_imp(std::string_view str_msg) {
     // Only consume the header bytes.
     buffer_view_.remove_prefix(consumed);
 
-    // Done when header completed, never wait for body completed, 
-    // because it maybe chunked.
-    if (state_ >= SrsHttpParseStateHeaderComplete) {
-      HttpMessageParser* obj = this;
-      if (!obj->field_value_.empty()) {
-        obj->header_->set(obj->field_name_, obj->field_value_);
-      }
+    // the body is not followed by the next request.
+    if (paused) {
+      buffer_view_ = buffer_view_.substr(
+          0, buffer_.data() + consumed_ - buffer_view_.data());
     }
+
   }
   
   return err;
@@ -447,6 +620,12 @@ int HttpMessageParser::on_headers_complete(http_parser* parser) {
   // save the parser when header parse completed.
   obj->state_ = SrsHttpParseStateHeaderComplete;
 
+  // the last field.
+  if (!obj->field_name_.empty()) {
+    obj->fields_.emplace_back(obj->field_name_, obj->field_value_);
+    obj->field_name_ = obj->field_value_ = std::string_view();
+  }
+
   // We must update the body start when header complete, because sometimes we only got header.
   // When we got the body start event, we will update it to much precious position.
   obj->p_body_start_ = obj->buffer_view_.data() + obj->buffer_view_.length();
@@ -462,6 +641,9 @@ int HttpMessageParser::on_message_complete(http_parser* parser) {
   
   // save the parser when body parse completed.
   obj->state_ = SrsHttpParseStateMessageComplete;
+
+  // one message by one parse, keep the pipelined ones.
+  parser->http_errno = HPE_PAUSED;
   
   MLOG_CDEBUG("***MESSAGE COMPLETE***\n");
   
@@ -473,7 +655,7 @@ int HttpMessageParser::on_url(http_parser* parser, const char* at, size_t length
   srs_assert(obj);
   
   if (length > 0) {
-      obj->url_ = std::string(at, (int)length);
+      obj->url_ = std::string_view(at, length);
   }
 
   // When header parsed, we must save the position of start for body,
@@ -490,14 +672,12 @@ int HttpMessageParser::on_header_field(http_parser* parser, const char* at, size
   HttpMessageParser* obj = (HttpMessageParser*)parser->data;
   srs_assert(obj);
 
-  if (!obj->field_value_.empty()) {
-      obj->header_->set(obj->field_name_, obj->field_value_);
-      obj->field_name_ = obj->field_value_ = "";
-  }
-  
-  if (length > 0) {
-      obj->field_name_.append(at, (int)length);
+  // the field before, a field is never split in one buffer.
+  if (!obj->field_name_.empty()) {
+      obj->fields_.emplace_back(obj->field_name_, obj->field_value_);
   }
+  obj->field_name_ = std::string_view(at, length);
+  obj->field_value_ = std::string_view();
 
   // When header parsed, we must save the position of start for body,
   // because we have to consume the header in buffer.
@@ -512,8 +692,12 @@ int HttpMessageParser::on_header_value(http_parser* parser, const char* at, size
   HttpMessageParser* obj = (HttpMessageParser*)parser->data;
   srs_assert(obj);
   
-  if (length > 0) {
-      obj->field_value_.append(at, (int)length);
+  // the folded value is continued.
+  if (obj->field_value_.empty()) {
+      obj->field_value_ = std::string_view(at, length);
+  } else {
+      obj->field_value_ = std::string_view(obj->field_value_.data(), 
+          at + length - obj->field_value_.data());
   }
 
   // When header parsed, we must save the position of start for body,
@@ -663,6 +847,31 @@ srs_error_t HttpResponseWriter::write(
   MA_ASSERT(result_msg == nullptr);
   
   int size = send_msg ? send_msg->GetChainedLength() : 0;
+  bool trailer = false;
+  srs_error_t err = frame(size, send_msg != nullptr, result_msg, trailer);
+  if (err != srs_success || !send_msg) {
+    return err;
+  }
+
+  MessageChain* body = send_msg->DuplicateChained();
+  if (trailer) {
+    body->Append(crlf());
+  }
+
+  if (result_msg) {
+    result_msg->Append(body);
+  } else {
+    result_msg = body;
+  }
+
+  return err;
+}
+
+srs_error_t HttpResponseWriter::frame(
+    int size, bool body, MessageChain*& head, bool& trailer) {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+
+  trailer = false;
     
   // write the header data in memory.
   if (!header_wrote_) {
@@ -676,7 +885,7 @@ srs_error_t HttpResponseWriter::write(
   }
   
   // get header
-  result_msg = send_header((const char*)send_msg, size);
+  head = send_header(body ? "" : nullptr, size);
 
   // check the bytes send and content length.
   written_ += size;
@@ -686,19 +895,8 @@ srs_error_t HttpResponseWriter::write(
   }
 
   srs_error_t err = srs_success;
-  // ignore NULL content.
-  if (!send_msg) {
-    return err;
-  }
-  
-  // directly send with content length
-  if (content_length_ != -1) {
-
-    if (result_msg) {
-      result_msg->Append(send_msg->DuplicateChained());
-    } else {
-      result_msg = send_msg->DuplicateChained();
-    }
+  // ignore NULL content, directly send with content length.
+  if (!body || content_length_ != -1) {
     return err;
   }
   
@@ -708,22 +906,25 @@ srs_error_t HttpResponseWriter::write(
 
   MA_ASSERT(nb_size <= SRS_HTTP_HEADER_CACHE_SIZE);
 
-  MessageChain pStart{(uint32_t)nb_size, header_cache_, MessageChain::DONT_DELETE, (uint32_t)nb_size};
-  MessageChain pEnd{2, (char*)SRS_HTTP_CRLF, MessageChain::DONT_DELETE, 2};
-
-  MessageChain* http_msg = pStart.DuplicateChained();
-  http_msg->Append(send_msg->DuplicateChained());
-  http_msg->Append(pEnd.DuplicateChained());
- 
-  if (result_msg) {
-    result_msg->Append(http_msg);
+  MessageChain* chunk = 
+      new MessageChain(DataBlock::Create(nb_size, header_cache_));
+  if (head) {
+    head->Append(chunk);
   } else {
-    result_msg = http_msg;
+    head = chunk;
   }
+  trailer = true;
 
   return err;
 }
 
+MessageChain* HttpResponseWriter::crlf() {
+  // shared by all the chunks, never copied.
+  static const std::shared_ptr<DataBlock> block = 
+      DataBlock::Create(2, SRS_HTTP_CRLF);
+  return new MessageChain(block);
+}
+
 void HttpResponseWriter::write_header(int code) {
   RTC_DCHECK_RUN_ON(&thread_check_);
 
@@ -792,6 +993,209 @@ MessageChain* HttpResponseWriter::send_header(const char* data, int) {
 #define IS_CURRENT_THREAD(x) \
     x==rtc::ThreadManager::Instance()->CurrentThread()
 
+//HttpWriteUringBatch
+// The writes to the sockets in the scope are deferred, and sent by one 
+// io_uring submission at the end, instead of one writev for each. The later
+// writes of a response deferred are appended to its buffer, the bytes not 
+// sent by io_uring are sent by the socket, which waits for the write event.
+class HttpWriteUringBatch final {
+ public:
+  explicit HttpWriteUringBatch(bool enable) {
+    if (enable && !current_ && (sender_ = MediaUringSender::Current())) {
+      current_ = this;
+    }
+  }
+
+  ~HttpWriteUringBatch() {
+    if (current_ == this) {
+      current_ = nullptr;
+      Flush();
+    }
+  }
+
+  // Returns whether the write of |writer| is deferred.
+  static bool Defer(HttpResponseWriterProxy* writer) {
+    if (!current_ || writer->socket_->SendDescriptor() < 0) {
+      return false;
+    }
+    current_->writers_.emplace_back(writer->shared_from_this());
+    return true;
+  }
+
+ private:
+  void Flush() {
+    std::vector<int> index;
+    for (size_t i = 0; i < writers_.size(); i += kEntries) {
+      size_t count = std::min(writers_.size() - i, (size_t)kEntries);
+      index.assign(count, -1);
+      iovs_.resize(count * kMaxIovecs);
+      for (size_t j = 0; j < count; ++j) {
+        auto& writer = writers_[i + j];
+        int fd = writer->socket_->SendDescriptor();
+        if (fd < 0) {
+          continue;
+        }
+        iovec* iov = iovs_.data() + j * kMaxIovecs;
+        uint32_t len = 0;
+        const MessageChain* remainder = nullptr;
+        int iovcnt = (int)writer->buffer_->FillIov(
+            iov, kMaxIovecs, len, remainder);
+        index[j] = sender_->Prepare(fd, iov, iovcnt);
+        // one send of the submission for each socket in it.
+        if (index[j] >= 0) {
+          ++writer->socket_->send_calls_;
+        }
+      }
+
+      sender_->Submit();
+      for (size_t j = 0; j < count; ++j) {
+        int sent = index[j] < 0 ? 0 : sender_->Result(index[j]);
+        writers_[i + j]->flush_deferred(std::max(sent, 0));
+      }
+      sender_->Reset();
+    }
+    writers_.clear();
+  }
+
+ private:
+  MediaUringSender* sender_{nullptr};
+  std::vector<std::shared_ptr<HttpResponseWriterProxy>> writers_;
+
+  static constexpr int kEntries = MediaUringSender::kEntries;
+  static constexpr int kMaxIovecs = SRS_PERF_WRITEV_IOVS;
+  // the iovecs of the messages submitted, kept by the io thread.
+  static thread_local std::vector<iovec> iovs_;
+  static thread_local HttpWriteUringBatch* current_;
+};
+
+thread_local std::vector<iovec> HttpWriteUringBatch::iovs_;
+thread_local HttpWriteUringBatch* HttpWriteUringBatch::current_{nullptr};
+
+//HttpWriteSubmitRing
+// The writes submitted by one media worker to one io thread, the worker 
+// pushes them and rings the doorbell once per batch, the io thread drains 
+// them by one task. A doorbell drains the writes pushed before it only, so 
+// the writes posted alone between two doorbells keep their order.
+class HttpWriteSubmitRing 
+    : public std::enable_shared_from_this<HttpWriteSubmitRing> {
+  struct Submit {
+    std::weak_ptr<HttpResponseWriterProxy> writer;
+    MessageChain* data{nullptr};
+    uint32_t data_len{0};
+  };
+ public:
+  explicit HttpWriteSubmitRing(rtc::Thread* thread)
+    : thread_{thread}, slots_(kCapacity) { }
+
+  ~HttpWriteSubmitRing() {
+    // the io thread is gone with the writes.
+    Drain(tail_.load(std::memory_order_acquire), false);
+  }
+
+  // Called by the producer.
+  bool Push(std::weak_ptr<HttpResponseWriterProxy> writer, 
+            MessageChain* data, uint32_t data_len) {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == kCapacity) {
+      return false;
+    }
+
+    Submit& slot = slots_[tail & (kCapacity - 1)];
+    slot.writer = std::move(writer);
+    slot.data = data;
+    slot.data_len = data_len;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Called by the producer, post one task to drain the pushed writes.
+  void Ring() {
+    uint64_t end = tail_.load(std::memory_order_relaxed);
+    if (end == rung_) {
+      return;
+    }
+    rung_ = end;
+
+    thread_->PostTask(RTC_FROM_HERE, [ring = shared_from_this(), end] {
+      ring->Drain(end, true);
+    });
+  }
+
+  // The rings of the current thread, one for each io thread.
+  static std::shared_ptr<HttpWriteSubmitRing> Of(rtc::Thread* thread) {
+    auto& ring = rings_[thread];
+    if (!ring) {
+      ring = std::make_shared<HttpWriteSubmitRing>(thread);
+    }
+    return ring;
+  }
+
+  static void RingAll() {
+    for (auto& i : rings_) {
+      i.second->Ring();
+    }
+  }
+
+  static void RingOf(rtc::Thread* thread) {
+    auto found = rings_.find(thread);
+    if (found != rings_.end()) {
+      found->second->Ring();
+    }
+  }
+
+  static thread_local int batch_depth_;
+ private:
+  // Called by the consumer.
+  void Drain(uint64_t end, bool write) {
+    // the writes to the sockets are sent together when drained.
+    HttpWriteUringBatch batch(write);
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    for (; head < end; ++head) {
+      Submit& slot = slots_[head & (kCapacity - 1)];
+      auto writer = slot.writer.lock();
+      slot.writer.reset();
+      if (write && writer) {
+        writer->write_async_i(slot.data, slot.data_len);
+      } else if (slot.data) {
+        slot.data->DestroyChained();
+      }
+      slot.data = nullptr;
+      head_.store(head + 1, std::memory_order_release);
+    }
+  }
+
+ private:
+  rtc::Thread* thread_;
+  std::vector<Submit> slots_;
+  std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> tail_{0};
+  // the tail when the doorbell rung last time, producer only.
+  uint64_t rung_{0};
+
+  static constexpr uint64_t kCapacity = SRS_PERF_WRITE_SUBMIT_RING;
+  static_assert((kCapacity & (kCapacity - 1)) == 0, 
+                "the capacity must be power of 2");
+
+  static thread_local 
+      std::unordered_map<rtc::Thread*, 
+                         std::shared_ptr<HttpWriteSubmitRing>> rings_;
+};
+
+thread_local int HttpWriteSubmitRing::batch_depth_{0};
+thread_local std::unordered_map<rtc::Thread*, 
+    std::shared_ptr<HttpWriteSubmitRing>> HttpWriteSubmitRing::rings_;
+
+//HttpWriteBatch
+HttpWriteBatch::HttpWriteBatch() {
+  ++HttpWriteSubmitRing::batch_depth_;
+}
+
+HttpWriteBatch::~HttpWriteBatch() {
+  if (--HttpWriteSubmitRing::batch_depth_ == 0) {
+    HttpWriteSubmitRing::RingAll();
+  }
+}
+
 //HttpResponseWriterProxy
 HttpResponseWriterProxy::HttpResponseWriterProxy(
     std::shared_ptr<AsyncSokcetWrapper> s, bool /*TODO stream=true set nodelay*/)
@@ -804,12 +1208,55 @@ HttpResponseWriterProxy::~HttpResponseWriterProxy() {
   if (buffer_) {
     buffer_->DestroyChained();
   }
+
+  // released without finished, the next response goes on.
+  if (!handed_over_) {
+    thread_->PostTask(RTC_FROM_HERE, [socket = socket_] {
+      socket->NextWriter();
+    });
+  }
 }
 
 void HttpResponseWriterProxy::open() {
   RTC_DCHECK_RUN_ON(&thread_check_);
   writer_->open();
-  socket_->SetWriter(weak_from_this());
+  held_ = !socket_->AddWriter(weak_from_this());
+}
+
+void HttpResponseWriterProxy::activate() {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+  if (!held_) {
+    return;
+  }
+
+  held_ = false;
+  OnWriteEvent();
+}
+
+void HttpResponseWriterProxy::check_done() {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+  if (!finished_ || handed_over_) {
+    return;
+  }
+
+  if (buffer_ || held_) {
+    socket_->KeepWriter(shared_from_this());
+    return;
+  }
+
+  handed_over_ = true;
+  std::string_view connection = writer_->header()->find("Connection");
+  if (connection.length() == 5 && 
+      strncasecmp(connection.data(), "close", 5) == 0) {
+    thread_->PostTask(RTC_FROM_HERE, [socket = socket_] {
+      socket->Disconnect();
+    });
+    return;
+  }
+
+  // may release this if kept.
+  auto self = shared_from_this();
+  socket_->NextWriter();
 }
 
 srs_error_t HttpResponseWriterProxy::final_request_i() {
@@ -819,9 +1266,15 @@ srs_error_t HttpResponseWriterProxy::final_request_i() {
 
   MessageChain* result = nullptr;
   if ((err = writer_->final_request(result)) == srs_success) {
+    finished_ = true;
+    if (result) {
+      queued_bytes_ += result->GetChainedLength();
+    }
+
     // final ok
     if (buffer_ && result) {
       buffer_->Append(result);
+      check_done();
       return err;
     }
     
@@ -840,6 +1293,7 @@ srs_error_t HttpResponseWriterProxy::final_request_i() {
   if (result) {
     result->DestroyChained();
   }
+  check_done();
   return err;
 }
 
@@ -885,8 +1339,45 @@ MessageChain* HttpResponseWriterProxy::internal_write(MessageChain* input) {
   return result;
 }
 
-srs_error_t HttpResponseWriterProxy::write(const char* data, int size) {
+bool HttpResponseWriterProxy::blocked() {
   if (buffer_full_) {
+    return true;
+  }
+
+  if (queued_bytes_ < kMaxQueuedBytes) {
+    return false;
+  }
+
+  wait_drain_ = true;
+  // check again, maybe drained by io thread right now.
+  if (queued_bytes_ < kMaxQueuedBytes) {
+    return false;
+  }
+
+  int64_t none = 0;
+  high_since_.compare_exchange_strong(none, rtc::TimeMillis());
+  return true;
+}
+
+void HttpResponseWriterProxy::drained() {
+  if (queued_bytes_ > kLowQueuedBytes || !wait_drain_.exchange(false)) {
+    return;
+  }
+
+  int64_t since = high_since_.exchange(0);
+  if (since) {
+    high_ms_ += rtc::TimeMillis() - since;
+  }
+  SignalOnWrite_(this);
+}
+
+int64_t HttpResponseWriterProxy::high_watermark_ms() {
+  int64_t since = high_since_;
+  return high_ms_ + (since ? rtc::TimeMillis() - since : 0);
+}
+
+srs_error_t HttpResponseWriterProxy::write(const char* data, int size) {
+  if (blocked()) {
     return srs_error_new(ERROR_SOCKET_WOULD_BLOCK, "need on send");
   }
 
@@ -908,7 +1399,7 @@ srs_error_t HttpResponseWriterProxy::write(MessageChain* data, ssize_t* pnwrite)
     return srs_error_new(ERROR_HTTP_PATTERN_EMPTY, "data length is 0");
   }
   
-  if (buffer_full_) {
+  if (blocked()) {
     return srs_error_new(ERROR_SOCKET_WOULD_BLOCK, "need on send");
   }
 
@@ -921,34 +1412,158 @@ srs_error_t HttpResponseWriterProxy::writev(
     *pnwrite = 0;
   }
   
-  if (buffer_full_) {
+  if (blocked()) {
     return srs_error_new(ERROR_SOCKET_WOULD_BLOCK, "need on send");
   }
 
-  //TODO need optimizing
-  MessageChain* data = nullptr;  
+  uint32_t size = 0;
   for (int i = 0; i < iovcnt; ++i) {
-    MessageChain part(iov[i].iov_len, 
-                      (const char*)iov[i].iov_base, 
-                      MessageChain::DONT_DELETE, 
-                      iov[i].iov_len);
+    size += iov[i].iov_len;
+  }
 
-    if (data) {
-      data->Append(part.DuplicateChained());
-    } else {
-      data = part.DuplicateChained();
-    }
+  if (size == 0) {
+    // send header only
+    return write_i(nullptr, pnwrite);
+  }
 
-    if (pnwrite) {
-      *pnwrite += iov[i].iov_len;
-    }
+  if (IS_CURRENT_THREAD(thread_) && !held_ && !buffer_) {
+    RTC_DCHECK_RUN_ON(&thread_check_);
+    writev_borrowed(iov, iovcnt, size);
+  } else if (IS_CURRENT_THREAD(thread_)) {
+    // held or deferred, appended to the bytes buffered.
+    queued_bytes_ += size;
+    write_async_i(new MessageChain(gather(iov, iovcnt, 0, size)), size);
+  } else {
+    // the iovecs are borrowed, gather them to one block for the io thread, 
+    // and hand over it without duplicating.
+    write_owned(new MessageChain(gather(iov, iovcnt, 0, size)), size);
   }
 
-  srs_error_t err = write_i(data, pnwrite);
-  data->DestroyChained();
+  if (pnwrite) {
+    *pnwrite = size;
+  }
+  return srs_success;
+}
+
+srs_error_t HttpResponseWriterProxy::sendfile(
+    int fd, int64_t offset, int64_t size, int64_t* psent) {
+  *psent = 0;
+
+  if (!(IS_CURRENT_THREAD(thread_))) {
+    return srs_error_new(ERROR_SOCKET_WRITE, "sendfile out of io thread");
+  }
+  RTC_DCHECK_RUN_ON(&thread_check_);
+
+  // the body is not framed, so no chunked encoding.
+  if (writer_->header()->content_length() == -1) {
+    return srs_error_new(ERROR_HTTP_CONTENT_LENGTH, "sendfile no length");
+  }
+
+  if (blocked()) {
+    return srs_error_new(ERROR_SOCKET_WOULD_BLOCK, "need on send");
+  }
+
+  // the http header first, buffered if blocked.
+  srs_error_t err = write_i(nullptr, nullptr);
+  if (err != srs_success) {
+    return srs_error_wrap(err, "sendfile header");
+  }
+  if (buffer_full_) {
+    return srs_error_new(ERROR_SOCKET_WOULD_BLOCK, "need on send");
+  }
+  // wait for the responses before, woken up by activate, or the bytes
+  // deferred, woken up when they are sent.
+  if (held_ || buffer_) {
+    buffer_full_ = true;
+    return srs_error_new(ERROR_SOCKET_WOULD_BLOCK, "response held");
+  }
+
+  int64_t sent = 0;
+  err = socket_->SendFile(fd, offset, size, &sent);
+  sent_bytes_ += sent;
+  *psent = sent;
+
+  // wait for OnWriteEvent, nothing buffered.
+  if (err != srs_success && 
+      srs_error_code(err) == ERROR_SOCKET_WOULD_BLOCK) {
+    buffer_full_ = true;
+  }
   return err;
 }
 
+void HttpResponseWriterProxy::writev_borrowed(
+    const iovec* iov, int iovcnt, uint32_t size) {
+  MessageChain* head = nullptr;
+  bool trailer = false;
+  srs_error_t err = writer_->frame(size, true, head, trailer);
+  if (err != srs_success) {
+    MLOG_ERROR("proxy frame failed, desc:" << srs_error_desc(err));
+    delete err;
+  }
+
+  // the http header and chunk header.
+  iovec head_iov[2];
+  uint32_t head_len = 0;
+  int head_count = 0;
+  if (head) {
+    const MessageChain* remainder = nullptr;
+    head_count = head->FillIov(head_iov, 2, head_len, remainder);
+    MA_ASSERT(!remainder);
+  }
+  uint32_t total = head_len + size + (trailer ? 2 : 0);
+  queued_bytes_ += total;
+
+  // the head, body and trailer by one writev.
+  std::vector<iovec> iovs;
+  iovs.reserve(head_count + iovcnt + 1);
+  iovs.insert(iovs.end(), head_iov, head_iov + head_count);
+  iovs.insert(iovs.end(), iov, iov + iovcnt);
+  if (trailer) {
+    iovs.push_back(iovec{const_cast<char*>(SRS_HTTP_CRLF), 2});
+  }
+
+  MA_ASSERT(!buffer_);
+  int sent = 0;
+  err = socket_->Writev(iovs.data(), (int)iovs.size(), &sent);
+  queued_bytes_ -= sent;
+  sent_bytes_ += sent;
+  if (head) {
+    head->DestroyChained();
+  }
+
+  if (err != srs_success) {
+    if (srs_error_code(err) != ERROR_SOCKET_WOULD_BLOCK) {
+      MLOG_ERROR("proxy writev failed, desc:" << srs_error_desc(err));
+    }
+    delete err;
+
+    // only the bytes not sent are copied, wait for on send.
+    buffer_ = new MessageChain(
+        gather(iovs.data(), (int)iovs.size(), sent, total - sent));
+    buffer_full_ = true;
+  } else {
+    drained();
+  }
+}
+
+std::shared_ptr<DataBlock> HttpResponseWriterProxy::gather(
+    const iovec* iov, int iovcnt, uint32_t skip, uint32_t size) {
+  std::shared_ptr<DataBlock> block = DataBlock::Create(size, nullptr);
+  char* p = block->GetBasePtr();
+  for (int i = 0; i < iovcnt; ++i) {
+    uint32_t len = iov[i].iov_len;
+    if (skip >= len) {
+      skip -= len;
+      continue;
+    }
+    memcpy(p, (const char*)iov[i].iov_base + skip, len - skip);
+    p += len - skip;
+    skip = 0;
+  }
+  MA_ASSERT(p == block->GetBasePtr() + size);
+  return block;
+}
+
 srs_error_t HttpResponseWriterProxy::write_i(
     MessageChain* data, ssize_t* pnwrite) {
   srs_error_t err = srs_success;
@@ -956,11 +1571,17 @@ srs_error_t HttpResponseWriterProxy::write_i(
 
   if (IS_CURRENT_THREAD(thread_)) {
     RTC_DCHECK_RUN_ON(&thread_check_);
-    MA_ASSERT(!buffer_);
+    queued_bytes_ += data_len;
 
     MessageChain* result = internal_write(data);
+    queued_bytes_ += 
+        (result ? (int64_t)result->GetChainedLength() : 0) - data_len;
 
-    if (result && (err = write2sock(result)) != srs_success) {
+    // only buffered by a held response, otherwise it's blocked.
+    if (result && buffer_) {
+      buffer_->Append(result);
+      result = nullptr;
+    } else if (result && (err = write2sock(result)) != srs_success) {
       if (srs_error_code(err) != ERROR_SOCKET_WOULD_BLOCK) {
         MLOG_ERROR("proxy write2sock failed, desc:" << srs_error_desc(err));
       }
@@ -987,58 +1608,87 @@ srs_error_t HttpResponseWriterProxy::write_i(
   } else {
     pDuplcated = data->DuplicateChained();
   }
+  write_owned(pDuplcated, data_len);
 
-  asyncTask([weak_ptr = weak_from_this(), pDuplcated, this] (auto) {
-    CHECK_MSG_DUPLICATED(pDuplcated);
-    auto this_ptr = weak_ptr.lock();
-    if (!this_ptr) {
-      if (pDuplcated)
-        pDuplcated->DestroyChained();
-      return;
-    }
-
-    MessageChain* result = internal_write(pDuplcated);
-    srs_error_t err = srs_success;
+  if (pnwrite) {
+    *pnwrite = data_len;
+  }
 
-    if (result) {
-      // push it into buffer, wait for on send
-      if (buffer_) {
-        buffer_->Append(result);
-        return;
-      }
+  return err;
+}
 
-      //buffer empty, send immediatly
-      if ((err = write2sock(result)) != srs_success) {
-        if (srs_error_code(err) != ERROR_SOCKET_WOULD_BLOCK) {
-          MLOG_ERROR("proxy write failed, desc:" << srs_error_desc(err)); 
-        }
-        delete err;
-        
-        //cached by buffer
-        result = nullptr;
-      }
+void HttpResponseWriterProxy::write_owned(
+    MessageChain* pDuplcated, uint32_t data_len) {
+  // count it before it's formatted in io thread, to bound the pending tasks.
+  queued_bytes_ += data_len;
 
-      if (result) {
-        result->DestroyChained();
-      }
+  // submitted in batch, the io thread is notified when the batch ends.
+  if (HttpWriteSubmitRing::batch_depth_ > 0) {
+    auto ring = HttpWriteSubmitRing::Of(thread_);
+    if (ring->Push(weak_from_this(), pDuplcated, data_len)) {
+      return;
     }
+  }
 
-    if (pDuplcated) {
+  // after the writes submitted before.
+  HttpWriteSubmitRing::RingOf(thread_);
+  thread_->PostTask(RTC_FROM_HERE, 
+      [weak_this = weak_from_this(), pDuplcated, data_len] {
+    if (auto this_ptr = weak_this.lock()) {
+      this_ptr->write_async_i(pDuplcated, data_len);
+    } else if (pDuplcated) {
       pDuplcated->DestroyChained();
     }
-  }, RTC_FROM_HERE);
+  });
+}
 
-  if (pnwrite) {
-    *pnwrite = data_len;
+void HttpResponseWriterProxy::write_async_i(
+    MessageChain* pDuplcated, uint32_t data_len) {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+  CHECK_MSG_DUPLICATED(pDuplcated);
+
+  MessageChain* result = internal_write(pDuplcated);
+  queued_bytes_ += 
+      (result ? (int64_t)result->GetChainedLength() : 0) - data_len;
+  srs_error_t err = srs_success;
+
+  if (result) {
+    // push it into buffer, wait for on send
+    if (buffer_) {
+      buffer_->Append(result);
+    } else if ((err = write2sock(result)) != srs_success) {
+      //buffer empty, send immediatly
+      if (srs_error_code(err) != ERROR_SOCKET_WOULD_BLOCK) {
+        MLOG_ERROR("proxy write failed, desc:" << srs_error_desc(err)); 
+      }
+      delete err;
+      //cached by buffer
+    } else {
+      result->DestroyChained();
+    }
   }
 
-  return err;
+  if (pDuplcated) {
+    pDuplcated->DestroyChained();
+  }
 }
 
 srs_error_t HttpResponseWriterProxy::write2sock(MessageChain* data) {
   RTC_DCHECK_RUN_ON(&thread_check_);
   CHECK_MSG_DUPLICATED(data);
   MA_ASSERT(!buffer_);
+
+  // the responses before are not finished, keep it in order.
+  if (held_) {
+    buffer_ = data;
+    return srs_error_new(ERROR_SOCKET_WOULD_BLOCK, "response held");
+  }
+
+  // sent with the other sockets by one submission later.
+  if (HttpWriteUringBatch::Defer(this)) {
+    buffer_ = data;
+    return srs_error_new(ERROR_SOCKET_WOULD_BLOCK, "deferred");
+  }
   
   int sent = 0;
   srs_error_t err = socket_->Write(data, &sent);
@@ -1052,11 +1702,55 @@ srs_error_t HttpResponseWriterProxy::write2sock(MessageChain* data) {
     buffer_full_ = true;
   }
 
-  if (sent > 0)
+  if (sent > 0) {
     data->AdvanceChainedReadPtr(sent);
+    queued_bytes_ -= sent;
+    sent_bytes_ += sent;
+  }
+
+  // the writer refused for the queued bytes, wake it up.
+  if (err == srs_success) {
+    drained();
+  }
   return err;
 }
 
+void HttpResponseWriterProxy::flush_deferred(int sent) {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+  MA_ASSERT(buffer_);
+
+  MessageChain* send = buffer_;
+  buffer_ = nullptr;
+  if (sent > 0) {
+    send->AdvanceChainedReadPtr(sent);
+    queued_bytes_ -= sent;
+    sent_bytes_ += sent;
+  }
+
+  if (send->GetChainedLength() > 0) {
+    srs_error_t err = write2sock(send);
+    if (err != srs_success) {
+      if (srs_error_code(err) != ERROR_SOCKET_WOULD_BLOCK) {
+        MLOG_ERROR("deferred write error, desc:" << srs_error_desc(err));
+      }
+
+      //send cached by buffer
+      delete err;
+      return;
+    }
+  } else {
+    drained();
+  }
+  send->DestroyChained();
+
+  // refused while deferred.
+  if (buffer_full_) {
+    OnWriteEvent();
+    return;
+  }
+  check_done();
+}
+
 void HttpResponseWriterProxy::write_header(int code) {
   if (IS_CURRENT_THREAD(thread_)) {
     writer_->write_header(code);
@@ -1096,11 +1790,20 @@ void HttpResponseWriterProxy::OnWriteEvent() {
 
   buffer_full_ = false;
   SignalOnWrite_(this);
+  check_done();
+}
+
+void HttpResponseWriterProxy::disconnect() {
+  asyncTask([](auto this_ptr) {
+    this_ptr->socket_->Disconnect();
+  }, RTC_FROM_HERE);
 }
 
 void HttpResponseWriterProxy::asyncTask(
     std::function<void(std::shared_ptr<HttpResponseWriterProxy>)> f,
     const rtc::Location& l) {
+  // after the writes submitted before.
+  HttpWriteSubmitRing::RingOf(thread_);
   std::weak_ptr<HttpResponseWriterProxy> weak_this = weak_from_this();
   thread_->PostTask(l, [weak_this, f] {
     if (auto this_ptr = weak_this.lock()) {
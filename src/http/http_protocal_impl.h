@@ -11,6 +11,7 @@
 
 #include <memory>
 #include <atomic>
+#include <deque>
 #include <functional>
 
 #include "rtc_base/sequence_checker.h"
@@ -21,6 +22,7 @@
 #include "http/h/http_protocal.h"
 #include "http/http_stack.h"
 #include "http/http_consts.h"
+#include "common/media_performance.h"
 
 namespace ma {
 
@@ -28,8 +30,12 @@ class HttpRequestReader;
 class HttpResponseWriterProxy;
 class HttpResponseReader;
 class MessageChain;
+class DataBlock;
+class HttpWriteSubmitRing;
+class HttpWriteUringBatch;
 
 class AsyncSokcetWrapper : public sigslot::has_slots<>, 
+    public rtc::MessageHandler,
     public std::enable_shared_from_this<AsyncSokcetWrapper> {
  public:
   AsyncSokcetWrapper(rtc::AsyncPacketSocket*);
@@ -37,14 +43,20 @@ class AsyncSokcetWrapper : public sigslot::has_slots<>,
 
   void Open(bool, rtc::Thread*);
   void Close();
+  // Close actively, notify the reader as closed by peer.
+  void Disconnect();
   
   void SetReqReader(std::weak_ptr<HttpRequestReader> r) {
     req_reader_ = std::move(r);
   }
   
-  void SetWriter(std::weak_ptr<HttpResponseWriterProxy> w) {
-    writer_ = std::move(w);
-  }
+  // The writers of the responses in order of the requests, only the first
+  // one writes to the socket, returns whether it is the first.
+  bool AddWriter(std::weak_ptr<HttpResponseWriterProxy> w);
+  // Keep the writer finished until the bytes buffered are sent.
+  void KeepWriter(std::shared_ptr<HttpResponseWriterProxy> w);
+  // The first response is sent or gone, hand over to the next one.
+  void NextWriter();
 
   void SetResReader(std::weak_ptr<HttpResponseReader> r) {
     res_reader_ = std::move(r);
@@ -53,6 +65,15 @@ class AsyncSokcetWrapper : public sigslot::has_slots<>,
   //adaptor function
   //srs_error_t Write(const char* data, int size, int* sent);
   srs_error_t Write(MessageChain* data, int* sent);
+  // Send the buffers of the caller directly, nothing is kept.
+  srs_error_t Writev(const iovec* iov, int iovcnt, int* sent);
+  // Send the file range by sendfile, read and sent by user space for https.
+  srs_error_t SendFile(int fd, int64_t offset, int64_t size, int64_t* sent);
+
+  // Whether wait for OnWriteEvent to write again.
+  bool Blocked() const {
+    return blocked_;
+  }
 
   void OnReadEvent(rtc::AsyncPacketSocket*,
                    const char*,
@@ -65,26 +86,50 @@ class AsyncSokcetWrapper : public sigslot::has_slots<>,
   
   void OnWriteEvent(rtc::AsyncPacketSocket* socket);
 
+  // The idle timer.
+  void OnMessage(rtc::Message*) override;
+
   inline rtc::Thread* GetThread() {
     return thread_;
   }
 
   std::string Ip();
+
+  // The descriptor to send the bytes directly, such as by io_uring, -1 if
+  // closed, blocked, or the bytes must pass the socket like TLS.
+  int SendDescriptor();
+
+  // The send system calls issued in total.
+  int64_t SendCalls() const {
+    return send_calls_;
+  }
  private:
-  srs_error_t Write_i(const char* c_data, int c_size, int* sent);
+  friend class HttpWriteUringBatch;
+
+  srs_error_t Writev_i(const iovec* iov, int iovcnt, uint32_t len, int* sent);
  private:
   rtc::Thread* thread_{nullptr};
   std::unique_ptr<rtc::AsyncPacketSocket> conn_;
   bool close_{false};
 
   std::weak_ptr<HttpRequestReader> req_reader_;
-  std::weak_ptr<HttpResponseWriterProxy> writer_;
+  struct PendingWriter {
+    std::weak_ptr<HttpResponseWriterProxy> writer;
+    // Set when the response is finished and not sent out.
+    std::shared_ptr<HttpResponseWriterProxy> flushing;
+  };
+  std::deque<PendingWriter> writers_;
   std::weak_ptr<HttpResponseReader> res_reader_;
   bool server_{true};
   bool blocked_{false};
+  int64_t last_read_ms_{0};
+  std::atomic<int64_t> send_calls_{0};
   webrtc::SequenceChecker thread_check_;
 
-  static constexpr int kMaxPacketSize = MA_MAX_PACKET_SIZE;
+  static constexpr int kMaxIovecs = SRS_PERF_WRITEV_IOVS;
+  // The max bytes of one sendfile, fit in the int returned.
+  static constexpr int64_t kMaxSendFile = 1 << 30;
+  static constexpr int kIdleTimeoutMs = SRS_PERF_HTTP_KEEPALIVE_IDLE_MS;
 };
 
 /* Callbacks should return non-zero to indicate an error. The parser will
@@ -155,13 +200,18 @@ class HttpMessageParser final  : public IHttpMessageParser {
   // Whether allow jsonp parse.
   bool jsonp_;
 
-  std::string field_name_;
-  std::string field_value_;
+  // The header is parsed when it's completely received, so the url and 
+  // fields are sliced from buffer_ and never split, valid until the 
+  // message is created.
+  std::string_view field_name_;
+  std::string_view field_value_;
   SrsHttpParseState state_{SrsHttpParseStateInit};
   http_parser hp_header_;
-  std::string url_;
-  std::unique_ptr<SrsHttpHeader> header_;
+  std::string_view url_;
+  std::vector<std::pair<std::string_view, std::string_view>> fields_;
   enum http_parser_type type_{HTTP_REQUEST};
+  // Refuse the header never completed.
+  static constexpr size_t kMaxHeaderSize = 64 * 1024;
 
   // Point to the start of body.
   const char* p_body_start_{nullptr};
@@ -206,6 +256,12 @@ class HttpResponseWriter final {
   srs_error_t write(MessageChain*, MessageChain*&);
   void write_header(int code);
 
+  // The http header and chunk header before the body of size, and whether 
+  // the chunk trailer is required after it.
+  srs_error_t frame(int size, bool body, MessageChain*& head, bool& trailer);
+  // The chunk trailer.
+  static MessageChain* crlf();
+
  private:
   MessageChain* send_header(const char* data, int size);
  private:
@@ -253,15 +309,72 @@ class HttpResponseWriterProxy : public IHttpResponseWriter,
 
   srs_error_t writev(const iovec* iov, int iovcnt, ssize_t* pnwrite) override;
 
+  srs_error_t sendfile(
+      int fd, int64_t offset, int64_t size, int64_t* psent) override;
+
   void write_header(int code) override;
 
+  int64_t queued_bytes() override {
+    return queued_bytes_;
+  }
+
+  int64_t sent_bytes() override {
+    return sent_bytes_;
+  }
+
+  int64_t send_calls() override {
+    return socket_->SendCalls();
+  }
+
+  int64_t high_watermark_ms() override;
+
+  void disconnect() override;
+
   void OnWriteEvent();
+
+  // The responses before on the connection are sent, write to socket.
+  void activate();
+
+  // Finished and sent out, the socket is handed over to the next response.
+  bool done() const {
+    return handed_over_;
+  }
  private:
+  friend class HttpWriteSubmitRing;
+  friend class HttpWriteUringBatch;
+
   srs_error_t send_header();
 
+  // The socket is blocked, or too many bytes queued by the asynchronous 
+  // writes, wait for SignalOnWrite_ to write again.
+  bool blocked();
+
   srs_error_t write_i(MessageChain*, ssize_t*);
+
+  // post the chain owned to io thread.
+  void write_owned(MessageChain* owned, uint32_t data_len);
+
+  // send the iovecs by one writev in io thread, copy the bytes not sent.
+  void writev_borrowed(const iovec* iov, int iovcnt, uint32_t size);
+
+  // copy the iovecs to one block, skip the bytes at beginning.
+  static std::shared_ptr<DataBlock> gather(
+      const iovec* iov, int iovcnt, uint32_t skip, uint32_t size);
+
+  // write the chain duplicated by other thread, in io thread.
+  void write_async_i(MessageChain* duplicated, uint32_t data_len);
  
   srs_error_t write2sock(MessageChain*);
+
+  // the bytes deferred by the batch are |sent|, the rest by the socket.
+  void flush_deferred(int sent);
+
+  // wake up the blocked writer if the queued bytes below the low watermark.
+  void drained();
+
+  // hand over the socket if finished and nothing buffered, or close it if
+  // the client asks.
+  void check_done();
   
   srs_error_t final_request_i();  
   
@@ -280,6 +393,23 @@ class HttpResponseWriterProxy : public IHttpResponseWriter,
   
   std::atomic<bool> buffer_full_{false};
 
+  // The responses before on the connection are not finished, the bytes are
+  // buffered to keep the order of the pipelined requests.
+  bool held_{false};
+  bool finished_{false};
+  bool handed_over_{false};
+
+  // The bytes accepted and not sent, bounded by kMaxQueuedBytes.
+  std::atomic<int64_t> queued_bytes_{0};
+  std::atomic<int64_t> sent_bytes_{0};
+  // Signal the writer when the queued bytes drain below kLowQueuedBytes.
+  std::atomic<bool> wait_drain_{false};
+  // When the queued bytes reach the high watermark, 0 if below it.
+  std::atomic<int64_t> high_since_{0};
+  std::atomic<int64_t> high_ms_{0};
+  static constexpr int64_t kMaxQueuedBytes = SRS_PERF_WRITER_QUEUED_BYTES;
+  static constexpr int64_t kLowQueuedBytes = SRS_PERF_WRITER_LOW_BYTES;
+
   std::shared_ptr<AsyncSokcetWrapper> socket_;
   webrtc::SequenceChecker thread_check_;
 };
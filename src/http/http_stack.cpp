@@ -8,6 +8,8 @@
 #include <netdb.h>
 #include <math.h>
 #include <stdlib.h>
+#include <strings.h>
+#include <atomic>
 #include <map>
 #include <sstream>
 #include <memory>
@@ -15,6 +17,7 @@
 
 #include "common/media_define.h"
 #include "common/media_log.h"
+#include "common/media_performance.h"
 #include "http/http_consts.h"
 #include "common/media_kernel_error.h"
 #include "utils/media_protocol_utility.h"
@@ -752,6 +755,11 @@ http_parser_parse_url(const char *buf, size_t buflen, int is_connect,
 
 srs_error_t SrsHttpUri::initialize(std::string _url) {
     schema = host = path = query = "";
+    // the uri of the reused message.
+    port = 0;
+    username_.clear();
+    password_.clear();
+    query_values_.clear();
 
     url = _url;
     const char* purl = url.c_str();
@@ -1185,56 +1193,87 @@ srs_error_t SrsHttpUri::path_unescape(std::string s, std::string& value)
 
 ///////////////////////////////
 //SrsHttpHeader
+static bool srs_http_key_equals(std::string_view a, std::string_view b) {
+  return a.length() == b.length() && 
+         strncasecmp(a.data(), b.data(), a.length()) == 0;
+}
+
 void SrsHttpHeader::set(const string& key, const string& value) {
+  for (size_t i = 0; i < count_; ++i) {
+    if (srs_http_key_equals(headers[i].first, key)) {
+      headers[i].second = value;
+      return;
+    }
+  }
+
+  add(key, value);
+
   // Convert to UpperCamelCase, for example:
   //      transfer-encoding
   // transform to:
   //      Transfer-Encoding
+  std::string& k = headers[count_ - 1].first;
   char pchar = 0;
-  for (int i = 0; i < (int)key.length(); i++) {
-      char ch = key.at(i);
+  for (int i = 0; i < (int)k.length(); i++) {
+      char ch = k[i];
 
       if (i == 0 || pchar == '-') {
           if (ch >= 'a' && ch <= 'z') {
-              ((char*)key.data())[i] = ch - 32;
+              k[i] = ch - 32;
           }
       }
       pchar = ch;
   }
-
-  headers[key] = value;
 }
 
-string SrsHttpHeader::get(const string& key) const {
-  std::string v;
+void SrsHttpHeader::add(std::string_view key, std::string_view value) {
+  if (count_ == headers.size()) {
+    headers.emplace_back();
+  }
+  auto& field = headers[count_++];
+  field.first.assign(key.data(), key.length());
+  field.second.assign(value.data(), value.length());
+}
 
-  auto it = headers.find(key);
-  if (it != headers.end()) {
-      v = it->second;
+std::string_view SrsHttpHeader::find(std::string_view key) const {
+  for (size_t i = 0; i < count_; ++i) {
+    if (srs_http_key_equals(headers[i].first, key)) {
+      return headers[i].second;
+    }
   }
-  
-  return v;
+  return {};
+}
+
+string SrsHttpHeader::get(const string& key) const {
+  return std::string(find(key));
 }
 
 void SrsHttpHeader::del(const string& key) {
-  map<string, string>::iterator it = headers.find(key);
-  if (it != headers.end()) {
-    headers.erase(it);
+  for (size_t i = 0; i < count_; ++i) {
+    if (!srs_http_key_equals(headers[i].first, key)) {
+      continue;
+    }
+    // keep the order, the removed one is reused.
+    for (size_t j = i + 1; j < count_; ++j) {
+      std::swap(headers[j - 1], headers[j]);
+    }
+    --count_;
+    return;
   }
 }
 
 int SrsHttpHeader::count() {
-   return (int)headers.size();
+   return (int)count_;
 }
 
 int64_t SrsHttpHeader::content_length() {
-  std::string cl = get("Content-Length");
+  std::string_view cl = find("Content-Length");
   
   if (cl.empty()) {
       return -1;
   }
   
-  return (int64_t)::atof(cl.c_str());
+  return (int64_t)::atof(std::string(cl).c_str());
 }
 
 void SrsHttpHeader::set_content_length(int64_t size) {
@@ -1250,16 +1289,11 @@ void SrsHttpHeader::set_content_type(const std::string& ct) {
 }
 
 void SrsHttpHeader::write(std::stringstream& ss) {
-  std::map<std::string, std::string>::iterator it;
-  for (it = headers.begin(); it != headers.end(); ++it) {
-      ss << it->first << ": " << it->second << SRS_HTTP_CRLF;
+  for (size_t i = 0; i < count_; ++i) {
+      ss << headers[i].first << ": " << headers[i].second << SRS_HTTP_CRLF;
   }
 }
 
-const std::map<std::string, std::string>&SrsHttpHeader::header() {
-  return headers;
-}
-
 // get the status text of code.
 std::string_view generate_http_status_text(int status) {
   static std::string UNKNOW_STATUS = "Status Unknown";
@@ -1324,6 +1358,134 @@ HttpMessage::HttpMessage(std::string_view body)
 {
 }
 
+// The messages created by a thread. Released by the thread, they are
+// kept in |local|, by the others, pushed to |remote| and taken back by the
+// thread when |local| runs out.
+struct HttpMessagePool {
+  // by the owner thread only.
+  std::vector<HttpMessage*> local;
+  // released by the other threads, linked by pool_next_.
+  std::atomic<HttpMessage*> remote{nullptr};
+  // the thread exited, the messages released later are deleted.
+  std::atomic<bool> orphaned{false};
+
+  static void freeList(HttpMessage* msg) {
+    while (msg) {
+      HttpMessage* next = msg->pool_next_;
+      delete msg;
+      msg = next;
+    }
+  }
+};
+
+namespace {
+
+thread_local HttpMessagePool* t_message_pool = nullptr;
+thread_local bool t_message_pool_exited = false;
+
+// The pool is kept after the thread exits, the messages out still point to
+// it, only the ones pooled are deleted.
+struct HttpMessagePoolHolder {
+  ~HttpMessagePoolHolder() {
+    HttpMessagePool* pool = t_message_pool;
+    t_message_pool = nullptr;
+    t_message_pool_exited = true;
+    for (auto msg : pool->local) {
+      delete msg;
+    }
+    pool->local.clear();
+    // seq_cst with the check of recycle, a message pushed after the drain
+    // is deleted by its pusher.
+    pool->orphaned.store(true);
+    HttpMessagePool::freeList(pool->remote.exchange(nullptr));
+  }
+};
+
+HttpMessagePool* currentMessagePool() {
+  if (!t_message_pool && !t_message_pool_exited) {
+    static thread_local HttpMessagePoolHolder holder;
+    t_message_pool = new HttpMessagePool;
+  }
+  return t_message_pool;
+}
+
+}
+
+std::shared_ptr<HttpMessage> HttpMessage::Create(std::string_view body) {
+  HttpMessagePool* pool = currentMessagePool();
+  HttpMessage* msg = nullptr;
+  if (pool && pool->local.empty()) {
+    // take back the ones released by the others.
+    HttpMessage* head = pool->remote.exchange(nullptr, std::memory_order_acquire);
+    while (head) {
+      pool->local.push_back(head);
+      head = head->pool_next_;
+    }
+  }
+
+  if (!pool || pool->local.empty()) {
+    msg = new HttpMessage(body);
+    msg->pool_ = pool;
+  } else {
+    msg = pool->local.back();
+    pool->local.pop_back();
+    msg->reset(body);
+  }
+  return std::shared_ptr<HttpMessage>(msg, HttpMessage::recycle);
+}
+
+void HttpMessage::recycle(HttpMessage* msg) {
+  HttpMessagePool* pool = msg->pool_;
+  if (!pool || (pool == t_message_pool &&
+      pool->local.size() >= (size_t)SRS_PERF_HTTP_MESSAGE_POOL)) {
+    delete msg;
+    return;
+  }
+
+  // drop the references now, not when reused.
+  msg->owner_.reset();
+  msg->SignalOnBody_.disconnect_all();
+
+  if (pool == t_message_pool) {
+    pool->local.push_back(msg);
+    return;
+  }
+
+  // released by the other thread, given back to the one created it.
+  if (pool->orphaned.load()) {
+    delete msg;
+    return;
+  }
+  HttpMessage* head = pool->remote.load(std::memory_order_relaxed);
+  do {
+    msg->pool_next_ = head;
+  } while (!pool->remote.compare_exchange_weak(head, msg));
+
+  // the thread exited meanwhile and may have drained before the push.
+  if (pool->orphaned.load()) {
+    HttpMessagePool::freeList(pool->remote.exchange(nullptr));
+  }
+}
+
+void HttpMessage::reset(std::string_view body) {
+  type_ = 0;
+  method_ = 0;
+  status_ = SRS_CONSTS_HTTP_OK;
+  content_length_ = -1;
+  body_recv_length_ = 0;
+  body_.assign(body.data(), body.length());
+  body_eof_ = false;
+  header_.clear();
+  keep_alive_ = true;
+  chunked_ = false;
+  schema_ = "http";
+  url_.clear();
+  ext_.clear();
+  _query.clear();
+  jsonp = false;
+  jsonp_method_.clear();
+}
+
 void HttpMessage::set_basic(
   uint8_t type, uint8_t method, uint16_t status, int64_t content_length)
 {
@@ -1335,18 +1497,23 @@ void HttpMessage::set_basic(
   }
 }
 
-void HttpMessage::set_header(const SrsHttpHeader& header, bool keep_alive)
+void HttpMessage::set_header(
+    const std::vector<std::pair<std::string_view, std::string_view>>& fields, 
+    bool keep_alive)
 {
-  header_ = header;
+  header_.clear();
+  for (auto& field : fields) {
+    header_.add(field.first, field.second);
+  }
   keep_alive_ = keep_alive;
 
   // whether chunked.
-  chunked_ = (header.get("Transfer-Encoding") == "chunked");
+  chunked_ = (header_.find("Transfer-Encoding") == "chunked");
 
   // Update the content-length in header.
-  std::string clv = header.get("Content-Length");
+  std::string_view clv = header_.find("Content-Length");
   if (!clv.empty()) {
-    content_length_ = ::atoll(clv.c_str());
+    content_length_ = ::atoll(std::string(clv).c_str());
   }
 }
 
@@ -1362,10 +1529,10 @@ bool srs_string_contains(const std::string& str, const std::string& flag) {
   return str.find(flag) != std::string::npos;
 }
 
-srs_error_t HttpMessage::set_url(const std::string& url, bool allow_jsonp) {
+srs_error_t HttpMessage::set_url(std::string_view url, bool allow_jsonp) {
   srs_error_t err = srs_success;
   
-  url_ = url;
+  url_.assign(url.data(), url.length());
 
   // parse uri from schema/server:port/path?query
   std::string uri = url_;
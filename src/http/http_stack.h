@@ -12,7 +12,9 @@
 
 #include <map>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <vector>
 
 #include "http/h/http_message.h"
 #include "http/h/http_protocal.h"
@@ -63,15 +65,27 @@ public:
   static srs_error_t path_unescape(std::string s, std::string& value);
 };
 
+struct HttpMessagePool;
+
 class HttpMessage final : public ISrsHttpMessage {
  public:
   HttpMessage(std::string_view body);
   ~HttpMessage() = default;
 
+  // Reuse a message of the pool of current thread. A message goes back to
+  // the pool of the thread created it wherever it's released, kept up to
+  // SRS_PERF_HTTP_MESSAGE_POOL when released by that thread, and deleted
+  // if that thread exited.
+  static std::shared_ptr<HttpMessage> Create(std::string_view body);
+
   void set_basic(uint8_t type, uint8_t method, 
       uint16_t status, int64_t content_length);
-  void set_header(const SrsHttpHeader&, bool keep_alive);
-  srs_error_t set_url(const std::string& url, bool allow_jsonp);
+  // The fields are sliced from the receive buffer, and copied to the
+  // strings of the message, not kept as slices.
+  void set_header(
+      const std::vector<std::pair<std::string_view, std::string_view>>&,
+      bool keep_alive);
+  srs_error_t set_url(std::string_view url, bool allow_jsonp);
   void set_https(bool v);
 
   std::shared_ptr<IMediaConnection> connection() override;
@@ -129,6 +143,11 @@ public:
   
  private:
   uint8_t method_i();
+  // Clear the message to reuse, the capacity of the strings is kept.
+  void reset(std::string_view body);
+  static void recycle(HttpMessage*);
+
+  friend struct HttpMessagePool;
  private:  
   // The request type defined as
   //      enum http_parser_type { HTTP_REQUEST, HTTP_RESPONSE, HTTP_BOTH };
@@ -167,6 +186,11 @@ public:
   std::string jsonp_method_;
 
   std::shared_ptr<IMediaConnection> owner_;
+
+  // The pool of the thread created it, given back to there.
+  HttpMessagePool* pool_{nullptr};
+  // Linked in the list released by the other threads.
+  HttpMessage* pool_next_{nullptr};
 };
 
 /* Compile with -DHTTP_PARSER_STRICT=0 to make less checks, but run
@@ -13,6 +13,7 @@
 #include "common/media_message.h"
 #include "encoder/media_codec.h"
 #include "live/media_live_source.h"
+#include "live/media_gop_cache.h"
 
 namespace ma {
 
@@ -22,8 +23,12 @@ static log4cxx::LoggerPtr logger = log4cxx::Logger::getLogger("ma.live");
 #define CONST_MAX_JITTER_MS_NEG         -250
 #define DEFAULT_FRAME_TIME_MS         10
 
+// The initial slots of the ring, about 2s of video and audio.
+#define MESSAGE_QUEUE_INIT_CAPACITY 128
+
 MessageQueue::MessageQueue(bool ignore_shrink) {
   _ignore_shrink = ignore_shrink;
+  ring_.resize(MESSAGE_QUEUE_INIT_CAPACITY);
 }
 
 MessageQueue::~MessageQueue() {
@@ -31,7 +36,7 @@ MessageQueue::~MessageQueue() {
 }
 
 int MessageQueue::size() {
-  return (int)msgs.size();
+  return (int)(tail_ - head_);
 }
 
 srs_utime_t MessageQueue::duration() {
@@ -42,17 +47,66 @@ void MessageQueue::set_queue_size(srs_utime_t queue_size) {
 	max_queue_size = queue_size;
 }
 
-void MessageQueue::enqueue(std::shared_ptr<MediaMessage> msg, bool* is_overflow) {
+MediaPacket& MessageQueue::at(uint64_t seq) {
+  return ring_[seq & (ring_.size() - 1)];
+}
+
+void MessageQueue::push_back(MediaPacket pkt) {
+  if (tail_ - head_ == ring_.size()) {
+    grow();
+  }
+  at(tail_++) = std::move(pkt);
+}
+
+void MessageQueue::push_front(MediaPacket pkt) {
+  if (tail_ - head_ == ring_.size()) {
+    grow();
+  }
+  at(--head_) = std::move(pkt);
+}
+
+MediaPacket MessageQueue::pop_front() {
+  MediaPacket pkt = std::move(at(head_++));
+  if (!keyframes_.empty() && keyframes_.front() < head_) {
+    keyframes_.pop_front();
+  }
+  return pkt;
+}
+
+void MessageQueue::grow() {
+  std::vector<MediaPacket> ring(ring_.size() * 2);
+  for (uint64_t seq = head_; seq < tail_; ++seq) {
+    ring[seq & (ring.size() - 1)] = std::move(at(seq));
+  }
+  ring_.swap(ring);
+}
+
+void MessageQueue::enqueue(MediaPacket pkt, bool* is_overflow) {
+  MediaMessage* msg = pkt.msg_.get();
 
   if (msg->is_av()) {
     if (av_start_time == -1) {
-      av_start_time = srs_utime_t(msg->timestamp_ * SRS_UTIME_MILLISECONDS);
+      av_start_time = srs_utime_t(pkt.timestamp_ * SRS_UTIME_MILLISECONDS);
     }
     
-    av_end_time = srs_utime_t(msg->timestamp_ * SRS_UTIME_MILLISECONDS);
+    av_end_time = srs_utime_t(pkt.timestamp_ * SRS_UTIME_MILLISECONDS);
+  }
+
+  // index the sequence headers and keyframes.
+  if (msg->is_video()) {
+    const char* data = msg->payload_->GetFirstMsgReadPtr();
+    int size = msg->payload_->GetFirstMsgLength();
+    if (SrsFlvVideo::sh(data, size)) {
+      video_sh_ = tail_;
+    } else if (SrsFlvVideo::keyframe(data, size)) {
+      keyframes_.push_back(tail_);
+    }
+  } else if (msg->is_audio() && SrsFlvAudio::sh(
+      msg->payload_->GetFirstMsgReadPtr(), msg->payload_->GetFirstMsgLength())) {
+    audio_sh_ = tail_;
   }
   
-  msgs.emplace_back(std::move(msg));
+  push_back(std::move(pkt));
 
   //MLOG_CTRACE("start:%lld, end:%lld, diff:%lld", av_start_time, av_end_time, av_end_time-av_start_time);
   while (av_end_time - av_start_time > max_queue_size) {
@@ -66,8 +120,8 @@ void MessageQueue::enqueue(std::shared_ptr<MediaMessage> msg, bool* is_overflow)
 }
 
 void MessageQueue::fetch_packets(int max_count, 
-    std::vector<std::shared_ptr<MediaMessage>>& pmsgs, int& count) {
-  int nb_msgs = (int)msgs.size();
+    std::vector<MediaPacket>& pmsgs, int& count) {
+  int nb_msgs = size();
   if (nb_msgs <= 0) {
     return;
   }
@@ -76,81 +130,85 @@ void MessageQueue::fetch_packets(int max_count,
   count = std::min(max_count, nb_msgs);
   
   for (int i = 0; i < count; i++) {
-    pmsgs.push_back(msgs[i]);
+    pmsgs.push_back(pop_front());
   }
   
-  std::shared_ptr<MediaMessage> last = msgs[count - 1];
-  av_start_time = srs_utime_t(last->timestamp_ * SRS_UTIME_MILLISECONDS);
-  
-  if (count >= nb_msgs) {
-    // the pmsgs is big enough and clear msgs at most time.
-    msgs.clear();
-  } else {
-    // erase some vector elements may cause memory copy,
-    // maybe can use more efficient vector.swap to avoid copy.
-    // @remark for the pmsgs is big enough, for instance, SRS_PERF_MW_MSGS 128,
-    //      the rtmp play client will get 128msgs once, so this branch rarely execute.
-    msgs.erase(msgs.begin(), msgs.begin() + count);
-  }
+  av_start_time = srs_utime_t(pmsgs.back().timestamp_ * SRS_UTIME_MILLISECONDS);
 }
 
 void MessageQueue::fetch_packets(
     MediaConsumer* consumer, JitterAlgorithm ag) {
-
-  int nb_msgs = (int)msgs.size();
-  if (nb_msgs <= 0) {
-    return;
-  }
-  
-  for (int i = 0; i < nb_msgs; i++) {
-    std::shared_ptr<MediaMessage> msg = msgs[i];
-    consumer->enqueue(msg, ag);
+  for (uint64_t seq = head_; seq < tail_; ++seq) {
+    consumer->enqueue(at(seq).msg_, ag);
   }
 }
 
 void MessageQueue::shrink() {
-  std::shared_ptr<MediaMessage> video_sh;
-  std::shared_ptr<MediaMessage> audio_sh;
-  int msgs_size = (int)msgs.size();
-  
-  // remove all msg
-  // igone the sequence header
-  for (size_t i = 0; i < msgs.size(); i++) {
-    auto& msg = msgs.at(i);
-    
-    if (msg->is_video() && SrsFlvVideo::sh(
-        msg->payload_->GetFirstMsgReadPtr(), msg->payload_->GetFirstMsgLength())) {
-      video_sh = msg;
-      continue;
-    }
-    else if (msg->is_audio() && SrsFlvAudio::sh(
-        msg->payload_->GetFirstMsgReadPtr(), msg->payload_->GetFirstMsgLength())) {
-      audio_sh = msg;
-      continue;
+  int msgs_size = size();
+
+  // the sequence headers kept in front by the last shrink.
+  uint64_t first = head_;
+  while (first < tail_ && 
+      ((int64_t)first == video_sh_ || (int64_t)first == audio_sh_)) {
+    ++first;
+  }
+
+  // the next keyframe, skip the first message to drop one gop at least.
+  uint64_t next = tail_;
+  for (auto seq : keyframes_) {
+    if (seq > first) {
+      next = seq;
+      break;
     }
   }
-  msgs.clear();
-  
+
+  // the sequence headers to be dropped.
+  MediaPacket video_sh;
+  MediaPacket audio_sh;
+  if (video_sh_ >= (int64_t)head_ && video_sh_ < (int64_t)next) {
+    video_sh = at(video_sh_);
+  }
+  if (audio_sh_ >= (int64_t)head_ && audio_sh_ < (int64_t)next) {
+    audio_sh = at(audio_sh_);
+  }
+
+  // remove all msg before the keyframe
+  while (head_ < next) {
+    pop_front();
+  }
+
   // update av_start_time
-  av_start_time = av_end_time;
-  //push_back secquence header and update timestamp
-  if (video_sh) {
-    video_sh->timestamp_ = srsu2ms(av_end_time);
-    msgs.emplace_back(std::move(video_sh));
+  if (next == tail_) {
+    av_start_time = av_end_time;
+  } else {
+    av_start_time = srs_utime_t(at(next).timestamp_ * SRS_UTIME_MILLISECONDS);
+  }
+
+  //push_front secquence header and update timestamp,
+  //the message is shared by other consumers, only the packet is updated.
+  if (audio_sh.msg_) {
+    audio_sh.timestamp_ = srsu2ms(av_start_time);
+    push_front(std::move(audio_sh));
+    audio_sh_ = head_;
   }
-  if (audio_sh) {
-    audio_sh->timestamp_ = srsu2ms(av_end_time);
-    msgs.emplace_back(std::move(audio_sh));
+  if (video_sh.msg_) {
+    video_sh.timestamp_ = srsu2ms(av_start_time);
+    push_front(std::move(video_sh));
+    video_sh_ = head_;
   }
   
   if (!_ignore_shrink) {
     MLOG_CTRACE("shrinking, size=%d, removed=%d, max=%dms", 
-      (int)msgs.size(), msgs_size - (int)msgs.size(), srsu2msi(max_queue_size));
+      size(), msgs_size - size(), srsu2msi(max_queue_size));
   }
 }
 
 void MessageQueue::clear() {
-  msgs.clear();
+  while (head_ < tail_) {
+    pop_front();
+  }
+  keyframes_.clear();
+  video_sh_ = audio_sh_ = -1;
   
   av_start_time = av_end_time = -1;
 }
@@ -158,13 +216,13 @@ void MessageQueue::clear() {
 //MediaJitter
 MediaConsumer::MediaJitter::MediaJitter() = default;
 
-void MediaConsumer::MediaJitter::correct(
-    std::shared_ptr<MediaMessage> msg, JitterAlgorithm ag) {
+int64_t MediaConsumer::MediaJitter::correct(
+    MediaMessage* msg, JitterAlgorithm ag) {
   // for performance issue
   if (JitterAlgorithmFULL != ag) {
     // all jitter correct features is disabled, ignore.
     if (JitterAlgorithmOFF == ag) {
-      return ;
+      return msg->timestamp_;
     }
     
     // start at zero, but donot ensure monotonically increasing.
@@ -172,19 +230,17 @@ void MediaConsumer::MediaJitter::correct(
       if (last_pkt_correct_time == -1) {
         last_pkt_correct_time = msg->timestamp_;
       }
-      msg->timestamp_ -= last_pkt_correct_time;
-      return ;
+      return msg->timestamp_ - last_pkt_correct_time;
     }
     
     // other algorithm, ignore.
-    return ;
+    return msg->timestamp_;
   }
 
   // full jitter algorithm, do jitter correct.
   // set to 0 for metadata.
   if (!msg->is_av()) {
-    msg->timestamp_ = 0;
-    return ;
+    return 0;
   }
   
   /**
@@ -208,9 +264,9 @@ void MediaConsumer::MediaJitter::correct(
   }
   
   last_pkt_correct_time = std::max<int64_t>(0, last_pkt_correct_time + delta);
-
-  msg->timestamp_ = last_pkt_correct_time;
   last_pkt_time = time;
+
+  return last_pkt_correct_time;
 }
 
 int64_t MediaConsumer::MediaJitter::get_time() {
@@ -230,21 +286,115 @@ void MediaConsumer::set_queue_size(srs_utime_t queue_size) {
   queue_.set_queue_size(queue_size);
 }
 
+void MediaConsumer::set_sink(MediaConsumerSink* sink, int batch_size) {
+  sink_ = sink;
+  batch_size_ = batch_size;
+}
+
+void MediaConsumer::set_cursor(std::shared_ptr<SrsGopCache> cache, 
+                               uint64_t seq, JitterAlgorithm ag) {
+  if (seq >= cache->tail()) {
+    return;
+  }
+  cache_ = std::move(cache);
+  cursor_ = seq;
+  cursor_ag_ = ag;
+  pre_cursor_ = queue_.size();
+
+  auto msg = cache_->at(seq);
+  last_enqueued_time_ = cache_->newest()->timestamp_;
+  last_fetched_time_ = msg->timestamp_;
+  start_lag_ = last_enqueued_time_ - last_fetched_time_;
+}
+
 int64_t MediaConsumer::get_time() {
   return jitter_.get_time();
 }
 
 void MediaConsumer::enqueue(std::shared_ptr<MediaMessage> msg, 
                             JitterAlgorithm jitter_algo) {
-  auto cp_msg = msg->Copy();
-  
-  jitter_.correct(cp_msg, jitter_algo);
+  if (msg->is_av()) {
+    last_enqueued_time_ = msg->timestamp_;
+  }
+
+  // the msg is cached already, read it by the cursor later.
+  if (cache_ && cache_->newest() == msg.get()) {
+    notify(pending());
+    return;
+  }
+
+  // not cached, fetched by the cursor in order with the cached ones.
+  if (cache_) {
+    uncached_.push_back({cache_->tail(), std::move(msg), jitter_algo});
+    notify(pending());
+    return;
+  }
+
+  // the msg is shared with the other consumers, never copy it,
+  // only the corrected timestamp belongs to this consumer.
+  int64_t timestamp = jitter_.correct(msg.get(), jitter_algo);
 
-  queue_.enqueue(cp_msg, nullptr);
+  queue_.enqueue({std::move(msg), timestamp}, nullptr);
+
+  notify(pending());
+}
+
+int MediaConsumer::pending() {
+  int size = queue_.size();
+  if (cache_) {
+    size += (int)(cache_->tail() - std::max(cursor_, cache_->head()));
+    size += (int)uncached_.size();
+  }
+  return size;
+}
+
+void MediaConsumer::notify(int size) {
+  if (!sink_ || paused_) {
+    return;
+  }
+
+  if (size == 1) {
+    sink_->OnConsumerReady(this, false);
+  } else if (size == batch_size_) {
+    sink_->OnConsumerReady(this, true);
+  }
+}
+
+void MediaConsumer::fetch_cursor(int max, 
+    std::vector<MediaPacket>& msgs, int& count) {
+  // the cache dropped the gops not read yet, skip to the oldest keyframe.
+  if (cursor_ < cache_->head()) {
+    cursor_ = cache_->head();
+  }
+
+  while (count < max) {
+    // the ones not cached before the message at the cursor.
+    if (!uncached_.empty() && uncached_.front().seq <= cursor_) {
+      auto& front = uncached_.front();
+      int64_t timestamp = jitter_.correct(front.msg.get(), front.ag);
+      msgs.push_back({std::move(front.msg), timestamp});
+      uncached_.pop_front();
+      ++count;
+      continue;
+    }
+
+    if (cursor_ >= cache_->tail()) {
+      break;
+    }
+    auto msg = cache_->at(cursor_++);
+    int64_t timestamp = jitter_.correct(msg.get(), cursor_ag_);
+    msgs.push_back({std::move(msg), timestamp});
+    ++count;
+  }
+
+  // catch up with the live, queue the following messages.
+  if (cursor_ >= cache_->tail() && uncached_.empty()) {
+    cache_.reset();
+  }
 }
 
 void MediaConsumer::fetch_packets(int get_max,
-    std::vector<std::shared_ptr<MediaMessage>>& msgs, int& count) {
+    std::vector<MediaPacket>& msgs, int& count) {
   assert(count >= 0);
   assert(get_max > 0);
   
@@ -259,13 +409,127 @@ void MediaConsumer::fetch_packets(int get_max,
   if (paused_) {
     return;
   }
-  
-  queue_.fetch_packets(max, msgs, count);
+
+  size_t begin = msgs.size();
+  do {
+    int nb = 0;
+    fetch_i(max, msgs, nb);
+    if (nb == 0) {
+      break;
+    }
+
+    for (size_t i = begin; i < msgs.size(); ++i) {
+      if (msgs[i].msg_->is_av()) {
+        last_fetched_time_ = msgs[i].msg_->timestamp_;
+      }
+    }
+
+    if (drop_level_ == ConsumerDropNone && !wait_keyframe_) {
+      break;
+    }
+
+    // drop the frames in place, fetch again if all dropped.
+    size_t keep = begin;
+    for (size_t i = begin; i < msgs.size(); ++i) {
+      if (should_drop(msgs[i].msg_.get())) {
+        continue;
+      }
+      if (keep != i) {
+        msgs[keep] = std::move(msgs[i]);
+      }
+      ++keep;
+    }
+    msgs.resize(keep);
+  } while (msgs.size() == begin);
+
+  count = (int)(msgs.size() - begin);
+}
+
+void MediaConsumer::fetch_i(int max, 
+    std::vector<MediaPacket>& msgs, int& count) {
+  if (!cache_) {
+    queue_.fetch_packets(max, msgs, count);
+    return;
+  }
+
+  // the metadata and sequence headers queued before the cursor.
+  int nb_pre = std::min(pre_cursor_, queue_.size());
+  if (nb_pre > 0) {
+    queue_.fetch_packets(std::min(max, nb_pre), msgs, count);
+  }
+  pre_cursor_ = nb_pre - count;
+
+  fetch_cursor(max, msgs, count);
+
+  // the messages not cached, in queue after the cursor.
+  if (!cache_ && count < max) {
+    int nb = 0;
+    queue_.fetch_packets(max - count, msgs, nb);
+    count += nb;
+  }
+}
+
+void MediaConsumer::set_drop_level(ConsumerDropLevel level) {
+  drop_level_ = level;
+}
+
+int64_t MediaConsumer::lag() {
+  if (pending() == 0 || last_fetched_time_ == -1) {
+    return 0;
+  }
+  return std::max<int64_t>(
+      0, last_enqueued_time_ - last_fetched_time_ - start_lag_);
+}
+
+bool MediaConsumer::should_drop(MediaMessage* msg) {
+  // never drop audio, metadata and sequence header.
+  if (!msg->is_video()) {
+    return false;
+  }
+
+  const char* data = msg->payload_->GetFirstMsgReadPtr();
+  int size = msg->payload_->GetFirstMsgLength();
+  if (SrsFlvVideo::sh(data, size)) {
+    return false;
+  }
+  bool keyframe = SrsFlvVideo::keyframe(data, size);
+
+  // drop the whole gop, then wait for the next keyframe to decode.
+  if (drop_level_ == ConsumerDropGop) {
+    if (keyframe || !wait_keyframe_) {
+      ++drop_stats_.gops;
+    }
+    wait_keyframe_ = true;
+    ++drop_stats_.gop_frames;
+    return true;
+  }
+
+  if (wait_keyframe_) {
+    if (keyframe) {
+      wait_keyframe_ = false;
+      return false;
+    }
+    ++drop_stats_.gop_frames;
+    return true;
+  }
+
+  if (drop_level_ == ConsumerDropDisposable && 
+      SrsFlvVideo::disposable(data, size)) {
+    ++drop_stats_.disposable;
+    return true;
+  }
+
+  return false;
 }
 
 void MediaConsumer::on_play_client_pause(bool is_pause) {
   MLOG_CTRACE("stream consumer change pause state %d=>%d", paused_, is_pause);
   paused_ = is_pause;
+
+  // resumed, flush the messages queued in pause.
+  if (!paused_ && sink_ && pending() > 0) {
+    sink_->OnConsumerReady(this, true);
+  }
 }
 
 }
@@ -10,6 +10,7 @@
 
 #include <memory>
 #include <vector>
+#include <deque>
 
 #include "common/media_define.h"
 #include "common/media_kernel_error.h"
@@ -18,11 +19,15 @@
 namespace ma {
 
 class MediaMessage;
+struct MediaPacket;
 
 class MediaConsumer;
 
 // The message queue for the consumer(client), forwarder.
 // We limit the size in seconds, drop old messages(the whole gop) if full.
+// The messages are kept in a ring of slots addressed by an increasing 
+// sequence number, with the keyframes and sequence headers indexed, so 
+// fetch and shrink never move or scan the queued messages.
 class MessageQueue final {
 public:
   MessageQueue(bool ignore_shrink = false);
@@ -36,12 +41,12 @@ public:
   // @param queue_size the queue size in srs_utime_t.
   void set_queue_size(srs_utime_t queue_size);
 
-  void enqueue(std::shared_ptr<MediaMessage> msg, bool* is_overflow = NULL);
+  void enqueue(MediaPacket pkt, bool* is_overflow = NULL);
   // Get packets in consumer queue.
-  // @pmsgs SrsSharedPtrMessage*[], used to store the msgs, user must alloc it.
+  // @pmsgs MediaPacket[], used to store the msgs, user must alloc it.
   // @count the count in array, output param.
   // @max_count the max count to dequeue, must be positive.
-  void fetch_packets(int max_count, std::vector<std::shared_ptr<MediaMessage>>& pmsgs, int& count);
+  void fetch_packets(int max_count, std::vector<MediaPacket>& pmsgs, int& count);
   // Dumps packets to consumer, use specified args.
   // @remark the atc/tba/tbv/ag are same to SrsConsumer.enqueue().
   void fetch_packets(MediaConsumer* consumer, JitterAlgorithm ag);
@@ -49,9 +54,16 @@ public:
   // clear all messages in queue.
   void clear();
 private:
-  // Remove a gop from the front.
+  // Remove the messages before the next keyframe, keep sequence headers.
   // if no iframe found, clear it.
   void shrink();
+
+  MediaPacket& at(uint64_t seq);
+  void push_back(MediaPacket pkt);
+  void push_front(MediaPacket pkt);
+  MediaPacket pop_front();
+  // Double the ring when it's full.
+  void grow();
 private:
   // The start and end time.
   srs_utime_t av_start_time{-1};
@@ -61,10 +73,45 @@ private:
   bool _ignore_shrink;
   // The max queue size, shrink if exceed it.
   srs_utime_t max_queue_size{0};
-  std::vector<std::shared_ptr<MediaMessage>> msgs;
+  // The ring of messages, the capacity is power of 2.
+  std::vector<MediaPacket> ring_;
+  // The sequence number of the first message and after the last message.
+  uint64_t head_{0};
+  uint64_t tail_{0};
+  // The sequence numbers of the video keyframes in queue.
+  std::deque<uint64_t> keyframes_;
+  // The sequence numbers of the latest sequence headers, -1 if none.
+  int64_t video_sh_{-1};
+  int64_t audio_sh_{-1};
 };
 
 class MediaLiveSource;
+class SrsGopCache;
+
+// The owner of consumers, notified in the source worker when there are 
+// messages to fetch, instead of polling the consumers by timer.
+class MediaConsumerSink {
+ public:
+  virtual ~MediaConsumerSink() = default;
+  // @param full, true if the queued messages reach the batch size, 
+  //     false if the first message pushed into the empty queue.
+  virtual void OnConsumerReady(MediaConsumer* consumer, bool full) = 0;
+};
+
+// The delivery policy of the slow consumer, drop the video frames not 
+// referenced first, then the whole gops of video, never drop audio.
+enum ConsumerDropLevel {
+  ConsumerDropNone,
+  ConsumerDropDisposable,
+  ConsumerDropGop
+};
+
+// The count of video frames dropped by the delivery policy.
+struct ConsumerDropStats {
+  int64_t disposable{0};
+  int64_t gop_frames{0};
+  int64_t gops{0};
+};
 
 class MediaConsumer final {
 public:
@@ -73,11 +120,25 @@ public:
 
   // Set the size of queue.
   void set_queue_size(srs_utime_t queue_size);
+  // Set the sink to notify when messages are ready.
+  // @param batch_size notify again when the queue reaches it, 0 to ignore.
+  void set_sink(MediaConsumerSink* sink, int batch_size = 0);
+
+  // Read the shared gop cache from seq before the queued messages, instead
+  // of copying the cache to the queue, the messages queued already(the 
+  // metadata and sequence headers) are fetched first.
+  // The messages not kept by the cache during the cursor mode, like the
+  // metadata in the middle of the stream, are fetched right before the
+  // cached message after them.
+  // The cursor mode ends when it reaches the newest message of the cache.
+  void set_cursor(std::shared_ptr<SrsGopCache> cache, uint64_t seq, 
+                  JitterAlgorithm ag);
 
   // Get current client time, the last packet time.
   int64_t get_time();
   // Enqueue an shared ptr message.
-  // @param shared_msg, directly ptr, copy it if need to save it.
+  // @param shared_msg, directly ptr, shared by all consumers, never copied
+  //     or modified, the corrected timestamp is saved along with it.
   // @param ag the algorithm of time jitter.
   void enqueue(std::shared_ptr<MediaMessage> shared_msg, JitterAlgorithm ag);
 
@@ -85,11 +146,31 @@ public:
   // @param msgs the msgs array to dump packets to send.
   // @param count the count in array, intput and output param.
   // @remark user can specifies the count to get specified msgs; 0 to get all if possible.
-  void fetch_packets(int max, std::vector<std::shared_ptr<MediaMessage>>& msgs, int& count);
+  void fetch_packets(int max, std::vector<MediaPacket>& msgs, int& count);
 
   // when client send the pause message.
   void on_play_client_pause(bool is_pause);
+
+  // Drop the frames when fetching, for the client falls behind.
+  void set_drop_level(ConsumerDropLevel level);
+  ConsumerDropLevel drop_level() {
+    return drop_level_;
+  }
+  const ConsumerDropStats& drop_stats() {
+    return drop_stats_;
+  }
+  // The time in ms the client falls behind the newest message, besides 
+  // the time-shift offset to start with.
+  int64_t lag();
   
+ private:
+  // The count of messages to fetch, in cache and in queue.
+  int pending();
+  void fetch_i(int max, std::vector<MediaPacket>& msgs, int& count);
+  void fetch_cursor(int max, std::vector<MediaPacket>& msgs, int& count);
+  void notify(int size);
+  bool should_drop(MediaMessage* msg);
+
  private:
   // Time jitter detect and correct, to ensure the rtmp stream is monotonically.
   class MediaJitter final {
@@ -98,7 +179,8 @@ public:
 
     // detect the time jitter and correct it.
     // @param ag the algorithm to use for time jitter.
-    void correct(std::shared_ptr<MediaMessage> msg, JitterAlgorithm ag);
+    // @return the corrected timestamp, the msg is not modified.
+    int64_t correct(MediaMessage* msg, JitterAlgorithm ag);
     // Get current client time, the last packet time.
     int64_t get_time();
 
@@ -111,6 +193,34 @@ public:
   MediaLiveSource* source_;
   MessageQueue queue_;
 
+  // The cursor in the shared gop cache, reset when it reaches the newest.
+  std::shared_ptr<SrsGopCache> cache_;
+  uint64_t cursor_{0};
+  JitterAlgorithm cursor_ag_{JitterAlgorithmZERO};
+  // The count of messages in queue before the cursor.
+  int pre_cursor_{0};
+  // The messages not cached, enqueued during the cursor mode.
+  struct UncachedMessage {
+    // the sequence of the cached message following it.
+    uint64_t seq;
+    std::shared_ptr<MediaMessage> msg;
+    JitterAlgorithm ag;
+  };
+  std::deque<UncachedMessage> uncached_;
+
+  MediaConsumerSink* sink_{nullptr};
+  int batch_size_{0};
+
+  ConsumerDropLevel drop_level_{ConsumerDropNone};
+  // The gop is dropped partly, drop the video until the next keyframe.
+  bool wait_keyframe_{false};
+  ConsumerDropStats drop_stats_;
+  // The time of the newest message enqueued and the last one fetched.
+  int64_t last_enqueued_time_{-1};
+  int64_t last_fetched_time_{-1};
+  // The time behind the newest message when started by cursor.
+  int64_t start_lag_{0};
+
   bool paused_;
 };
 
@@ -8,7 +8,6 @@
 #include "live/media_gop_cache.h"
 
 #include "common/media_log.h"
-#include "live/media_consumer.h"
 #include "common/media_message.h"
 #include "encoder/media_codec.h"
 
@@ -34,6 +33,10 @@ bool SrsGopCache::enabled() {
   return enable_gop_cache;
 }
 
+void SrsGopCache::set_duration(srs_utime_t duration) {
+  max_duration_ = duration;
+}
+
 srs_error_t SrsGopCache::cache(std::shared_ptr<MediaMessage> msg) {
   srs_error_t err = srs_success;
   
@@ -42,16 +45,22 @@ srs_error_t SrsGopCache::cache(std::shared_ptr<MediaMessage> msg) {
   }
   
   // the gop cache know when to gop it.
+  bool keyframe = false;
   
   // got video, update the video count if acceptable
   if (msg->is_video()) {
+    const char* data = msg->payload_->GetFirstMsgReadPtr();
     // drop video when not h.264
-    if (!SrsFlvVideo::h264(msg->payload_->GetFirstMsgReadPtr(), msg->size_)) {
+    if (!SrsFlvVideo::h264(data, msg->size_)) {
       return err;
     }
     
     cached_video_count++;
     audio_after_last_video_count = 0;
+
+    // the sequence header is flagged as keyframe too.
+    keyframe = SrsFlvVideo::keyframe(data, msg->size_) && 
+               !SrsFlvVideo::sh(data, msg->size_);
   }
   
   // no acceptable video or pure audio, disable the cache.
@@ -71,43 +80,58 @@ srs_error_t SrsGopCache::cache(std::shared_ptr<MediaMessage> msg) {
     return err;
   }
   
-  // clear gop cache when got key frame
-  if (msg->is_video() && 
-      SrsFlvVideo::keyframe(msg->payload_->GetFirstMsgReadPtr(), msg->size_)) {
-    clear();
-    
-    // curent msg is video frame, so we set to 1.
-    cached_video_count = 1;
-    //MLOG_TRACE("gop cache keyframe enqueue ksize:" << msg->size_);
+  // index the keyframe for seeking.
+  if (keyframe) {
+    keyframes_.push_back({tail(), msg->timestamp_});
   }
   
   // cache the frame.
-  gop_cache.emplace_back(std::move(msg));
+  msgs_.emplace_back(std::move(msg));
+
+  shrink();
   
   return err;
 }
 
-void SrsGopCache::clear() {
-  gop_cache.clear();
-  
-  cached_video_count = 0;
-  audio_after_last_video_count = 0;
+void SrsGopCache::pop_front() {
+  msgs_.pop_front();
+  ++head_;
+  if (!keyframes_.empty() && keyframes_.front().seq < head_) {
+    keyframes_.pop_front();
+  }
 }
 
-srs_error_t SrsGopCache::dump(MediaConsumer* consumer, 
-                              JitterAlgorithm jitter_algorithm) {
-  srs_error_t err = srs_success;
-  if (empty()) {
-    return err;
+void SrsGopCache::shrink() {
+  if (keyframes_.empty()) {
+    return;
+  }
+
+  // the messages before the first keyframe can't be decoded.
+  while (head_ < keyframes_.front().seq) {
+    pop_front();
   }
 
-  for (auto msg : gop_cache) {
-    consumer->enqueue(std::move(msg), jitter_algorithm);
+  // drop the oldest gop while the newer gops still cover the duration,
+  // so the last gop only is kept when the duration is 0.
+  int64_t last = msgs_.back()->timestamp_;
+  while (keyframes_.size() >= 2 && 
+      srs_utime_t((last - keyframes_[1].timestamp) * SRS_UTIME_MILLISECONDS) 
+          >= max_duration_) {
+    uint64_t next = keyframes_[1].seq;
+    while (head_ < next) {
+      pop_front();
+    }
   }
-  MLOG_TRACE("dispatch cached gop success. count=" << (int)gop_cache.size() << 
-             " duration=" << consumer->get_time());
+}
+
+void SrsGopCache::clear() {
+  // keep the sequence increasing, the cursors behind jump to the head.
+  head_ += msgs_.size();
+  msgs_.clear();
+  keyframes_.clear();
   
-  return err;
+  cached_video_count = 0;
+  audio_after_last_video_count = 0;
 }
 
 srs_utime_t SrsGopCache::start_time() {
@@ -115,7 +139,7 @@ srs_utime_t SrsGopCache::start_time() {
     return 0;
   }
   
-  MediaMessage* msg = gop_cache[0].get();
+  MediaMessage* msg = msgs_[0].get();
   srs_assert(msg);
   
   return srs_utime_t(msg->timestamp_ * SRS_UTIME_MILLISECONDS);
@@ -125,5 +149,44 @@ inline bool SrsGopCache::pure_audio() {
   return cached_video_count == 0;
 }
 
+uint64_t SrsGopCache::seek(srs_utime_t offset, srs_utime_t& start) {
+  if (empty()) {
+    start = 0;
+    return tail();
+  }
+
+  if (keyframes_.empty()) {
+    start = start_time();
+    return head_;
+  }
+
+  // the last keyframe before the target, or the oldest one.
+  int64_t target = msgs_.back()->timestamp_ + srsu2ms(offset);
+  Keyframe found = keyframes_.front();
+  for (auto& k : keyframes_) {
+    if (k.timestamp > target) {
+      break;
+    }
+    found = k;
+  }
+
+  start = srs_utime_t(found.timestamp * SRS_UTIME_MILLISECONDS);
+  return found.seq;
+}
+
+MediaMessage* SrsGopCache::newest() {
+  if (empty()) {
+    return nullptr;
+  }
+  return msgs_.back().get();
+}
+
+std::shared_ptr<MediaMessage> SrsGopCache::at(uint64_t seq) {
+  if (seq < head_ || seq >= tail()) {
+    return nullptr;
+  }
+  return msgs_[seq - head_];
+}
+
 }
 
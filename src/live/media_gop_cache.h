@@ -9,19 +9,20 @@
 #define __MEDIA_SRC_GOP_CACHE_H__
 
 #include <memory>
+#include <deque>
 
 #include "common/media_define.h"
 #include "common/media_kernel_error.h"
-#include "live/media_consumer.h"
 
 namespace ma {
 
-class MediaConsumer;
 class MediaMessage;
 
-// cache a gop of video/audio data,
-// delivery at the connect of flash player,
-// To enable it to fast startup.
+// cache the recent gops of video/audio data, shared by all the consumers
+// of the stream, to enable the player to start instantly from the latest
+// keyframe, or from an earlier one for time-shift.
+// The messages are addressed by an increasing sequence number, the
+// consumers read the cache by a cursor of sequence, never copy it.
 class SrsGopCache final {
  public:
   SrsGopCache() = default;
@@ -33,19 +34,18 @@ class SrsGopCache final {
   // To enable or disable the gop cache.
   void set(bool v);
   bool enabled();
+  // Set the duration of gops to keep.
+  // @param duration in srs_utime_t, 0 to keep the last gop only.
+  void set_duration(srs_utime_t duration);
   // only for h264 codec
-  // 1. cache the gop when got h264 video packet.
-  // 2. clear gop when got keyframe.
-  // @param shared_msg, directly ptr, copy it if need to save it.
+  // 1. cache the message when got h264 video packet.
+  // 2. drop the oldest gop when the cache exceeds the duration.
+  // @param shared_msg, shared with the consumers, never modified.
   srs_error_t cache(std::shared_ptr<MediaMessage> shared_msg);
   // clear the gop cache.
   void clear();
-  // dump the cached gop to consumer.
-  srs_error_t dump(MediaConsumer* consumer, JitterAlgorithm jitter_algorithm);
-  // used for atc to get the time of gop cache,
-  // The atc will adjust the sequence header timestamp to gop cache.
   inline bool empty() {
-    return gop_cache.empty();
+    return msgs_.empty();
   }
   // Get the start time of gop cache, in srs_utime_t.
   // @return 0 if no packets.
@@ -54,11 +54,37 @@ class SrsGopCache final {
   // when no video in gop cache, the stream is pure audio right now.
   bool pure_audio();
 
+  // Find the keyframe to start playing.
+  // @param offset in srs_utime_t relative to the newest message, 0 or 
+  //     negative, 0 to start from the latest keyframe.
+  // @param start_time output the time of the message found, in srs_utime_t.
+  // @return the sequence of the message to start from.
+  uint64_t seek(srs_utime_t offset, srs_utime_t& start_time);
+  // The sequence of the oldest message and after the newest message.
+  inline uint64_t head() {
+    return head_;
+  }
+  inline uint64_t tail() {
+    return head_ + msgs_.size();
+  }
+  // Get the newest message, nullptr if empty.
+  MediaMessage* newest();
+  // Get the message by sequence, nullptr if it's not in cache.
+  std::shared_ptr<MediaMessage> at(uint64_t seq);
+
+ private:
+  void pop_front();
+  // Drop the messages before the first keyframe, and the oldest gops
+  // out of the duration.
+  void shrink();
+
  private:
   // if disabled the gop cache,
   // The client will wait for the next keyframe for h264,
   // and will be black-screen.
   bool enable_gop_cache{false};
+  // The duration of gops to keep, 0 for the last gop only.
+  srs_utime_t max_duration_{0};
   // The video frame count, avoid cache for pure audio stream.
   int cached_video_count{0};
   // when user disabled video when publishing, and gop cache enalbed,
@@ -72,11 +98,17 @@ class SrsGopCache final {
   //       gop cache is disabled for pure audio stream.
   // @see: https://github.com/ossrs/srs/issues/124
   int audio_after_last_video_count{0};
-  // cached gop.
-  std::vector<std::shared_ptr<MediaMessage>> gop_cache;
+  // cached gops, the sequence of msgs_[0] is head_.
+  std::deque<std::shared_ptr<MediaMessage>> msgs_;
+  uint64_t head_{0};
+  // The sequence and time(ms) of the keyframes in cache.
+  struct Keyframe {
+    uint64_t seq;
+    int64_t timestamp;
+  };
+  std::deque<Keyframe> keyframes_;
 };
 
 }
 
 #endif//!__MEDIA_SRC_GOP_CACHE_H__
-
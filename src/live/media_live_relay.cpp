@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2021- anjisuan783
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "live/media_live_relay.h"
+
+#include "common/media_log.h"
+#include "common/media_message.h"
+#include "live/media_live_source.h"
+
+namespace ma {
+
+static log4cxx::LoggerPtr logger = log4cxx::Logger::getLogger("ma.live");
+
+MediaLiveRelay::MediaLiveRelay(const std::string& stream_name, 
+                               std::shared_ptr<wa::Worker> worker)
+    : worker_{std::move(worker)}, 
+      source_{new MediaLiveSource(stream_name)} {
+  MLOG_TRACE_THIS(stream_name << ", worker:" << worker_->id());
+}
+
+MediaLiveRelay::~MediaLiveRelay() {
+  MLOG_TRACE_THIS("");
+}
+
+void MediaLiveRelay::Initialize(bool gop, int gop_duration, 
+    JitterAlgorithm algorithm, int consumer_queue_size) {
+  // the messages are corrected by the origin already.
+  source_->Initialize(gop, gop_duration, algorithm, 
+                      false, consumer_queue_size);
+}
+
+void MediaLiveRelay::OnPublish() {
+  async_task([](MediaLiveSource* s) {
+    s->OnPublish();
+  }, RTC_FROM_HERE);
+}
+
+void MediaLiveRelay::OnUnpublish() {
+  async_task([](MediaLiveSource* s) {
+    s->OnUnpublish();
+  }, RTC_FROM_HERE);
+}
+
+void MediaLiveRelay::OnReplayed() {
+  async_task([this](MediaLiveSource*) {
+    ready_ = true;
+  }, RTC_FROM_HERE);
+}
+
+srs_error_t MediaLiveRelay::OnAudio(
+    std::shared_ptr<MediaMessage> msg, bool from_adaptor) {
+  async_task([msg = std::move(msg), from_adaptor](MediaLiveSource* s) {
+    srs_error_t err = s->OnAudio(std::move(msg), from_adaptor);
+    if (err != srs_success) {
+      MLOG_ERROR("relay audio, desc:" << srs_error_desc(err));
+      delete err;
+    }
+  }, RTC_FROM_HERE);
+  return srs_success;
+}
+
+srs_error_t MediaLiveRelay::OnVideo(
+    std::shared_ptr<MediaMessage> msg, bool from_adaptor) {
+  async_task([msg = std::move(msg), from_adaptor](MediaLiveSource* s) {
+    srs_error_t err = s->OnVideo(std::move(msg), from_adaptor);
+    if (err != srs_success) {
+      MLOG_ERROR("relay video, desc:" << srs_error_desc(err));
+      delete err;
+    }
+  }, RTC_FROM_HERE);
+  return srs_success;
+}
+
+void MediaLiveRelay::async_task(
+    std::function<void(MediaLiveSource*)> f, const rtc::Location& l) {
+  worker_->task([self = shared_from_this(), f] {
+    f(self->source_.get());
+  }, l);
+}
+
+} //namespace ma
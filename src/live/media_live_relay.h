@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2021- anjisuan783
+//
+// SPDX-License-Identifier: MIT
+//
+
+#ifndef __MEDIA_LIVE_RELAY_H__
+#define __MEDIA_LIVE_RELAY_H__
+
+#include <atomic>
+#include <memory>
+
+#include "utils/Worker.h"
+#include "h/media_server_api.h"
+#include "rtc/media_rtc_live_adaptor_sink.h"
+
+namespace ma {
+
+class MediaLiveSource;
+
+// The replica of a hot live source on another worker, the origin source 
+// forwards the shared messages once to it, then it serves its own consumers,
+// so the fan-out of one stream is spread over the workers.
+class MediaLiveRelay final : 
+    public RtcLiveAdapterSink,
+    public std::enable_shared_from_this<MediaLiveRelay> {
+ public:
+  MediaLiveRelay(const std::string& stream_name, 
+                 std::shared_ptr<wa::Worker> worker);
+  ~MediaLiveRelay();
+
+  void Initialize(bool gop, int gop_duration, JitterAlgorithm algorithm, 
+                  int consumer_queue_size);
+
+  // called in the origin worker, run in the relay worker.
+  void OnPublish() override;
+  void OnUnpublish() override;
+  srs_error_t OnAudio(std::shared_ptr<MediaMessage>, 
+                      bool from_adaptor) override;
+  srs_error_t OnVideo(std::shared_ptr<MediaMessage>, 
+                      bool from_adaptor) override;
+
+  // called in the origin worker after the replay of the sequence headers
+  // and the gop cache, ready when run in the relay worker.
+  void OnReplayed();
+  // the players placed on it start from the replay, thread safe.
+  inline bool ready() {
+    return ready_;
+  }
+
+  inline std::shared_ptr<wa::Worker> worker() {
+    return worker_;
+  }
+
+  // used in the relay worker only.
+  inline MediaLiveSource* source() {
+    return source_.get();
+  }
+
+ private:
+  void async_task(std::function<void(MediaLiveSource*)> f, 
+                  const rtc::Location& l);
+ private:
+  std::shared_ptr<wa::Worker> worker_;
+  std::unique_ptr<MediaLiveSource> source_;
+  std::atomic<bool> ready_{false};
+};
+
+} //namespace ma
+
+#endif //!__MEDIA_LIVE_RELAY_H__
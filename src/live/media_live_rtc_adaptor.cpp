@@ -110,9 +110,12 @@ srs_error_t AudioTransform::Open(TransformSink* sink,
   return err;
 }
 
-srs_error_t AudioTransform::OnData(std::shared_ptr<MediaMessage> msg) {
+srs_error_t AudioTransform::OnData(const MediaPacket& pkt) {
   srs_error_t err = srs_success;
-  if ((err = format_.on_audio(msg)) != srs_success) {
+  MediaMessage* msg = pkt.msg_.get();
+  if ((err = format_.on_audio(pkt.timestamp_, 
+      const_cast<char*>(msg->payload_->GetFirstMsgReadPtr()), 
+      msg->size_)) != srs_success) {
     return srs_error_wrap(err, "format consume audio");
   }
 
@@ -233,8 +236,9 @@ srs_error_t Videotransform::Open(TransformSink* sink,
   return err;
 }
 
-srs_error_t Videotransform::OnData(std::shared_ptr<MediaMessage> msg) {
+srs_error_t Videotransform::OnData(const MediaPacket& pkt) {
   srs_error_t err = srs_success;
+  const std::shared_ptr<MediaMessage>& msg = pkt.msg_;
 
   // cache the sequence header if h264
   bool is_sequence_header = 
@@ -244,7 +248,9 @@ srs_error_t Videotransform::OnData(std::shared_ptr<MediaMessage> msg) {
     return srs_error_wrap(err, "meta update video");
   }
 
-  if ((err = format_.on_video(msg)) != srs_success) {
+  if ((err = format_.on_video(pkt.timestamp_, 
+      const_cast<char*>(msg->payload_->GetFirstMsgReadPtr()), 
+      msg->size_)) != srs_success) {
     return srs_error_wrap(err, "format consume video");
   }
 
@@ -266,7 +272,7 @@ srs_error_t Videotransform::OnData(std::shared_ptr<MediaMessage> msg) {
   }
   
   owt_base::Frame frm;
-  if ((err = PackageVideoframe(has_idr, msg.get(), samples, len, frm))
+  if ((err = PackageVideoframe(has_idr, pkt.timestamp_, samples, len, frm))
       != srs_success) {
     return srs_error_wrap(err, "package video");
   }
@@ -312,7 +318,7 @@ srs_error_t Videotransform::Filter(SrsFormat* format, bool& has_idr,
 }
 
 srs_error_t Videotransform::PackageVideoframe(bool idr,
-    MediaMessage* msg, std::list<SrsSample*>& samples,
+    int64_t timestamp, std::list<SrsSample*>& samples,
     int len, owt_base::Frame& frame) {
   srs_error_t err = srs_success;
 
@@ -352,8 +358,8 @@ srs_error_t Videotransform::PackageVideoframe(bool idr,
   }
 
   frame.format = owt_base::FRAME_FORMAT_H264;
-  frame.timeStamp = msg->timestamp_ * VIDEO_SAMPLES_PER_MS;
-  frame.ntpTimeMs = msg->timestamp_;
+  frame.timeStamp = timestamp * VIDEO_SAMPLES_PER_MS;
+  frame.ntpTimeMs = timestamp;
   frame.additionalInfo.video.height = 0;
   frame.additionalInfo.video.width = 0;
   
@@ -407,15 +413,11 @@ srs_error_t MediaLiveRtcAdaptor::Open(wa::Worker* worker,
   rtc_source_ = sink;
   rtc_source_->OnLocalPublish(stream_name_);
 
-  static constexpr auto TIME_OUT = std::chrono::milliseconds(SRS_PERF_MW_SLEEP);
-
-  //TODO timer push need optimizing
-  worker->scheduleEvery([weak_this = weak_from_this()]() {
-    if (auto this_ptr = weak_this.lock()) {
-      return this_ptr->OnTimer();
-    }
-    return false;
-  }, TIME_OUT, RTC_FROM_HERE);
+  // frames are transcoded one by one, no merged-write, 
+  // flush as soon as messages are queued.
+  worker_ = worker;
+  consumer_->set_sink(this);
+  OnConsumerReady(consumer_.get(), true);
 
   std::string streamName = srs_string_replace(source->StreamName(), "/", "_");
 
@@ -468,8 +470,8 @@ void MediaLiveRtcAdaptor::Close() {
   rtc_source_ = nullptr;
 }
 
-srs_error_t MediaLiveRtcAdaptor::OnAudio(std::shared_ptr<MediaMessage> msg) {
-  return audio_->OnData(std::move(msg));
+srs_error_t MediaLiveRtcAdaptor::OnAudio(const MediaPacket& pkt) {
+  return audio_->OnData(pkt);
 }
 
 void MediaLiveRtcAdaptor::OnFrame(owt_base::Frame& frame) {
@@ -477,39 +479,60 @@ void MediaLiveRtcAdaptor::OnFrame(owt_base::Frame& frame) {
   rtc_source_->OnFrame(std::move(msg));
 }
 
-srs_error_t MediaLiveRtcAdaptor::OnVideo(std::shared_ptr<MediaMessage> msg) {
-  return video_->OnData(std::move(msg));
+srs_error_t MediaLiveRtcAdaptor::OnVideo(const MediaPacket& pkt) {
+  return video_->OnData(pkt);
 }
 
-bool MediaLiveRtcAdaptor::OnTimer() {
-  srs_error_t err = srs_success;
-  int count;
-  std::vector<std::shared_ptr<MediaMessage>> cache;
-  consumer_->fetch_packets(SRS_PERF_MW_MSGS, cache, count);
-
-  for(int i = 0; i < count; ++i) {
-    if (cache[i]->is_audio()) {
-      err = OnAudio(cache[i]);
-    } else if (cache[i]->is_video()) {
-      err = OnVideo(cache[i]);
-    }
+void MediaLiveRtcAdaptor::OnConsumerReady(MediaConsumer*, bool) {
+  if (flush_pending_) {
+    return;
+  }
+  flush_pending_ = true;
 
-    if (err != srs_success) {
-      MLOG_CERROR("consume, media packet, desc:%s", srs_error_desc(err));
-      delete err;
+  worker_->task([weak_this = weak_from_this()]() {
+    if (auto this_ptr = weak_this.lock()) {
+      this_ptr->Flush();
     }
+  }, RTC_FROM_HERE);
+}
+
+void MediaLiveRtcAdaptor::Flush() {
+  flush_pending_ = false;
+  if (!consumer_) {
+    return;
   }
 
-  if (enable_debug_) {
-    SrsFlvStreamEncoder* fast = 
-        dynamic_cast<SrsFlvStreamEncoder*>(debug_flv_encoder_.get());
-    if ((err = fast->write_tags(cache)) != srs_success) {
-        MLOG_ERROR("write_tags failed, desc:" << srs_error_desc(err));
-      delete err;
+  srs_error_t err = srs_success;
+  int count = 0;
+  std::vector<MediaPacket> cache;
+  cache.reserve(SRS_PERF_MW_MSGS);
+  do {
+    cache.clear();
+    count = 0;
+    consumer_->fetch_packets(SRS_PERF_MW_MSGS, cache, count);
+
+    for(int i = 0; i < count; ++i) {
+      if (cache[i].msg_->is_audio()) {
+        err = OnAudio(cache[i]);
+      } else if (cache[i].msg_->is_video()) {
+        err = OnVideo(cache[i]);
+      }
+
+      if (err != srs_success) {
+        MLOG_CERROR("consume, media packet, desc:%s", srs_error_desc(err));
+        delete err;
+      }
     }
-  }
 
-  return true;
+    if (count > 0 && enable_debug_) {
+      SrsFlvStreamEncoder* fast = 
+          dynamic_cast<SrsFlvStreamEncoder*>(debug_flv_encoder_.get());
+      if ((err = fast->write_tags(cache)) != srs_success) {
+          MLOG_ERROR("write_tags failed, desc:" << srs_error_desc(err));
+        delete err;
+      }
+    }
+  } while (count > 0);
 }
 
 }
@@ -8,6 +8,7 @@
 #include "common/media_message.h"
 #include "h/rtc_media_frame.h"
 #include "live/media_live_source_sink.h"
+#include "live/media_consumer.h"
 #include "rtmp/media_rtmp_format.h"
 #include "utils/Worker.h"
 
@@ -16,7 +17,6 @@ namespace ma {
 class LiveRtcAdapterSink;
 class MediaLiveSource;
 class MediaRequest;
-class MediaConsumer;
 class MediaMetaCache;
 class SrsFileWriter;
 class ISrsBufferEncoder;
@@ -34,7 +34,7 @@ class AudioTransform {
   ~AudioTransform();
 
   srs_error_t Open(TransformSink*, bool debug, const std::string& out_path);
-  srs_error_t OnData(std::shared_ptr<MediaMessage> msg);
+  srs_error_t OnData(const MediaPacket& pkt);
  private:
   srs_error_t Transcode(SrsAudioFrame* audio, 
       std::vector<SrsAudioFrame*>& out_audios);
@@ -51,11 +51,11 @@ class Videotransform {
   Videotransform();
   ~Videotransform();
   srs_error_t Open(TransformSink*, bool debug, const std::string& fileName);
-  srs_error_t OnData(std::shared_ptr<MediaMessage> msg);
+  srs_error_t OnData(const MediaPacket& pkt);
  private:
   srs_error_t Filter(SrsFormat* format, 
       bool& has_idr, std::list<SrsSample*>& samples, int& data_len);
-  srs_error_t PackageVideoframe(bool idr, MediaMessage* msg, 
+  srs_error_t PackageVideoframe(bool idr, int64_t timestamp, 
       std::list<SrsSample*>& samples, int len, owt_base::Frame& frame);
 
  private:
@@ -70,7 +70,8 @@ class Videotransform {
 
 class MediaLiveRtcAdaptor final : 
     public std::enable_shared_from_this<MediaLiveRtcAdaptor>,
-    public TransformSink {
+    public TransformSink,
+    public MediaConsumerSink {
  public:
   MediaLiveRtcAdaptor(const std::string& streamName);
   ~MediaLiveRtcAdaptor();
@@ -80,15 +81,18 @@ class MediaLiveRtcAdaptor final :
   void Close();
 
  private:
-  srs_error_t OnAudio(std::shared_ptr<MediaMessage>);
-  srs_error_t OnVideo(std::shared_ptr<MediaMessage>);
+  srs_error_t OnAudio(const MediaPacket&);
+  srs_error_t OnVideo(const MediaPacket&);
   void OnFrame(owt_base::Frame&) override;
+  void OnConsumerReady(MediaConsumer*, bool full) override;
   
-  bool OnTimer();
+  void Flush();
 
  private:
   std::string stream_name_;
   std::shared_ptr<MediaConsumer> consumer_;
+  wa::Worker* worker_{nullptr};
+  bool flush_pending_{false};
   LiveRtcAdapterSink* rtc_source_{nullptr};
   MediaLiveSource* live_source_{nullptr};
 
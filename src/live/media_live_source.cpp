@@ -7,13 +7,17 @@
 #include "live/media_live_source.h"
 
 #include <inttypes.h>
+
+#include <algorithm>
 #include <iostream>
 
 #include "common/media_log.h"
 #include "common/media_message.h"
 #include "media_source_mgr.h"
 #include "encoder/media_codec.h"
+#include "encoder/media_flv_encoder.h"
 #include "live/media_gop_cache.h"
+#include "live/media_live_relay.h"
 #include "live/media_meta_cache.h"
 #include "live/media_live_source_sink.h"
 
@@ -109,12 +113,13 @@ MediaLiveSource::~MediaLiveSource() {
   MLOG_TRACE_THIS(stream_name_);
 }
 
-bool MediaLiveSource::Initialize(bool gop, JitterAlgorithm algorithm, 
-    bool mix_correct, int consumer_queue_size) {
+bool MediaLiveSource::Initialize(bool gop, int gop_duration, 
+    JitterAlgorithm algorithm, bool mix_correct, int consumer_queue_size) {
   last_packet_time_ = 0;
   active_ = false;
   jitter_algorithm_ = algorithm;
   enable_gop_ = gop;
+  gop_duration_ = gop_duration;
   last_width_ = last_height_ = 0;
   is_monotonically_increase_ = false;
   mix_correct_ = mix_correct;
@@ -122,7 +127,8 @@ bool MediaLiveSource::Initialize(bool gop, JitterAlgorithm algorithm,
   first_consumer_ = true;
   no_consumer_notify_ = false;
   consumer_queue_size_ = consumer_queue_size;
-  MLOG_INFO("gop:" << (enable_gop_?"enable":"disable") <<
+  MLOG_INFO("gop:" << (enable_gop_?"enable":"disable") << 
+            ", gop duration:" << gop_duration_ <<
             ", algorithm:" << jitter_algorithm_);
   return true;
 }
@@ -143,11 +149,16 @@ void MediaLiveSource::OnPublish() {
   last_width_ = last_height_ = 0;
 
   assert(nullptr == gop_cache_.get());
-  gop_cache_.reset(new SrsGopCache);
+  gop_cache_ = std::make_shared<SrsGopCache>();
   gop_cache_->set(enable_gop_);
+  gop_cache_->set_duration(gop_duration_ * SRS_UTIME_MILLISECONDS);
 
   assert(nullptr == meta_.get());
   meta_.reset(new MediaMetaCache);
+
+  for (auto& r : relays_) {
+    r->OnPublish();
+  }
 }
 
 void MediaLiveSource::OnUnpublish() {
@@ -158,13 +169,54 @@ void MediaLiveSource::OnUnpublish() {
   }
   MLOG_INFO(stream_name_);
 
-  gop_cache_.reset(nullptr);
+  gop_cache_.reset();
   meta_.reset(nullptr);
 
   last_packet_time_ = 0;
   active_ = false;
   first_consumer_ = true;
   first_packet_ = true;
+
+  for (auto& r : relays_) {
+    r->OnUnpublish();
+  }
+}
+
+void MediaLiveSource::AddRelay(std::shared_ptr<MediaLiveRelay> relay) {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+  relays_.emplace_back(relay);
+
+  if (!active_) {
+    return;
+  }
+
+  relay->OnPublish();
+
+  // the meta cache adjusts the timestamp of its copies, relay a copy.
+  if (meta_->vsh()) {
+    relay->OnVideo(meta_->vsh()->Copy(), false);
+  }
+  if (meta_->ash()) {
+    relay->OnAudio(meta_->ash()->Copy(), false);
+  }
+
+  // let the replica start its players from the gop cache too.
+  if (gop_cache_) {
+    for (uint64_t i = gop_cache_->head(); i < gop_cache_->tail(); ++i) {
+      auto msg = gop_cache_->at(i);
+      if (msg->is_video()) {
+        relay->OnVideo(std::move(msg), false);
+      } else {
+        relay->OnAudio(std::move(msg), false);
+      }
+    }
+  }
+}
+
+void MediaLiveSource::RemoveRelay(MediaLiveRelay* relay) {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+  relays_.erase(std::remove_if(relays_.begin(), relays_.end(), 
+      [relay](auto& r) { return r.get() == relay; }), relays_.end());
 }
 
 std::shared_ptr<MediaConsumer> MediaLiveSource::CreateConsumer() {
@@ -195,6 +247,9 @@ void MediaLiveSource::OnAudio_i(
     std::shared_ptr<MediaMessage> shared_audio, bool from_adaptor) {
   srs_error_t err = srs_success;
 
+  // mux the flv tag once for all the flv consumers.
+  SrsFlvStreamEncoder::encode_tag(shared_audio.get());
+
   bool is_sequence_header = 
         SrsFlvAudio::sh(shared_audio->payload_->GetFirstMsgReadPtr(),
                         shared_audio->payload_->GetFirstMsgLength());
@@ -219,6 +274,21 @@ void MediaLiveSource::OnAudio_i(
   }
   
   if (!drop_for_reduce) {
+    // cache it before dispatching, the consumers reading the gop cache by 
+    // cursor skip it, the sequence header is cached too for the consumers 
+    // behind the live.
+    if (gop_cache_ && (err = gop_cache_->cache(shared_audio)) != srs_success) {
+      MLOG_CERROR("gop cache consume audio, desc:%s",
+                  srs_error_desc(err).c_str());
+      delete err;
+      err = srs_success;
+    }
+
+    // the replicas dispatch it to their consumers in their workers.
+    for (auto& r : relays_) {
+      r->OnAudio(shared_audio, from_adaptor);
+    }
+
     for (auto i = consumers_.begin(); i != consumers_.end();) {
       if (auto c_ptr = i->lock()) {
         c_ptr->enqueue(shared_audio, jitter_algorithm_);
@@ -229,17 +299,11 @@ void MediaLiveSource::OnAudio_i(
     }
   }
   
-  // when sequence header, donot push to gop cache and adjust the timestamp.
+  // when sequence header, donot adjust the timestamp.
   if (is_sequence_header) {
     return ;
   }
 
-  if (gop_cache_ && (err = gop_cache_->cache(shared_audio)) != srs_success) {
-    MLOG_CERROR("gop cache consume audio, desc:%s",srs_error_desc(err).c_str());
-    delete err;
-    return;
-  }
-
   if (gop_cache_ && !gop_cache_->enabled()) {
     if (meta_->ash()) {
       meta_->ash()->timestamp_ = shared_audio->timestamp_;
@@ -297,6 +361,9 @@ void MediaLiveSource::OnVideo_i(
     std::shared_ptr<MediaMessage> shared_video, bool from_adaptor) {
   srs_error_t err = srs_success;
 
+  // mux the flv tag once for all the flv consumers.
+  SrsFlvStreamEncoder::encode_tag(shared_video.get());
+
   bool is_sequence_header = 
       SrsFlvVideo::sh(shared_video->payload_->GetFirstMsgReadPtr(), 
                       shared_video->payload_->GetFirstMsgLength());
@@ -308,7 +375,6 @@ void MediaLiveSource::OnVideo_i(
   }
 
   // cache the sequence header if h264
-  // donot cache the sequence header to gop_cache, return here.
   if(is_sequence_header && !drop_for_reduce) {
     if ((err = meta_->update_vsh(shared_video)) != srs_success) {
       MLOG_CERROR("meta update video, code:%d desc:%s", 
@@ -341,6 +407,21 @@ void MediaLiveSource::OnVideo_i(
   
   // copy to all consumer asynchronously
   if (!drop_for_reduce) {
+    // cache it before dispatching, the consumers reading the gop cache by 
+    // cursor skip it, the sequence header is cached too for the consumers 
+    // behind the live.
+    if (gop_cache_ && (err = gop_cache_->cache(shared_video)) != srs_success) {
+      MLOG_CERROR("gop cache consume video, desc:%s",
+                  srs_error_desc(err).c_str());
+      delete err;
+      err = srs_success;
+    }
+
+    // the replicas dispatch it to their consumers in their workers.
+    for (auto& r : relays_) {
+      r->OnVideo(shared_video, from_adaptor);
+    }
+
     for (auto i = consumers_.begin(); i != consumers_.end();) {
       if (auto c_ptr = i->lock()) {
         c_ptr->enqueue(shared_video, jitter_algorithm_);
@@ -351,18 +432,11 @@ void MediaLiveSource::OnVideo_i(
     }
   }
   
-  // when sequence header, donot push to gop cache and adjust the timestamp.
+  // when sequence header, donot adjust the timestamp.
   if (is_sequence_header) {
     return ;
   }
 
-  // cache the last gop packets
-  if (gop_cache_ && (err = gop_cache_->cache(shared_video)) != srs_success) {
-    MLOG_CERROR("gop cache consume vdieo, desc:%s",srs_error_desc(err).c_str());
-    delete err;
-    return ;
-  }
-
   if (gop_cache_ && !gop_cache_->enabled()) {
     if (meta_->vsh()) {
       meta_->vsh()->timestamp_ = shared_video->timestamp_;
@@ -430,7 +504,8 @@ srs_error_t MediaLiveSource::OnVideo(
 }
 
 srs_error_t MediaLiveSource::ConsumerDumps(MediaConsumer* consumer, 
-    bool dump_seq_header, bool dump_meta, bool dump_gop) {
+    bool dump_seq_header, bool dump_meta, bool dump_gop, 
+    int64_t start_offset) {
   RTC_DCHECK_RUN_ON(&thread_check_);
 
   srs_error_t err = srs_success;
@@ -438,16 +513,24 @@ srs_error_t MediaLiveSource::ConsumerDumps(MediaConsumer* consumer,
   srs_utime_t queue_size = consumer_queue_size_ * SRS_UTIME_MILLISECONDS;
   consumer->set_queue_size(queue_size);
  
+  // the keyframe to start playing from, the live one if no offset.
+  uint64_t cursor = 0;
+  srs_utime_t start_time = 0;
+  if (gop_cache_) {
+    cursor = gop_cache_->seek(
+        start_offset * SRS_UTIME_MILLISECONDS, start_time);
+  }
+
   // if atc, update the sequence header to gop cache time.
-  if (!gop_cache_->empty()) {
+  if (gop_cache_ && !gop_cache_->empty()) {
     if (meta_->data()) {
-      meta_->data()->timestamp_ = srsu2ms(gop_cache_->start_time());
+      meta_->data()->timestamp_ = srsu2ms(start_time);
     }
     if (meta_->vsh()) {
-      meta_->vsh()->timestamp_ = srsu2ms(gop_cache_->start_time());
+      meta_->vsh()->timestamp_ = srsu2ms(start_time);
     }
     if (meta_->ash()) {
-      meta_->ash()->timestamp_ = srsu2ms(gop_cache_->start_time());
+      meta_->ash()->timestamp_ = srsu2ms(start_time);
     }
   }
 
@@ -462,18 +545,19 @@ srs_error_t MediaLiveSource::ConsumerDumps(MediaConsumer* consumer,
       return srs_error_wrap(err, "meta dumps");
     }
 
-    // copy gop cache to client.
-    if (dump_gop && 
-        (err = gop_cache_->dump(consumer, 
-                                jitter_algorithm_)) != srs_success) {
-      return srs_error_wrap(err, "gop cache dumps");
+    // read the gop cache by cursor, never copy it to consumer.
+    if (dump_gop && !gop_cache_->empty()) {
+      consumer->set_cursor(gop_cache_, cursor, jitter_algorithm_);
     }
   }
 
   // print status.
   if (dump_gop) {
-    MLOG_CTRACE("consumer_dumps, active=%d, queue_size=%" PRId64 ", algo=%d", 
-        (active_?1:0), queue_size, jitter_algorithm_);
+    MLOG_CTRACE("consumer_dumps, active=%d, queue_size=%" PRId64 
+        ", start=%" PRId64 "ms, cached=%d, algo=%d", (active_?1:0), queue_size, 
+        srsu2ms(start_time), 
+        (gop_cache_? (int)(gop_cache_->tail() - cursor) : 0), 
+        jitter_algorithm_);
   } else {
     MLOG_CTRACE("consumer_dumps, active=%d, ignore gop cache, algo=%d", 
        (active_?1:0), jitter_algorithm_);
@@ -9,6 +9,7 @@
 
 #include <memory>
 #include <list>
+#include <vector>
 
 #include "utils/sigslot.h"
 #include "rtc_base/sequence_checker.h"
@@ -26,18 +27,20 @@ class MediaMetaCache;
 class SrsMixQueue;
 class RtmpMediaSink;
 class MediaSource;
+class MediaLiveRelay;
 
 // live streaming source.
 class MediaLiveSource final : public RtcLiveAdapterSink {
   friend class MediaSource;
   friend class MediaLiveRtcAdaptor;
+  friend class MediaLiveRelay;
  public:
   ~MediaLiveSource();
  protected:
   MediaLiveSource(const std::string& stream_name);
   
   //called by MediaSourceMgr
-  bool Initialize(bool gop, JitterAlgorithm algorithm, 
+  bool Initialize(bool gop, int gop_duration, JitterAlgorithm algorithm, 
       bool mix_correct_, int consumer_queue_size_);
 
   //prepare resource for publisher
@@ -60,10 +63,18 @@ class MediaLiveSource final : public RtcLiveAdapterSink {
   srs_error_t OnVideo(std::shared_ptr<MediaMessage>, 
                       bool from_adaptor) override;
 
+  // @param start_offset in ms relative to the live, 0 or negative, 
+  //     the consumer plays from the keyframe before it in gop cache.
   srs_error_t ConsumerDumps(MediaConsumer* consumer,
                             bool dump_seq_header,
                             bool dump_meta,
-                            bool dump_gop);
+                            bool dump_gop,
+                            int64_t start_offset = 0);
+
+  // forward the messages to the replica on another worker, the sequence 
+  // headers and gop cache are replayed to it first when publishing.
+  void AddRelay(std::shared_ptr<MediaLiveRelay> relay);
+  void RemoveRelay(MediaLiveRelay* relay);
 
   JitterAlgorithm jitter() {
     return jitter_algorithm_;
@@ -85,6 +96,7 @@ class MediaLiveSource final : public RtcLiveAdapterSink {
  private:
   std::string stream_name_;
   std::list<std::weak_ptr<MediaConsumer>> consumers_; 
+  std::vector<std::shared_ptr<MediaLiveRelay>> relays_;
 
   // The time of the packet we just got.
   int64_t last_packet_time_{0};
@@ -94,9 +106,11 @@ class MediaLiveSource final : public RtcLiveAdapterSink {
 
   JitterAlgorithm jitter_algorithm_{JitterAlgorithmZERO};
   
-  // The gop cache for client fast startup.
+  // The gop cache for client fast startup, shared with the consumers
+  // reading it by cursor.
   bool enable_gop_{false};
-  std::unique_ptr<SrsGopCache> gop_cache_;
+  int gop_duration_{0};
+  std::shared_ptr<SrsGopCache> gop_cache_;
 
   // The metadata cache.
   std::unique_ptr<MediaMetaCache> meta_;
@@ -12,6 +12,7 @@
 #include "http/http_consts.h"
 #include "media_statistics.h"
 #include "utils/media_service_utility.h"
+#include "utils/media_io_uring.h"
 
 namespace ma {
 
@@ -46,6 +47,7 @@ int MediaServerImp::Init(const Config& _config) {
     cans = config_.candidates_;
   }
 
+  wa::ThreadPool::useMpscTaskQueue(config_.mpsc_task_queue_);
   int rv = g_source_mgr_.Init(config_.workers_, cans);
 
   if (rv != wa::wa_ok) {
@@ -53,6 +55,8 @@ int MediaServerImp::Init(const Config& _config) {
     return kma_invalid_argument;
   }
 
+  MediaUringSender::Enable(config_.http_io_uring);
+
   return g_conn_mgr_.Init(config_.ioworkers_, config_.listen_addr_);
 }
 
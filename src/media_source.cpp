@@ -6,15 +6,21 @@
 
 #include "media_source.h"
 
+#include <algorithm>
+
 #include "media_server.h"
 #include "rtmp/media_req.h"
 #include "live/media_consumer.h"
 #include "live/media_live_source.h"
+#include "live/media_live_relay.h"
 #include "rtc/media_rtc_source.h"
 #include "rtc/media_rtc_live_adaptor.h"
 #include "live/media_live_rtc_adaptor.h"
 
 #include "media_source_mgr.h"
+#include "common/media_message.h"
+#include "encoder/media_codec.h"
+#include "rtc_base/time_utils.h"
 
 namespace ma {
 
@@ -44,7 +50,7 @@ void MediaSource::Open(Config& c) {
 void MediaSource::Close() {
   closed_ = true; 
   
-  worker_->task([p = shared_from_this()]() {
+  worker_.load()->task([p = shared_from_this()]() {
       p->UnactiveRtcSource();
       p->UnactiveLiveSource();
       p->UnactiveRtcAdapter();
@@ -54,19 +60,286 @@ void MediaSource::Close() {
   worker_ = nullptr;
 }
 
-std::shared_ptr<MediaConsumer> MediaSource::CreateConsumer() {
+// a relay without players for it is torn down.
+static constexpr int64_t kRelayIdle = 30000;  // ms
+
+int MediaSource::PlaceConsumer() {
+  std::lock_guard<std::mutex> guard(relay_lock_);
+  // the players of a relay start from its replay, not placed on it before.
+  int replica = 0;
+  bool replaying = false;
+  for (size_t i = 1; i < placed_.size(); ++i) {
+    auto& relay = relays_[i - 1];
+    if (!relay) {
+      continue;
+    }
+    if (!relay->ready()) {
+      replaying = true;
+      continue;
+    }
+    if (placed_[i] < placed_[replica]) {
+      replica = i;
+    }
+  }
+
+  // one created at a time, the players stay on the others until ready.
+  if (config_.relay_threshold > 0 && 
+      placed_[replica] >= config_.relay_threshold && 
+      !replaying && !closed_) {
+    AddRelay();
+  }
+
+  ++placed_[replica];
+  return replica;
+}
+
+void MediaSource::ReleaseConsumer(int replica) {
+  bool idle = false;
+  {
+    std::lock_guard<std::mutex> guard(relay_lock_);
+    if (replica < (int)placed_.size() && placed_[replica] > 0 && 
+        --placed_[replica] == 0 && replica > 0) {
+      idle_since_[replica] = rtc::TimeMillis();
+      idle = true;
+    }
+  }
+  if (idle) {
+    ScheduleRelayCheck(replica);
+  }
+}
+
+void MediaSource::ScheduleRelayCheck(int replica) {
+  wa::Worker* worker = worker_;
+  if (!worker) {
+    return;
+  }
+  worker->scheduleFromNow([weak_this = weak_from_this(), replica] {
+    if (auto p = weak_this.lock()) {
+      p->async_task([replica](std::shared_ptr<MediaSource> p) {
+        p->RemoveIdleRelay(replica);
+      }, RTC_FROM_HERE);
+    }
+  }, std::chrono::milliseconds(kRelayIdle), RTC_FROM_HERE);
+}
+
+void MediaSource::RemoveIdleRelay(int replica) {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+  std::shared_ptr<MediaLiveRelay> relay;
+  {
+    std::lock_guard<std::mutex> guard(relay_lock_);
+    if (replica >= (int)placed_.size() || !relays_[replica - 1] || 
+        placed_[replica] > 0 || 
+        rtc::TimeMillis() - idle_since_[replica] < kRelayIdle) {
+      return;
+    }
+    relay = std::move(relays_[replica - 1]);
+  }
+
+  MLOG_INFO("relay " << replica << " removed for " << 
+            req_->get_stream_url() << ", idle");
+  // the messages forwarded already are dropped with it.
+  if (live_source_) {
+    live_source_->RemoveRelay(relay.get());
+  }
+}
+
+int MediaSource::AddRelay() {
+  std::vector<wa::Worker*> used{config_.worker.get()};
+  for (auto& r : relays_) {
+    if (r) {
+      used.push_back(r->worker().get());
+    }
+  }
+
+  auto worker = g_source_mgr_.GetRelayWorker(used);
+  if (!worker) {
+    return -1;
+  }
+
+  auto relay = std::make_shared<MediaLiveRelay>(
+      req_->get_stream_url(), std::move(worker));
+  relay->Initialize(config_.gop, config_.gop_duration, 
+      config_.jitter_algorithm, config_.consumer_queue_size_);
+  relays_.emplace_back(relay);
+  placed_.push_back(0);
+  idle_since_.push_back(rtc::TimeMillis());
+  int replica = relays_.size();
+
+  MLOG_INFO("relay " << relays_.size() << " created for " << 
+            req_->get_stream_url() << ", worker:" << relay->worker()->id());
+
+  async_task([relay, replica](std::shared_ptr<MediaSource> p) {
+    if (p->live_source_) {
+      p->live_source_->AddRelay(relay);
+      relay->OnReplayed();
+      // torn down if no player comes.
+      p->ScheduleRelayCheck(replica);
+    }
+  }, RTC_FROM_HERE);
+
+  return replica;
+}
+
+MediaLiveSource* MediaSource::live_source(int replica) {
+  if (replica == 0) {
+    RTC_DCHECK_RUN_ON(&thread_check_);
+    return live_source_.get();
+  }
+  std::lock_guard<std::mutex> guard(relay_lock_);
+  return relays_[replica - 1]->source();
+}
+
+std::shared_ptr<wa::Worker> MediaSource::get_worker(int replica) {
+  std::lock_guard<std::mutex> guard(relay_lock_);
+  if (replica == 0) {
+    return config_.worker;
+  }
+  return relays_[replica - 1]->worker();
+}
+
+int MediaSource::Players() {
+  std::lock_guard<std::mutex> guard(relay_lock_);
+  return placed_[0];
+}
+
+void MediaSource::AddCost(int64_t us) {
+  cost_.fetch_add(us, std::memory_order_relaxed);
+}
+
+int64_t MediaSource::TakeCost() {
+  return cost_.exchange(0, std::memory_order_relaxed);
+}
+
+bool MediaSource::Migrating() {
+  std::lock_guard<std::mutex> guard(migrate_lock_);
+  return migrate_to_ != nullptr;
+}
+
+int64_t MediaSource::MigratedTime() {
+  std::lock_guard<std::mutex> guard(migrate_lock_);
+  return migrated_time_;
+}
+
+// wait for the keyframe at most, then move anyway, for the pure audio.
+static constexpr int64_t kMigrateWaitKeyframe = 10000;  // ms
+
+void MediaSource::Migrate(std::shared_ptr<wa::Worker> to) {
+  {
+    std::lock_guard<std::mutex> guard(migrate_lock_);
+    if (closed_ || migrate_to_ || to.get() == worker_) {
+      return;
+    }
+    migrate_to_ = std::move(to);
+    migrate_time_ = rtc::TimeMillis();
+  }
+
+  // nothing to wait if not publishing.
+  async_task([](std::shared_ptr<MediaSource> p) {
+    if (p->active_) {
+      return;
+    }
+    std::lock_guard<std::mutex> guard(p->migrate_lock_);
+    if (p->migrate_to_ && !p->migrating_) {
+      p->StartMigrate();
+    }
+  }, RTC_FROM_HERE);
+}
+
+void MediaSource::StartMigrate() {
+  migrating_ = true;
+  async_task([](std::shared_ptr<MediaSource> p) {
+    p->MigrateOut();
+  }, RTC_FROM_HERE);
+}
+
+bool MediaSource::Movable() {
+  if (closed_ || rtc_publisher_in_ || rtc_adapter_ || live_adapter_) {
+    return false;
+  }
+  if (active_ && !isRtmp(publiser_type_)) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(relay_lock_);
+  return std::all_of(relays_.begin(), relays_.end(), 
+                     [](auto& r) { return !r; });
+}
+
+void MediaSource::MigrateOut() {
+  RTC_DCHECK_RUN_ON(&thread_check_);
+  std::lock_guard<std::mutex> guard(migrate_lock_);
+  auto to = migrate_to_;
+
+  if (!Movable()) {
+    MLOG_WARN("migrate canceled, " << req_->get_stream_url());
+    migrate_to_ = nullptr;
+    migrated_time_ = rtc::TimeMillis();
+    migrating_ = false;
+    for (auto& msg : migrate_msgs_) {
+      DeliverMessage(std::move(msg));
+    }
+    migrate_msgs_.clear();
+    return;
+  }
+
+  MLOG_INFO("migrate " << req_->get_stream_url() << " from worker:" << 
+            worker_.load()->id() << " to worker:" << to->id());
+
+  // the flv players follow it, in this worker at last.
+  signal_migrate_(to);
+
+  {
+    std::lock_guard<std::mutex> guard(relay_lock_);
+    config_.worker = to;
+  }
+  worker_ = to.get();
+  rtc_source_->Open(config_.rtc_api, worker_);
+
+  thread_check_.Detach();
+  live_source_->thread_check_.Detach();
+
+  // the tasks posted from now on run after it in the new worker.
+  async_task([](std::shared_ptr<MediaSource> p) {
+    p->MigrateIn();
+  }, RTC_FROM_HERE);
+}
+
+void MediaSource::MigrateIn() {
   RTC_DCHECK_RUN_ON(&thread_check_);
-  return live_source_->CreateConsumer();
+  std::vector<std::shared_ptr<MediaMessage>> msgs;
+  {
+    std::lock_guard<std::mutex> guard(migrate_lock_);
+    msgs.swap(migrate_msgs_);
+    migrate_to_ = nullptr;
+    migrated_time_ = rtc::TimeMillis();
+    migrating_ = false;
+  }
+
+  // continue from the keyframe, the later ones are queued after it.
+  for (auto& msg : msgs) {
+    if (!live_source_) {
+      break;
+    }
+    if (msg->is_audio()) {
+      live_source_->OnAudio(std::move(msg), false);
+    } else if (msg->is_video()) {
+      live_source_->OnVideo(std::move(msg), false);
+    }
+  }
+}
+
+std::shared_ptr<MediaConsumer> MediaSource::CreateConsumer(int replica) {
+  return live_source(replica)->CreateConsumer();
 }
 
 srs_error_t MediaSource::ConsumerDumps(
     MediaConsumer* consumer, 
     bool dump_seq_header, 
     bool dump_meta, 
-    bool dump_gop) {
-  RTC_DCHECK_RUN_ON(&thread_check_);
-  return live_source_->ConsumerDumps(
-      consumer, dump_seq_header, dump_meta, dump_gop);
+    bool dump_gop,
+    int64_t start_offset,
+    int replica) {
+  return live_source(replica)->ConsumerDumps(
+      consumer, dump_seq_header, dump_meta, dump_gop, start_offset);
 }
 
 srs_error_t MediaSource::Publish(std::string_view sdp, 
@@ -130,7 +403,7 @@ void MediaSource::OnPublish(PublisherType t) {
     rtc_publisher_in_ = true;
   }
   
-  if (worker_->IsCurrent()) {
+  if (worker_.load()->IsCurrent()) {
     // attach checker thread
     RTC_DCHECK_RUN_ON(&thread_check_);
     func(shared_from_this());
@@ -167,7 +440,7 @@ void MediaSource::OnUnpublish() {
     rtc_publisher_in_ = false;
   }
 
-  if (worker_->IsCurrent()) {
+  if (worker_.load()->IsCurrent()) {
     RTC_DCHECK_RUN_ON(&thread_check_);
     func(shared_from_this());
   } else {
@@ -176,8 +449,8 @@ void MediaSource::OnUnpublish() {
 }
 
 JitterAlgorithm MediaSource::jitter() {
-  RTC_DCHECK_RUN_ON(&thread_check_);
-  return live_source_->jitter();
+  // the same for all the replicas.
+  return config_.jitter_algorithm;
 }
 
 void MediaSource::OnRtcFirstPacket() {
@@ -243,7 +516,7 @@ void MediaSource::ActiveRtcSource() {
   }
   
   rtc_source_.reset(new MediaRtcSource(req_->get_stream_url()));
-  rtc_source_->Open(config_.rtc_api, worker_);
+  rtc_source_->Open(config_.rtc_api, worker_.load());
   rtc_source_->signal_rtc_first_suber_.connect(
                    this, &MediaSource::OnRtcFirstSubscriber);
   rtc_source_->signal_rtc_nobody_.connect(
@@ -277,8 +550,9 @@ void MediaSource::ActiveLiveSource() {
   }
   
   live_source_.reset(new MediaLiveSource(req_->get_stream_url()));
-  live_source_->Initialize(config_.gop, config_.jitter_algorithm,
-      config_.mix_correct_, config_.consumer_queue_size_);
+  live_source_->Initialize(config_.gop, config_.gop_duration,
+      config_.jitter_algorithm, config_.mix_correct_, 
+      config_.consumer_queue_size_);
   
   live_source_->signal_live_no_consumer_.connect(
                     this, &MediaSource::OnRtmpNoConsumer);
@@ -311,7 +585,7 @@ void MediaSource::ActiveRtcAdapter() {
   }
 
   rtc_adapter_ = std::make_shared<MediaLiveRtcAdaptor>(req_->get_stream_url());
-  srs_error_t err = rtc_adapter_->Open(worker_, live_source_.get(), 
+  srs_error_t err = rtc_adapter_->Open(worker_.load(), live_source_.get(), 
       rtc_source_.get(), config_.enable_rtmp2rtc_debug_);
 
   if (err != nullptr) {
@@ -359,6 +633,29 @@ void MediaSource::UnactiveRtmpAdapter() {
 }
 
 void MediaSource::OnMessage(std::shared_ptr<MediaMessage> msg) {
+  std::lock_guard<std::mutex> guard(migrate_lock_);
+  if (migrate_to_) {
+    // move at the keyframe, the new worker continues from it.
+    if (!migrating_) {
+      bool keyframe = msg->is_video() && SrsFlvVideo::keyframe(
+          msg->payload_->GetFirstMsgReadPtr(), msg->size_) &&
+          !SrsFlvVideo::sh(msg->payload_->GetFirstMsgReadPtr(), msg->size_);
+      if (keyframe || 
+          rtc::TimeMillis() - migrate_time_ >= kMigrateWaitKeyframe) {
+        StartMigrate();
+      }
+    }
+
+    if (migrating_) {
+      migrate_msgs_.emplace_back(std::move(msg));
+      return;
+    }
+  }
+
+  DeliverMessage(std::move(msg));
+}
+
+void MediaSource::DeliverMessage(std::shared_ptr<MediaMessage> msg) {
   async_task([msg](std::shared_ptr<MediaSource> p) {
     if (p->live_source_) {
       if (msg->is_audio()) {
@@ -384,9 +681,17 @@ void MediaSource::OnFrame(std::shared_ptr<owt_base::Frame> msg) {
 void MediaSource::async_task(
     std::function<void(std::shared_ptr<MediaSource>)> f, 
     const rtc::Location& l) {
-  worker_->task([weak_this = weak_from_this(), f] {
+  worker_.load()->task([weak_this = weak_from_this(), f, l] {
     if (auto this_ptr = weak_this.lock()) {
+      // posted before the source moved, follow it.
+      wa::Worker* worker = this_ptr->worker_;
+      if (worker && !worker->IsCurrent()) {
+        this_ptr->async_task(f, l);
+        return;
+      }
+      int64_t start = rtc::TimeMicros();
       f(this_ptr);
+      this_ptr->AddCost(rtc::TimeMicros() - start);
     }
   }, l);
 }
@@ -11,6 +11,7 @@
 #include <atomic>
 #include <mutex>
 #include <string_view>
+#include <vector>
 
 #include "utils/sigslot.h"
 #include "h/rtc_stack_api.h"
@@ -30,6 +31,7 @@ class IHttpResponseWriter;
 class MediaLiveRtcAdaptor;
 class MediaRtcLiveAdaptor;
 class MediaMessage;
+class MediaLiveRelay;
 
 enum PublisherType {
   eUnknown,
@@ -55,6 +57,7 @@ class MediaSource final : public sigslot::has_slots<>,
   struct Config {
     std::shared_ptr<wa::Worker> worker;
     bool gop{false};
+    int gop_duration{0};  // ms
     JitterAlgorithm jitter_algorithm{JitterAlgorithmZERO};
     wa::RtcApi* rtc_api{nullptr};
     bool enable_rtc2rtmp_{true};
@@ -63,6 +66,7 @@ class MediaSource final : public sigslot::has_slots<>,
     bool enable_rtmp2rtc_debug_{false};
     int consumer_queue_size_{30000};
     bool mix_correct_{false};
+    int relay_threshold{0};  // players per replica, 0 to disable
   };
 
   MediaSource(std::shared_ptr<MediaRequest>);
@@ -76,17 +80,46 @@ class MediaSource final : public sigslot::has_slots<>,
   // carefull call this function may cause crash
   void Close();
 
-  std::shared_ptr<MediaConsumer> CreateConsumer();
+  // Place a new player on the least loaded replica of the live source, 
+  // a relay replica is created on another worker when all the replicas 
+  // serve relay_threshold players, and used once it replayed the sequence
+  // headers and the gop cache, thread safe.
+  // @return the replica, 0 for the origin live source.
+  int PlaceConsumer();
+  // The player placed on the replica is gone, the relay without players
+  // for kRelayIdle is torn down, thread safe.
+  void ReleaseConsumer(int replica);
+
+  // called in the worker of the replica.
+  std::shared_ptr<MediaConsumer> CreateConsumer(int replica = 0);
   srs_error_t ConsumerDumps(MediaConsumer* consumer, 
                             bool dump_seq_header, 
                             bool dump_meta, 
-                            bool dump_gop);
+                            bool dump_gop,
+                            int64_t start_offset = 0,
+                            int replica = 0);
 
   JitterAlgorithm jitter();
   
-  inline std::shared_ptr<wa::Worker> get_worker() {
-    return config_.worker;
-  }
+  std::shared_ptr<wa::Worker> get_worker(int replica = 0);
+
+  // Move the source and its flv players to another worker, from the next
+  // keyframe if publishing. Only the rtmp stream without rtc peers and
+  // relays moves, thread safe.
+  void Migrate(std::shared_ptr<wa::Worker> to);
+  // The players placed on the origin, thread safe.
+  int Players();
+  // The time taken by the source and its flv players on the origin worker,
+  // in us, thread safe.
+  void AddCost(int64_t us);
+  // the cost added since the last call.
+  int64_t TakeCost();
+  // moving to another worker, thread safe.
+  bool Migrating();
+  // when it moved or canceled moving last, 0 if never, in ms, thread safe.
+  int64_t MigratedTime();
+  // Emitted in the old worker when moving, the slots move to the new one.
+  sigslot::signal1<std::shared_ptr<wa::Worker>> signal_migrate_;
 
   inline std::shared_ptr<MediaRequest> GetRequest() {
     return req_;
@@ -140,14 +173,49 @@ class MediaSource final : public sigslot::has_slots<>,
   void ActiveRtmpAdapter();
   void UnactiveRtmpAdapter();
 
+  void DeliverMessage(std::shared_ptr<MediaMessage> msg);
+
+  // called with migrate_lock_.
+  void StartMigrate();
+  // called in the old worker, then in the new one.
+  void MigrateOut();
+  void MigrateIn();
+  bool Movable();
+
+  // create a relay replica, called with relay_lock_.
+  // @return the replica, -1 if no worker left.
+  int AddRelay();
+  // check the relay after kRelayIdle, and remove it in the origin worker
+  // if no player is placed on it meanwhile.
+  void ScheduleRelayCheck(int replica);
+  void RemoveIdleRelay(int replica);
+  MediaLiveSource* live_source(int replica);
+
   void async_task(std::function<void(std::shared_ptr<MediaSource>)> f, 
                   const rtc::Location& l);
  private:
   Config config_;
-  wa::Worker* worker_{nullptr};
+  std::atomic<wa::Worker*> worker_{nullptr};
 
   std::shared_ptr<MediaRequest> req_;
   std::unique_ptr<MediaLiveSource> live_source_;
+
+  // the relay replicas, the replica i + 1, null once torn down, not to
+  // renumber the others.
+  std::mutex relay_lock_;
+  std::vector<std::shared_ptr<MediaLiveRelay>> relays_;
+  // the players placed on each replica, the origin first.
+  std::vector<int> placed_{0};
+  // when the players of each replica dropped to none, in ms.
+  std::vector<int64_t> idle_since_{0};
+
+  // the messages held in moving to migrate_to_ from the keyframe.
+  std::mutex migrate_lock_;
+  std::shared_ptr<wa::Worker> migrate_to_;
+  int64_t migrate_time_{0};
+  int64_t migrated_time_{0};
+  bool migrating_{false};
+  std::vector<std::shared_ptr<MediaMessage>> migrate_msgs_;
   std::unique_ptr<MediaRtcLiveAdaptor> live_adapter_;
   
   std::unique_ptr<MediaRtcSource> rtc_source_;
@@ -161,6 +229,8 @@ class MediaSource final : public sigslot::has_slots<>,
 
   std::atomic<bool> closed_{true};
 
+  std::atomic<int64_t> cost_{0};  // us
+
   webrtc::SequenceChecker thread_check_;
 };
 
@@ -2,25 +2,36 @@
 #include "rtmp/media_req.h"
 #include "media_statistics.h"
 #include "media_server.h"
+#include "rtc_base/time_utils.h"
 
 namespace ma {
 
+MDEFINE_LOGGER(MediaSourceMgr, "ma.source.mgr");
+
 static std::shared_ptr<wa::ThreadPool>  workers_;
 
 int MediaSourceMgr::Init(unsigned int num, 
     const std::vector<std::string>& candidates) {
   workers_ = std::make_shared<wa::ThreadPool>(num);
   workers_->start("live");
+  if (g_server_.config_.rebalance_sec_ > 0) {
+    workers_->getWorkers().front()->scheduleEvery([this]() {
+      return Rebalance();
+    }, std::chrono::seconds(g_server_.config_.rebalance_sec_), RTC_FROM_HERE);
+  }
   rtc_api_ = std::move(wa::AgentFactory().create_agent());
-  return rtc_api_->Open(num, candidates, "");
+  std::string service_addr;
+  if (g_server_.config_.rtc_single_port) {
+    service_addr = "udp://0.0.0.0:" + 
+        std::to_string(g_server_.config_.stun_port);
+  }
+  return rtc_api_->Open(num, candidates, service_addr);
 }
 
 void MediaSourceMgr::Close() {
-  {
-    std::lock_guard<std::mutex> guard(source_lock_);
-    for(auto& i : sources_)
-      i.second->Close();
-  }
+  sources_.ForEach([](auto&, auto& source) {
+    source->Close();
+  });
 
   rtc_api_->Close();
   workers_->close();
@@ -30,22 +41,22 @@ void MediaSourceMgr::Close() {
 std::shared_ptr<MediaSource>
 MediaSourceMgr::FetchOrCreateSource(MediaSource::Config& cfg,
                                     std::shared_ptr<MediaRequest> req) {
+  std::string streamName = req->get_stream_url();
   std::shared_ptr<MediaSource> ms;
+  if (sources_.Find(streamName, &ms)) {
+    return ms;
+  }
 
-  {
-    std::lock_guard<std::mutex> guard(source_lock_);
-    auto found = sources_.find(req->get_stream_url());
-    if(found != sources_.end()) {
-      return found->second;
-    }
-
-    std::string streamName = req->get_stream_url();
-    ms = std::make_shared<MediaSource>(req);
-    sources_[streamName] = ms;
+  // created out of the lock, and dropped if created by others meanwhile.
+  auto created = std::make_shared<MediaSource>(req);
+  ms = sources_.Emplace(streamName, created);
+  if (ms != created) {
+    return ms;
   }
   
   cfg.worker = GetWorker();
   cfg.gop = g_server_.config_.enable_gop_;
+  cfg.gop_duration = g_server_.config_.gop_duration_;
   cfg.jitter_algorithm = g_server_.config_.jitter_algo_;
   if (!cfg.rtc_api) {
     cfg.rtc_api = rtc_api_.get();
@@ -56,6 +67,7 @@ MediaSourceMgr::FetchOrCreateSource(MediaSource::Config& cfg,
   cfg.enable_rtmp2rtc_debug_ = g_server_.config_.enable_rtmp2rtc_debug_;
   cfg.consumer_queue_size_ = g_server_.config_.consumer_queue_size_;
   cfg.mix_correct_ = g_server_.config_.mix_correct_;
+  cfg.relay_threshold = g_server_.config_.relay_threshold_;
 
   ms->Open(cfg);
   Stat().OnStream(std::move(req));
@@ -64,11 +76,9 @@ MediaSourceMgr::FetchOrCreateSource(MediaSource::Config& cfg,
 
 std::optional<std::shared_ptr<MediaSource>>
 MediaSourceMgr::FetchSource(std::shared_ptr<MediaRequest> req) {
-
-  std::lock_guard<std::mutex> guard(source_lock_);  
-  auto found = sources_.find(req->get_stream_url());
-  if (found != sources_.end()) {
-    return found->second;
+  std::shared_ptr<MediaSource> source;
+  if (sources_.Find(req->get_stream_url(), &source)) {
+    return source;
   }
 
   return std::nullopt;
@@ -76,15 +86,9 @@ MediaSourceMgr::FetchSource(std::shared_ptr<MediaRequest> req) {
 
 void MediaSourceMgr::RemoveSource(std::shared_ptr<MediaRequest> req) {
   std::shared_ptr<MediaSource> source;
-  {
-    std::lock_guard<std::mutex> guard(source_lock_);
-    auto found = sources_.find(req->get_stream_url());
-    if (found == sources_.end()) {
-      assert(false);
-      return;
-    }
-    source = found->second;
-    sources_.erase(found);
+  if (!sources_.Erase(req->get_stream_url(), &source)) {
+    assert(false);
+    return;
   }
 
   source->Close();
@@ -95,6 +99,89 @@ std::shared_ptr<wa::Worker> MediaSourceMgr::GetWorker() {
   return std::move(workers_->getLessUsedWorker());
 }
 
+std::shared_ptr<wa::Worker> MediaSourceMgr::GetRelayWorker(
+    const std::vector<wa::Worker*>& used) {
+  return workers_->getLessUsedWorker(used);
+}
+
+// rebalance when the busiest worker is above it, and the idlest one is 
+// below it by the gap, in permille of busy time, for kRebalanceIntervals
+// intervals in a row, not for a burst.
+static constexpr int kRebalanceBusy = 700;
+static constexpr int kRebalanceGap = 300;
+static constexpr int kRebalanceIntervals = 2;
+// a source moved stays for the intervals, its cost sampled on the new one.
+static constexpr int kRebalanceCooldown = 5;
+
+bool MediaSourceMgr::Rebalance() {
+  if (!workers_) {
+    return false;
+  }
+
+  std::shared_ptr<wa::Worker> busiest, idlest;
+  int busiest_load = 0, idlest_load = 0;
+  for (auto& w : workers_->getWorkers()) {
+    int busy = w->load().busy;
+    if (!busiest || busy > busiest_load) {
+      busiest = w;
+      busiest_load = busy;
+    }
+    if (!idlest || busy < idlest_load) {
+      idlest = w;
+      idlest_load = busy;
+    }
+  }
+
+  // the busy time moved at most, half of the gap, not to make the idlest
+  // one the busiest.
+  int64_t interval = g_server_.config_.rebalance_sec_ * 1000;  // ms
+  int64_t budget = (int64_t)(busiest_load - idlest_load) * interval / 2;  // us
+  int64_t now = rtc::TimeMillis();
+
+  // the costiest one within the budget, a hot stream is spread by the
+  // relays instead. The costs are taken on every interval.
+  std::shared_ptr<MediaSource> picked;
+  int64_t picked_cost = 0;
+  bool moving = false;
+  sources_.ForEach([&](auto&, auto& source) {
+    int64_t cost = source->TakeCost();
+    if (source->Migrating()) {
+      moving = true;
+      return;
+    }
+    if (source->get_worker() != busiest || cost <= 0 || cost > budget) {
+      return;
+    }
+    int64_t moved = source->MigratedTime();
+    if (moved && now - moved < kRebalanceCooldown * interval) {
+      return;
+    }
+    if (!picked || cost > picked_cost) {
+      picked = source;
+      picked_cost = cost;
+    }
+  });
+
+  // the load is sampled again after the one moving is done.
+  if (moving || busiest_load < kRebalanceBusy || 
+      busiest_load - idlest_load < kRebalanceGap) {
+    unbalanced_ = 0;
+    return true;
+  }
+
+  if (++unbalanced_ < kRebalanceIntervals || !picked) {
+    return true;
+  }
+
+  MLOG_INFO("rebalance " << picked->GetRequest()->get_stream_url() << 
+            ", cost:" << picked_cost << "us, worker:" << busiest->id() << 
+            " busy:" << busiest_load << " to worker:" << idlest->id() << 
+            " busy:" << idlest_load);
+  picked->Migrate(std::move(idlest));
+  unbalanced_ = 0;
+  return true;
+}
+
 MediaSourceMgr g_source_mgr_;
 
 } //namespace ma
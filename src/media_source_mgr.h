@@ -8,18 +8,19 @@
 #define __NEW_MEDIA_SOURCE_MGR_H__
 
 #include <string>
-#include <map>
-#include <mutex>
 #include <memory>
 #include <optional>
 
 #include "h/rtc_stack_api.h"
 #include "utils/Worker.h"
+#include "utils/media_sharded_map.h"
 #include "media_source.h"
 
 namespace ma {
 
 class MediaSourceMgr {
+  MDECLARE_LOGGER();
+
  public:
   int Init(unsigned int, const std::vector<std::string>&);
   void Close();
@@ -33,12 +34,22 @@ class MediaSourceMgr {
 
   // MediaSource wiil be destroyed on nobody.
   void RemoveSource(std::shared_ptr<MediaRequest> req);
+
+  // the worker for the replica of a hot source, excluding the workers 
+  // serving it already, nullptr if none left.
+  std::shared_ptr<wa::Worker> GetRelayWorker(
+      const std::vector<wa::Worker*>& used);
  private:
   std::shared_ptr<wa::Worker> GetWorker();
+  // move a source from the busiest worker to the idlest one, by the cost
+  // measured.
+  bool Rebalance();
  private:
-  std::mutex source_lock_;
-  std::map<std::string, std::shared_ptr<MediaSource>> sources_;
+  // looked up by every player and publisher without lock.
+  ReadMostlyMap<std::string, std::shared_ptr<MediaSource>> sources_;
   std::unique_ptr<wa::RtcApi> rtc_api_;
+  // the rebalance intervals unbalanced in a row, in the first worker.
+  int unbalanced_{0};
 };
 
 extern MediaSourceMgr g_source_mgr_;
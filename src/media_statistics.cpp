@@ -50,6 +50,21 @@ void MediaStatistics::ClientInfo::Dump(json::Object& obj) {
   char buf[256];
   snprintf(buf, 256, "%d:%d:%d", hours, min, sec);
   obj["alive"] = std::string(buf);
+
+  if (type == TRtmpPlay) {
+    obj["delay"] = (int)delivery.delay_ms;
+    json::Object dropped;
+    dropped["disposable"] = (int)delivery.dropped_disposable;
+    dropped["gops"] = (int)delivery.dropped_gops;
+    dropped["gop_frames"] = (int)delivery.dropped_gop_frames;
+    obj["dropped"] = dropped;
+    obj["send_calls"] = (int)delivery.send_calls_per_sec;
+    json::Object queue;
+    queue["queued_bytes"] = (double)delivery.queued_bytes;
+    queue["sent_bytes"] = (double)delivery.sent_bytes;
+    queue["high_watermark_ms"] = (double)delivery.high_watermark_ms;
+    obj["send_queue"] = queue;
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////////////StreamInfo
@@ -179,6 +194,16 @@ void MediaStatistics::OnDisconnect(const std::string& id) {
   pStream->players.erase(id);
 }
 
+void MediaStatistics::OnClientDelivery(const std::string& id, 
+                                       const ClientDelivery& delivery) {
+  std::lock_guard<std::mutex> guard(client_lock_);
+  auto found = clients_.find(id);
+  if (found == clients_.end())
+    return ;
+
+  found->second->delivery = delivery;
+}
+
 bool MediaStatistics::DumpClients(json::Object& obj, int start, int count) {
   std::vector<std::shared_ptr<ClientInfo>> clients_copy;
   {
@@ -37,6 +37,19 @@ class MediaStatistics final {
                 std::shared_ptr<MediaRequest>, 
                 ClientType);
   void OnDisconnect(const std::string& client_id);
+  // the delivery status of the player, to find the ones falling behind.
+  struct ClientDelivery {
+    int64_t delay_ms{0};
+    int64_t dropped_disposable{0};
+    int64_t dropped_gops{0};
+    int64_t dropped_gop_frames{0};
+    int64_t send_calls_per_sec{0};
+    // the send queue of the connection.
+    int64_t queued_bytes{0};
+    int64_t sent_bytes{0};
+    int64_t high_watermark_ms{0};
+  };
+  void OnClientDelivery(const std::string& client_id, const ClientDelivery&);
   bool DumpClients(json::Object& objs, int start, int count);
   bool DumpStreams(json::Object& objs, int start, int count);
 
@@ -48,6 +61,7 @@ class MediaStatistics final {
     ClientType type;
     std::shared_ptr<MediaRequest> req;
     time_t created;
+    ClientDelivery delivery;
     void Dump(json::Object&);
   };
 
@@ -171,7 +171,7 @@ void MediaRtmpPublisherImp::OnVideo(
   auto msg = MediaMessage::create(&header, (const char*)data);
 
   if (debug_) {
-    std::vector<std::shared_ptr<MediaMessage>> msgs{msg};
+    std::vector<MediaPacket> msgs{{msg, msg->timestamp_}};
     srs_error_t ret = flv_encoder_->write_tags(msgs);
 
     if (ret != srs_success) {
@@ -192,7 +192,7 @@ void MediaRtmpPublisherImp::OnAudio(
   auto msg = MediaMessage::create(&header, (const char*)data);
 
   if (debug_) {
-    std::vector<std::shared_ptr<MediaMessage>> msgs{msg};
+    std::vector<MediaPacket> msgs{{msg, msg->timestamp_}};
     srs_error_t ret = flv_encoder_->write_tags(msgs);
     if (ret != srs_success) {
       MLOG_ERROR("write audio tags faild code:" << srs_error_code(ret) << 
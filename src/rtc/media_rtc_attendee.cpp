@@ -89,7 +89,6 @@ srs_error_t MediaRtcAttendeeBase::Open(wa::RtcApi* rtc,
 
 srs_error_t MediaRtcAttendeeBase::Responese(int code, const std::string& sdp) {
   srs_error_t err = srs_success;
-  writer_->header()->set("Connection", "Close");
 
   json::Object jroot;
   jroot["code"] = code;
@@ -275,6 +274,7 @@ srs_error_t MediaRtcSubscriber::Open_i(
   t.stream_name_ = stream_id;
 
   FillTrack(sdp, t.tracks_, false);
+  t.forward_rtp_ = g_server_.config_.rtc_forward_rtp;
 
   t.call_back_ = shared_from_this();
   async_callback_ = true;
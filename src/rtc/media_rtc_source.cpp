@@ -66,6 +66,8 @@ MediaRtcSource::~MediaRtcSource() {
 void MediaRtcSource::Open(wa::RtcApi* rtc, wa::Worker* worker) {
   rtc_ = rtc;
   worker_ = worker;
+  // reopened in the new worker if the source moved.
+  thread_check_.Detach();
 }
 
 void MediaRtcSource::Close() {
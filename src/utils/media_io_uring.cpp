@@ -0,0 +1,284 @@
+//
+// Copyright (c) 2021- anjisuan783
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "utils/media_io_uring.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <memory>
+
+#if defined(__linux__) && defined(__NR_io_uring_setup) && \
+    __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define MA_HAVE_IO_URING 1
+#endif
+
+#include "common/media_log.h"
+
+namespace ma {
+
+static log4cxx::LoggerPtr logger = log4cxx::Logger::getLogger("ma.utils");
+
+std::atomic<bool> MediaUringSender::enabled_{false};
+
+#ifdef MA_HAVE_IO_URING
+
+namespace {
+
+int io_uring_setup(unsigned entries, io_uring_params* p) {
+  return (int)::syscall(__NR_io_uring_setup, entries, p);
+}
+
+int io_uring_enter(int fd, unsigned to_submit,
+                   unsigned min_complete, unsigned flags) {
+  return (int)::syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                        flags, nullptr, 0);
+}
+
+int io_uring_register(int fd, unsigned opcode, void* arg, unsigned nr_args) {
+  return (int)::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+// The ring is shared with the kernel.
+inline unsigned load_acquire(const unsigned* p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+inline void store_release(unsigned* p, unsigned v) {
+  __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+thread_local std::unique_ptr<MediaUringSender> t_sender;
+// the ring of the thread failed, never try again.
+thread_local bool t_failed{false};
+
+} //namespace
+
+MediaUringSender::~MediaUringSender() {
+  if (sqes_ptr_) {
+    ::munmap(sqes_ptr_, sqes_size_);
+  }
+  if (cq_ptr_ && cq_ptr_ != sq_ptr_) {
+    ::munmap(cq_ptr_, cq_size_);
+  }
+  if (sq_ptr_) {
+    ::munmap(sq_ptr_, sq_size_);
+  }
+  if (ring_fd_ != -1) {
+    ::close(ring_fd_);
+  }
+}
+
+bool MediaUringSender::Init() {
+  io_uring_params p;
+  memset(&p, 0, sizeof(p));
+  ring_fd_ = io_uring_setup(kEntries, &p);
+  if (ring_fd_ < 0) {
+    MLOG_CWARN("io_uring_setup failed, errno:%d", errno);
+    return false;
+  }
+
+  sq_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+  bool single = (p.features & IORING_FEAT_SINGLE_MMAP);
+  if (single) {
+    sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+  }
+
+  sq_ptr_ = ::mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ptr_ == MAP_FAILED) {
+    sq_ptr_ = nullptr;
+    return false;
+  }
+
+  if (single) {
+    cq_ptr_ = sq_ptr_;
+  } else {
+    cq_ptr_ = ::mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ptr_ == MAP_FAILED) {
+      cq_ptr_ = nullptr;
+      return false;
+    }
+  }
+
+  sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+  sqes_ptr_ = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes_ptr_ == MAP_FAILED) {
+    sqes_ptr_ = nullptr;
+    return false;
+  }
+
+  char* sq = (char*)sq_ptr_;
+  sq_head_ = (unsigned*)(sq + p.sq_off.head);
+  sq_tail_ = (unsigned*)(sq + p.sq_off.tail);
+  sq_mask_ = *(unsigned*)(sq + p.sq_off.ring_mask);
+  sq_array_ = (unsigned*)(sq + p.sq_off.array);
+
+  char* cq = (char*)cq_ptr_;
+  cq_head_ = (unsigned*)(cq + p.cq_off.head);
+  cq_tail_ = (unsigned*)(cq + p.cq_off.tail);
+  cq_mask_ = *(unsigned*)(cq + p.cq_off.ring_mask);
+  cqes_ = cq + p.cq_off.cqes;
+
+  // sendmsg is supported since 5.3, the probe since 5.6.
+  constexpr unsigned kProbeOps = 256;
+  std::vector<char> buf(
+      sizeof(io_uring_probe) + kProbeOps * sizeof(io_uring_probe_op), 0);
+  io_uring_probe* probe = (io_uring_probe*)buf.data();
+  if (io_uring_register(ring_fd_, IORING_REGISTER_PROBE,
+                        probe, kProbeOps) < 0 ||
+      probe->last_op < IORING_OP_SENDMSG ||
+      !(probe->ops[IORING_OP_SENDMSG].flags & IO_URING_OP_SUPPORTED)) {
+    MLOG_CWARN("io_uring sendmsg not supported");
+    return false;
+  }
+  return true;
+}
+
+bool MediaUringSender::Enable(bool on) {
+  if (on) {
+    // try it on the current thread.
+    MediaUringSender sender;
+    on = sender.Init();
+  }
+  enabled_ = on;
+  MLOG_CINFO("io_uring sender %s", on ? "enabled" : "disabled");
+  return on;
+}
+
+MediaUringSender* MediaUringSender::Current() {
+  if (!enabled_.load(std::memory_order_relaxed) || t_failed) {
+    return nullptr;
+  }
+
+  if (!t_sender) {
+    t_sender = std::make_unique<MediaUringSender>();
+    if (!t_sender->Init()) {
+      t_sender.reset();
+      t_failed = true;
+      return nullptr;
+    }
+  }
+  return t_sender.get();
+}
+
+int MediaUringSender::Prepare(int fd, const iovec* iov, int iovcnt) {
+  if (count_ == kEntries) {
+    return -1;
+  }
+
+  msghdr& msg = msgs_[count_];
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = const_cast<iovec*>(iov);
+  msg.msg_iovlen = iovcnt;
+
+  unsigned tail = *sq_tail_ + count_;
+  unsigned index = tail & sq_mask_;
+  io_uring_sqe* sqe = (io_uring_sqe*)sqes_ptr_ + index;
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_SENDMSG;
+  sqe->fd = fd;
+  sqe->addr = (uint64_t)(uintptr_t)&msg;
+  sqe->len = 1;
+  sqe->msg_flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+  sqe->user_data = count_;
+  sq_array_[index] = index;
+
+  results_[count_] = -ECANCELED;
+  return count_++;
+}
+
+unsigned MediaUringSender::Reap() {
+  unsigned head = *cq_head_;
+  unsigned tail = load_acquire(cq_tail_);
+  unsigned reaped = 0;
+  for (; head != tail; ++head, ++reaped) {
+    const io_uring_cqe* cqe = (const io_uring_cqe*)cqes_ + (head & cq_mask_);
+    if (cqe->user_data < (uint64_t)count_) {
+      results_[cqe->user_data] = cqe->res;
+    }
+  }
+  store_release(cq_head_, head);
+  return reaped;
+}
+
+bool MediaUringSender::Submit() {
+  if (count_ == 0) {
+    return true;
+  }
+
+  store_release(sq_tail_, *sq_tail_ + count_);
+
+  unsigned to_submit = count_;
+  unsigned reaped = 0;
+  while (reaped < (unsigned)count_) {
+    int ret = io_uring_enter(ring_fd_, to_submit, count_ - reaped,
+                             IORING_ENTER_GETEVENTS);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret < 0) {
+      int err = errno;
+      MLOG_CERROR("io_uring_enter failed, errno:%d", err);
+      // drop the sends not taken by the kernel, and never use it again.
+      store_release(sq_tail_, load_acquire(sq_head_));
+      reaped += Reap();
+      for (int i = 0; i < count_; ++i) {
+        if (results_[i] == -ECANCELED) {
+          results_[i] = -err;
+        }
+      }
+      t_failed = true;
+      return false;
+    }
+    to_submit -= std::min<unsigned>(ret, to_submit);
+    reaped += Reap();
+  }
+  return true;
+}
+
+#else
+
+MediaUringSender::~MediaUringSender() = default;
+
+bool MediaUringSender::Init() {
+  return false;
+}
+
+bool MediaUringSender::Enable(bool on) {
+  if (on) {
+    MLOG_CWARN("io_uring not supported");
+  }
+  return false;
+}
+
+MediaUringSender* MediaUringSender::Current() {
+  return nullptr;
+}
+
+int MediaUringSender::Prepare(int, const iovec*, int) {
+  return -1;
+}
+
+unsigned MediaUringSender::Reap() {
+  return 0;
+}
+
+bool MediaUringSender::Submit() {
+  return count_ == 0;
+}
+
+#endif
+
+} //namespace ma
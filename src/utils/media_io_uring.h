@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2021- anjisuan783
+//
+// SPDX-License-Identifier: MIT
+//
+
+#ifndef __MEDIA_IO_URING_H__
+#define __MEDIA_IO_URING_H__
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <atomic>
+#include <vector>
+
+#include "common/media_performance.h"
+
+namespace ma {
+
+// Sends the messages of many sockets by one io_uring_enter, instead of one
+// writev for each. One sender for each io thread, by raw system calls, so
+// liburing isn't required. The sends never wait in the kernel, a socket
+// full returns -EAGAIN like the nonblocking writev.
+class MediaUringSender final {
+ public:
+  MediaUringSender() = default;
+  ~MediaUringSender();
+
+  // Called on startup, before the io threads send. Returns whether it's
+  // enabled, false if the kernel doesn't support io_uring sendmsg.
+  static bool Enable(bool on);
+
+  // The sender of the current thread, null if not enabled.
+  static MediaUringSender* Current();
+
+  // Queue one message to |fd|, the iovecs are kept by the caller until
+  // Submit returns. Returns the index of its result, -1 if full.
+  int Prepare(int fd, const iovec* iov, int iovcnt);
+
+  // Send the messages queued and wait for them all. Returns false if
+  // io_uring fails, the results are -errno then.
+  bool Submit();
+
+  // The bytes sent by the message of |index|, or -errno.
+  int Result(int index) const {
+    return results_[index];
+  }
+
+  int Prepared() const {
+    return count_;
+  }
+
+  void Reset() {
+    count_ = 0;
+  }
+
+  static constexpr int kEntries = SRS_PERF_IO_URING_ENTRIES;
+ private:
+  bool Init();
+  // Returns the completions reaped.
+  unsigned Reap();
+
+ private:
+  int ring_fd_{-1};
+
+  void* sq_ptr_{nullptr};
+  size_t sq_size_{0};
+  void* cq_ptr_{nullptr};
+  size_t cq_size_{0};
+  void* sqes_ptr_{nullptr};
+  size_t sqes_size_{0};
+
+  unsigned* sq_head_{nullptr};
+  unsigned* sq_tail_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned* sq_array_{nullptr};
+  unsigned* cq_head_{nullptr};
+  unsigned* cq_tail_{nullptr};
+  unsigned cq_mask_{0};
+  void* cqes_{nullptr};
+
+  msghdr msgs_[kEntries];
+  int results_[kEntries];
+  int count_{0};
+
+  static std::atomic<bool> enabled_;
+};
+
+} //namespace ma
+
+#endif //!__MEDIA_IO_URING_H__
@@ -0,0 +1,219 @@
+//
+// Copyright (c) 2021- anjisuan783
+//
+// SPDX-License-Identifier: MIT
+//
+
+#ifndef __MEDIA_SHARDED_MAP_H__
+#define __MEDIA_SHARDED_MAP_H__
+
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "common/media_performance.h"
+
+namespace ma {
+
+// Mix the hash, the hash of a pointer is the address, aligned and sparse.
+inline size_t media_shard_of(size_t hash, size_t shards) {
+  return ((uint64_t)hash * 0x9E3779B97F4A7C15ULL >> 32) % shards;
+}
+
+// The map split to shards by the hash of the key, each shard with its own
+// lock, for the keys written as often as read, like the connections.
+template <typename K, typename V, typename H = std::hash<K>,
+          size_t N = SRS_PERF_REGISTRY_SHARDS>
+class ShardedMap final {
+ public:
+  bool Find(const K& key, V* value) {
+    Shard& s = shard(key);
+    std::lock_guard<std::mutex> guard(s.lock);
+    auto found = s.map.find(key);
+    if (found == s.map.end()) {
+      return false;
+    }
+    if (value) {
+      *value = found->second;
+    }
+    return true;
+  }
+
+  // Returns false if the key exists, the value is kept.
+  bool Insert(const K& key, V value) {
+    Shard& s = shard(key);
+    std::lock_guard<std::mutex> guard(s.lock);
+    return s.map.emplace(key, std::move(value)).second;
+  }
+
+  bool Erase(const K& key, V* value = nullptr) {
+    Shard& s = shard(key);
+    std::lock_guard<std::mutex> guard(s.lock);
+    auto found = s.map.find(key);
+    if (found == s.map.end()) {
+      return false;
+    }
+    if (value) {
+      *value = std::move(found->second);
+    }
+    s.map.erase(found);
+    return true;
+  }
+
+  // Remove all, returns the values removed.
+  std::vector<V> Clear() {
+    std::vector<V> values;
+    for (auto& s : shards_) {
+      std::lock_guard<std::mutex> guard(s.lock);
+      for (auto& i : s.map) {
+        values.emplace_back(std::move(i.second));
+      }
+      s.map.clear();
+    }
+    return values;
+  }
+
+ private:
+  struct alignas(64) Shard {
+    std::mutex lock;
+    std::unordered_map<K, V, H> map;
+  };
+
+  Shard& shard(const K& key) {
+    return shards_[media_shard_of(H()(key), N)];
+  }
+
+  Shard shards_[N];
+};
+
+// The map read far more than written, like the streams looked up by every
+// player. Each shard is an immutable snapshot, the writers of the shard copy
+// it, replace it in turn and bump its version. A reader keeps the snapshot
+// it loaded last in its thread, and loads it again only when the version
+// changed, so a lookup reads the version and nothing else shared: no lock,
+// no reference count. The std::atomic_load of a shared_ptr takes a lock of
+// a global pool in libstdc++, it is left to the lookups after a change.
+// A thread releases its old snapshot, and so the values erased in it, on
+// its next lookup of the shard.
+template <typename K, typename V, typename H = std::hash<K>,
+          size_t N = SRS_PERF_REGISTRY_SHARDS>
+class ReadMostlyMap final {
+  using Map = std::unordered_map<K, V, H>;
+ public:
+  bool Find(const K& key, V* value) const {
+    const Map& map = *snapshot(shard(key));
+    auto found = map.find(key);
+    if (found == map.end()) {
+      return false;
+    }
+    if (value) {
+      *value = found->second;
+    }
+    return true;
+  }
+
+  // Insert |value| if the key not exists, returns the value of the key, so
+  // the value is created out of the lock and dropped if lost the race.
+  V Emplace(const K& key, V value) {
+    Shard& s = shard(key);
+    std::lock_guard<std::mutex> guard(s.lock);
+    auto found = s.map->find(key);
+    if (found != s.map->end()) {
+      return found->second;
+    }
+    auto map = std::make_shared<Map>(*s.map);
+    map->emplace(key, value);
+    Replace(s, std::move(map));
+    return value;
+  }
+
+  bool Erase(const K& key, V* value = nullptr) {
+    Shard& s = shard(key);
+    std::lock_guard<std::mutex> guard(s.lock);
+    auto found = s.map->find(key);
+    if (found == s.map->end()) {
+      return false;
+    }
+    if (value) {
+      *value = found->second;
+    }
+    auto map = std::make_shared<Map>(*s.map);
+    map->erase(key);
+    Replace(s, std::move(map));
+    return true;
+  }
+
+  // Visit the snapshots without lock, the changes after them are not seen.
+  void ForEach(const std::function<void(const K&, const V&)>& f) const {
+    for (auto& s : shards_) {
+      // held, |f| may look up the map and replace the one of the thread.
+      std::shared_ptr<const Map> map = snapshot(s);
+      for (auto& i : *map) {
+        f(i.first, i.second);
+      }
+    }
+  }
+
+ private:
+  struct alignas(64) Shard {
+    // serializes the writers only.
+    std::mutex lock;
+    std::shared_ptr<const Map> map{std::make_shared<const Map>()};
+    // bumped after the map replaced.
+    std::atomic<uint64_t> version{0};
+  };
+
+  // the snapshot of a shard in a thread, and the version it was loaded at.
+  struct Cached {
+    uint64_t version{0};
+    std::shared_ptr<const Map> map;
+  };
+
+  // called with the lock of |s|.
+  static void Replace(Shard& s, std::shared_ptr<const Map> map) {
+    std::atomic_store(&s.map, std::move(map));
+    s.version.fetch_add(1, std::memory_order_release);
+  }
+
+  // The snapshot of |s| kept by the thread, loaded again if changed. The
+  // version read before the load, a change meanwhile is loaded again next.
+  const std::shared_ptr<const Map>& snapshot(const Shard& s) const {
+    static thread_local std::vector<Cached> cached;
+    size_t i = id_ * N + (&s - shards_);
+    if (cached.size() <= i) {
+      cached.resize(i + 1);
+    }
+    Cached& c = cached[i];
+    uint64_t version = s.version.load(std::memory_order_acquire);
+    if (!c.map || c.version != version) {
+      c.map = std::atomic_load(&s.map);
+      c.version = version;
+    }
+    return c.map;
+  }
+
+  static size_t next_id() {
+    static std::atomic<size_t> ids{0};
+    return ids.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  Shard& shard(const K& key) {
+    return shards_[media_shard_of(H()(key), N)];
+  }
+
+  const Shard& shard(const K& key) const {
+    return shards_[media_shard_of(H()(key), N)];
+  }
+
+  Shard shards_[N];
+  // the index of the map in the snapshots of a thread.
+  const size_t id_{next_id()};
+};
+
+} //namespace ma
+
+#endif //!__MEDIA_SHARDED_MAP_H__
@@ -0,0 +1,103 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "gmock/gmock.h"
+
+#include "common/media_kernel_error.h"
+#include "http/http_protocal_impl.h"
+
+using ma::HttpMessageParser;
+using ma::ISrsHttpMessage;
+
+namespace {
+
+const char kRequest[] =
+    "GET /live/stream.flv?token=abc HTTP/1.1\r\n"
+    "Host: 127.0.0.1:8080\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) Chrome/90.0\r\n"
+    "Accept: */*\r\n"
+    "Accept-Encoding: identity\r\n"
+    "Accept-Language: en-US,en;q=0.9\r\n"
+    "Origin: http://127.0.0.1:8080\r\n"
+    "Referer: http://127.0.0.1:8080/players/\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+// Parse the request |requests| times, in one read or split at |split|,
+// and returns the requests per second.
+double parse(HttpMessageParser& parser, int requests, size_t split) {
+  std::string_view request(kRequest, sizeof(kRequest) - 1);
+  std::shared_ptr<ISrsHttpMessage> msg;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < requests; ++i) {
+    msg = nullptr;
+    srs_error_t err = srs_success;
+    if (split) {
+      err = parser.parse_message(request.substr(0, split), msg);
+      if (err == srs_success && !msg) {
+        err = parser.parse_message(request.substr(split), msg);
+      }
+    } else {
+      err = parser.parse_message(request, msg);
+    }
+    if (err != srs_success || !msg) {
+      ADD_FAILURE() << "request " << i << " not parsed";
+      delete err;
+      return 0;
+    }
+  }
+  double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+  EXPECT_EQ(msg->path(), "/live/stream.flv");
+  EXPECT_EQ(msg->query_get("token"), "abc");
+  EXPECT_EQ(msg->header().get("Connection"), "keep-alive");
+  return requests / elapsed;
+}
+
+}  // namespace
+
+// the requests parsed per second, the messages released to the pool of
+// the parsing thread and reused.
+TEST(HttpMessageParser, benchmark) {
+  const int requests = 200000;
+  HttpMessageParser parser;
+  parser.initialize(ma::HTTP_REQUEST);
+  parser.set_jsonp(false);
+
+  // warm up, the pool filled.
+  parse(parser, 1000, 0);
+
+  std::cout << "one read: " << (int64_t)parse(parser, requests, 0) <<
+      " requests/s" << std::endl;
+  std::cout << "two reads: " << (int64_t)parse(parser, requests, 64) <<
+      " requests/s" << std::endl;
+}
+
+// the messages released by the other thread go back to the parsing one.
+TEST(HttpMessageParser, release_on_other_thread) {
+  // by a thread of its own, the pool empty.
+  std::thread([] {
+    HttpMessageParser parser;
+    parser.initialize(ma::HTTP_REQUEST);
+    parser.set_jsonp(false);
+
+    std::string_view request(kRequest, sizeof(kRequest) - 1);
+    std::shared_ptr<ISrsHttpMessage> held;
+    ASSERT_TRUE(parser.parse_message(request, held) == srs_success);
+    ASSERT_NE(held, nullptr);
+    ISrsHttpMessage* made = held.get();
+
+    std::thread([&held] { held = nullptr; }).join();
+
+    std::shared_ptr<ISrsHttpMessage> again;
+    ASSERT_TRUE(parser.parse_message(request, again) == srs_success);
+    ASSERT_NE(again, nullptr);
+    EXPECT_EQ(again.get(), made);
+    EXPECT_EQ(again->path(), "/live/stream.flv");
+  }).join();
+}
@@ -0,0 +1,125 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "rtc_base/async_packet_socket.h"
+#include "rtc_base/thread.h"
+#include "common/media_kernel_error.h"
+#include "http/http_protocal_impl.h"
+
+using ma::AsyncSokcetWrapper;
+using ma::HttpResponseWriterProxy;
+
+namespace {
+
+// Takes all the bytes, counts the sends.
+class NullSocket : public rtc::AsyncPacketSocket {
+ public:
+  rtc::SocketAddress GetLocalAddress() const override {
+    return rtc::SocketAddress();
+  }
+  rtc::SocketAddress GetRemoteAddress() const override {
+    return rtc::SocketAddress();
+  }
+  int Send(const void*, size_t cb, const rtc::PacketOptions&) override {
+    ++send_calls;
+    bytes += cb;
+    return (int)cb;
+  }
+  int SendTo(const void*, size_t cb, const rtc::SocketAddress&,
+             const rtc::PacketOptions&) override {
+    return (int)cb;
+  }
+  int SendV(const iovec* iov, int iovcnt,
+            const rtc::PacketOptions&) override {
+    ++send_calls;
+    size_t len = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+      len += iov[i].iov_len;
+    }
+    bytes += len;
+    return (int)len;
+  }
+  int Close() override {
+    return 0;
+  }
+  State GetState() const override {
+    return STATE_CONNECTED;
+  }
+  int GetOption(rtc::Socket::Option, int*) override {
+    return -1;
+  }
+  int SetOption(rtc::Socket::Option, int) override {
+    return -1;
+  }
+  int GetError() const override {
+    return 0;
+  }
+  void SetError(int) override { }
+
+  int64_t send_calls{0};
+  int64_t bytes{0};
+};
+
+}  // namespace
+
+// the writev of a chunked response on the io thread, the iovecs of the
+// caller sent by one writev with the http and chunk headers, not copied,
+// in batches of 10, 100 and 1000 iovecs of 188 bytes, like the ts packets.
+TEST(HttpResponseWriterProxy, writev_benchmark) {
+  const int total_iovs = 1000000;
+  std::vector<char> payload(188, 'x');
+
+  rtc::Thread* thread = rtc::ThreadManager::Instance()->WrapCurrentThread();
+  for (int batch : {10, 100, 1000}) {
+    auto conn = new NullSocket;
+    auto socket = std::make_shared<AsyncSokcetWrapper>(conn);
+    socket->Open(false, thread);
+
+    auto writer = std::make_shared<HttpResponseWriterProxy>(socket, true);
+    writer->open();
+    writer->header()->set_content_type("video/mp2t");
+    writer->write_header(SRS_CONSTS_HTTP_OK);
+
+    std::vector<iovec> iovs(batch,
+        iovec{payload.data(), payload.size()});
+    int writes = total_iovs / batch;
+    int64_t body = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < writes; ++i) {
+      ssize_t nwrite = 0;
+      srs_error_t err = writer->writev(iovs.data(), batch, &nwrite);
+      if (err != srs_success) {
+        ADD_FAILURE() << "writev " << i << " failed";
+        delete err;
+        break;
+      }
+      body += nwrite;
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(body, (int64_t)writes * batch * payload.size());
+    // the chunk headers and trailers besides the body.
+    EXPECT_GT(conn->bytes, body);
+    // one send for each writev, until the iovecs exceed the limit of one.
+    EXPECT_EQ(conn->send_calls,
+        (int64_t)writes * ((batch + 3 + ma::SRS_PERF_WRITEV_IOVS - 1) /
+                           ma::SRS_PERF_WRITEV_IOVS));
+
+    std::cout << batch << " iovecs: " <<
+        (int64_t)(writes / elapsed) << " writev/s, " <<
+        (int64_t)(body / elapsed / 1024 / 1024) << " MB/s, " <<
+        (double)conn->send_calls / writes << " sends per writev" << std::endl;
+
+    srs_error_t err = writer->final_request();
+    EXPECT_TRUE(err == srs_success);
+    delete err;
+    writer = nullptr;
+    socket = nullptr;
+  }
+  rtc::ThreadManager::Instance()->UnwrapCurrentThread();
+}
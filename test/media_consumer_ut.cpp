@@ -0,0 +1,213 @@
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "common/media_io.h"
+#include "common/media_message.h"
+#include "encoder/media_flv_encoder.h"
+#include "live/media_consumer.h"
+#include "live/media_gop_cache.h"
+#include "rtmp/media_rtmp_const.h"
+
+using ma::MediaConsumer;
+using ma::MediaMessage;
+using ma::MediaPacket;
+using ma::MessageHeader;
+using ma::SrsFlvStreamEncoder;
+
+// the allocations of the whole binary, counted to check the fan out.
+static std::atomic<int64_t> g_allocs{0};
+
+void* operator new(size_t size) {
+  ++g_allocs;
+  if (void* p = ::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  ::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  ::free(p);
+}
+
+namespace {
+
+// the h264 frames, keyframe or not.
+std::shared_ptr<MediaMessage> video(int64_t time, bool keyframe) {
+  char payload[1000] = {0};
+  payload[0] = keyframe ? 0x17 : 0x27;
+  payload[1] = 0x01;
+  MessageHeader header;
+  header.initialize_video(sizeof(payload), time, 1);
+  return MediaMessage::create(&header, payload);
+}
+
+std::shared_ptr<MediaMessage> audio(int64_t time) {
+  char payload[200] = {0};
+  payload[0] = (char)0xaf;
+  payload[1] = 0x01;
+  MessageHeader header;
+  header.initialize_audio(sizeof(payload), time, 1);
+  return MediaMessage::create(&header, payload);
+}
+
+std::shared_ptr<MediaMessage> metadata(int64_t time) {
+  char payload[100] = {0};
+  MessageHeader header;
+  header.payload_length = sizeof(payload);
+  header.message_type = RTMP_MSG_AMF0DataMessage;
+  header.timestamp = time;
+  return MediaMessage::create(&header, payload);
+}
+
+// Takes the flv tags of a viewer like the socket, counts the bytes.
+class NullWriter : public ma::SrsFileWriter {
+ public:
+  srs_error_t write(void*, size_t count, ssize_t* pnwrite) override {
+    bytes += count;
+    if (pnwrite) {
+      *pnwrite = count;
+    }
+    return srs_success;
+  }
+  srs_error_t write(ma::MessageChain* msg, ssize_t* pnwrite) override {
+    return write(nullptr, msg->GetChainedLength(), pnwrite);
+  }
+  srs_error_t writev(const iovec* iov, int iovcnt, 
+                     ssize_t* pnwrite) override {
+    size_t len = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+      len += iov[i].iov_len;
+    }
+    return write(nullptr, len, pnwrite);
+  }
+
+  int64_t bytes{0};
+};
+
+}  // namespace
+
+// the live messages fanned out to the viewers, shared, never copied, and
+// the queues and the arrays fetched to are reused once warm. The flv tags
+// are muxed for each viewer, the timestamps corrected by the default
+// jitter, so the tag headers of its own in the scratch of its encoder.
+TEST(MediaConsumer, zero_allocation_per_viewer) {
+  const int viewers = 1000;
+  const int packets = 1000;
+  std::vector<std::unique_ptr<MediaConsumer>> consumers;
+  std::vector<std::unique_ptr<NullWriter>> writers;
+  std::vector<std::unique_ptr<SrsFlvStreamEncoder>> encoders;
+  for (int i = 0; i < viewers; ++i) {
+    consumers.emplace_back(std::make_unique<MediaConsumer>(nullptr));
+    consumers.back()->set_queue_size(30 * SRS_UTIME_SECONDS);
+    writers.emplace_back(std::make_unique<NullWriter>());
+    encoders.emplace_back(std::make_unique<SrsFlvStreamEncoder>());
+    srs_error_t err = encoders.back()->initialize(writers.back().get(), 
+                                                  nullptr);
+    ASSERT_TRUE(err == srs_success);
+  }
+
+  // the messages made and the flv tags encoded by the publisher, once per
+  // packet, not counted.
+  std::vector<std::shared_ptr<MediaMessage>> made;
+  for (int i = 0; i < 64 + packets; ++i) {
+    made.emplace_back((i % 3) ? audio(1000 + i * 10) : 
+                                video(1000 + i * 10, false));
+    SrsFlvStreamEncoder::encode_tag(made.back().get());
+  }
+
+  std::vector<MediaPacket> msgs;
+  msgs.reserve(64);
+  auto fan_out = [&](int from, int count) {
+    for (int i = from; i < from + count; ++i) {
+      for (auto& c : consumers) {
+        c->enqueue(made[i], ma::JitterAlgorithmZERO);
+      }
+      // fetched and written by the viewers every 16 packets, as the sink 
+      // notified.
+      if (i % 16 == 15) {
+        for (int v = 0; v < viewers; ++v) {
+          int count = 0;
+          consumers[v]->fetch_packets(64, msgs, count);
+          EXPECT_EQ(count, 16);
+          EXPECT_NE(msgs[0].timestamp_, msgs[0].msg_->timestamp_);
+          srs_error_t err = encoders[v]->write_tags(msgs);
+          EXPECT_TRUE(err == srs_success);
+          msgs.clear();
+        }
+      }
+    }
+  };
+
+  // warm up, the queues grown.
+  fan_out(0, 64);
+
+  int64_t allocs = g_allocs;
+  auto start = std::chrono::steady_clock::now();
+  fan_out(64, packets);
+  double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  allocs = g_allocs - allocs;
+
+  std::cout << viewers << " viewers, " <<
+      (int64_t)(packets * viewers / elapsed) << " packets/s delivered, " <<
+      (double)allocs / packets / viewers << " allocations per packet per viewer" <<
+      std::endl;
+  EXPECT_EQ(allocs, 0);
+
+  // the flv header, and each tag fetched with its header and previous tag
+  // size.
+  int64_t tags = 0;
+  for (int i = 0; i < (64 + packets) / 16 * 16; ++i) {
+    tags += 11 + made[i]->size_ + 4;
+  }
+  EXPECT_EQ(writers[0]->bytes, 13 + tags);
+}
+
+// the metadata not kept by the gop cache, enqueued while the viewer reads
+// the cache by the cursor, is fetched in place, not after the cache.
+TEST(MediaConsumer, cursor_keeps_order) {
+  auto cache = std::make_shared<ma::SrsGopCache>();
+  cache->set(true);
+  for (int i = 0; i < 10; ++i) {
+    cache->cache(video(i * 40, i == 0));
+  }
+
+  MediaConsumer consumer(nullptr);
+  consumer.set_queue_size(30 * SRS_UTIME_SECONDS);
+  consumer.set_cursor(cache, cache->head(), ma::JitterAlgorithmOFF);
+
+  auto meta = metadata(400);
+  consumer.enqueue(meta, ma::JitterAlgorithmOFF);
+  auto last = video(400, false);
+  cache->cache(last);
+  consumer.enqueue(last, ma::JitterAlgorithmOFF);
+
+  std::vector<MediaPacket> msgs;
+  int count = 0;
+  consumer.fetch_packets(64, msgs, count);
+  ASSERT_EQ(count, 12);
+  EXPECT_EQ(msgs[10].msg_, meta);
+  EXPECT_EQ(msgs[11].msg_, last);
+
+  // caught up, queued again.
+  auto next = video(440, false);
+  cache->cache(next);
+  consumer.enqueue(next, ma::JitterAlgorithmOFF);
+  msgs.clear();
+  count = 0;
+  consumer.fetch_packets(64, msgs, count);
+  ASSERT_EQ(count, 1);
+  EXPECT_EQ(msgs[0].msg_, next);
+}
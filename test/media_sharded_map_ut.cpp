@@ -0,0 +1,128 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "utils/media_sharded_map.h"
+
+using ma::ReadMostlyMap;
+
+namespace {
+
+// the map before the snapshots kept by the threads, std::atomic_load of
+// the shared_ptr on every lookup.
+class LegacyMap {
+  using Map = std::unordered_map<std::string, std::shared_ptr<int>>;
+ public:
+  void Emplace(const std::string& key, std::shared_ptr<int> value) {
+    auto map = std::make_shared<Map>(*map_);
+    map->emplace(key, std::move(value));
+    std::atomic_store(&map_, std::shared_ptr<const Map>(std::move(map)));
+  }
+
+  bool Find(const std::string& key, std::shared_ptr<int>* value) const {
+    auto map = std::atomic_load(&map_);
+    auto found = map->find(key);
+    if (found == map->end()) {
+      return false;
+    }
+    *value = found->second;
+    return true;
+  }
+
+ private:
+  std::shared_ptr<const Map> map_{std::make_shared<const Map>()};
+};
+
+// the lookups per second of |threads| threads looking up the streams.
+template <typename M>
+double lookups(M& map, const std::vector<std::string>& keys, int threads) {
+  const int per_thread = 1000000;
+  std::atomic<int> found{0};
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> readers;
+  for (int t = 0; t < threads; ++t) {
+    readers.emplace_back([&map, &keys, &found, t] {
+      std::shared_ptr<int> value;
+      int n = 0;
+      for (int i = 0; i < per_thread; ++i) {
+        n += map.Find(keys[(i + t) % keys.size()], &value);
+      }
+      found += n;
+    });
+  }
+  for (auto& r : readers) {
+    r.join();
+  }
+  double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(found, per_thread * threads);
+  return per_thread * threads / elapsed;
+}
+
+}  // namespace
+
+// the changes of a writer seen by the snapshots of the readers.
+TEST(ReadMostlyMap, find_after_change) {
+  ReadMostlyMap<std::string, std::shared_ptr<int>> map;
+  std::shared_ptr<int> value;
+  EXPECT_FALSE(map.Find("live/a", &value));
+
+  // loaded by this thread, changed by another.
+  std::thread([&map] {
+    map.Emplace("live/a", std::make_shared<int>(1));
+  }).join();
+  ASSERT_TRUE(map.Find("live/a", &value));
+  EXPECT_EQ(*value, 1);
+
+  std::thread([&map] {
+    EXPECT_TRUE(map.Erase("live/a"));
+  }).join();
+  EXPECT_FALSE(map.Find("live/a", &value));
+
+  // the values of another map are not seen.
+  ReadMostlyMap<std::string, std::shared_ptr<int>> other;
+  other.Emplace("live/a", std::make_shared<int>(2));
+  EXPECT_FALSE(map.Find("live/a", &value));
+  ASSERT_TRUE(other.Find("live/a", &value));
+  EXPECT_EQ(*value, 2);
+
+  // looked up and changed while visited.
+  for (int i = 0; i < 100; ++i) {
+    map.Emplace("live/" + std::to_string(i), std::make_shared<int>(i));
+  }
+  int visited = 0;
+  map.ForEach([&](auto& key, auto&) {
+    std::shared_ptr<int> found;
+    EXPECT_TRUE(map.Find(key, &found));
+    map.Erase(key);
+    ++visited;
+  });
+  EXPECT_EQ(visited, 100);
+  EXPECT_FALSE(map.Find("live/0", &value));
+}
+
+// the lookups of the streams by the io threads and the workers, compared
+// with std::atomic_load of the shared_ptr each time.
+TEST(ReadMostlyMap, lookup_benchmark) {
+  std::vector<std::string> keys;
+  LegacyMap legacy;
+  ReadMostlyMap<std::string, std::shared_ptr<int>> map;
+  for (int i = 0; i < 1000; ++i) {
+    keys.emplace_back("live/stream" + std::to_string(i));
+    legacy.Emplace(keys.back(), std::make_shared<int>(i));
+    map.Emplace(keys.back(), std::make_shared<int>(i));
+  }
+
+  for (int threads : {1, 4, 16}) {
+    std::cout << threads << " threads, atomic_load: " <<
+        (int64_t)lookups(legacy, keys, threads) << " lookups/s, snapshots: " <<
+        (int64_t)lookups(map, keys, threads) << " lookups/s" << std::endl;
+  }
+}